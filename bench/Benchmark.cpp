@@ -0,0 +1,329 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <thread>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace bench {
+
+namespace {
+
+double now() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double cpuNow() { return double(clock()) / CLOCKS_PER_SEC; }
+
+vector<unique_ptr<Benchmark>>& registry() {
+    static vector<unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+struct Settings {
+    string filter = ".";
+    double minTime = 0.5;
+    int repetitions = 1;
+    bool list = false;
+    bool jsonOnStdout = false;
+    string out;
+};
+
+// One reported line: a measured run or an aggregate of the repetitions
+struct Run {
+    string name, runName, aggregate;   // aggregate empty for measured runs
+    int repetitionIndex;
+    int64_t iterations;
+    double realNs, cpuNs;              // per iteration
+    double itemsPerSecond;             // 0 if not set
+    string label;
+};
+
+bool readFlag(const string& arg, const string& flag, string& value) {
+    string prefix = "--" + flag + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+Settings parseFlags(int argc, char** argv) {
+    Settings s;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i], value;
+        if (readFlag(arg, "benchmark_filter", value)) s.filter = value;
+        else if (readFlag(arg, "benchmark_min_time", value)) s.minTime = atof(value.c_str());   // "0.5" or "0.5s"
+        else if (readFlag(arg, "benchmark_repetitions", value)) s.repetitions = max(1, atoi(value.c_str()));
+        else if (readFlag(arg, "benchmark_format", value)) s.jsonOnStdout = value == "json";
+        else if (readFlag(arg, "benchmark_out", value)) s.out = value;
+        else if (readFlag(arg, "benchmark_out_format", value)) {
+            if (value != "json") throw invalid_argument("Only JSON output files are supported");
+        }
+        else if (arg == "--benchmark_list_tests" || arg == "--benchmark_list_tests=true") s.list = true;
+        else throw invalid_argument("Unknown flag: " + arg);
+    }
+    return s;
+}
+
+string runName(const Benchmark& b, const vector<int64_t>& args) {
+    string name = b.name();
+    for (int64_t a : args) name += "/" + to_string(a);
+    return name;
+}
+
+// Run with more iterations until the loop takes minTime, as Google Benchmark does
+State measure(const Benchmark& b, const vector<int64_t>& args, double minTime) {
+    int64_t iterations = 1;
+    while (true) {
+        State state(iterations, args);
+        b.function()(state);
+        double elapsed = state.realSeconds();
+        if (elapsed >= minTime || iterations >= 1000000000) return state;
+
+        double factor = elapsed > 0 ? 1.4 * minTime / elapsed : 10.0;
+        factor = min(10.0, max(factor, 1.0 + 1e-9));
+        int64_t next = int64_t(ceil(double(iterations) * factor));
+        iterations = max(iterations + 1, next);
+    }
+}
+
+Run toRun(const string& name, int repetition, const State& s) {
+    Run r;
+    r.name = r.runName = name;
+    r.repetitionIndex = repetition;
+    r.iterations = s.iterations();
+    r.realNs = s.realSeconds() * 1e9 / double(s.iterations());
+    r.cpuNs = s.cpuSeconds() * 1e9 / double(s.iterations());
+    r.itemsPerSecond = (s.items() > 0 && s.realSeconds() > 0) ? double(s.items()) / s.realSeconds() : 0;
+    r.label = s.labelText();
+    return r;
+}
+
+vector<Run> aggregates(const vector<Run>& runs) {
+    vector<Run> out;
+    size_t n = runs.size();
+    auto make = [&](const string& kind, double (*stat)(vector<double>)) {
+        Run a = runs[0];
+        a.name = a.runName + "_" + kind;
+        a.aggregate = kind;
+        vector<double> real, cpu, items;
+        for (const auto& r : runs) {
+            real.push_back(r.realNs);
+            cpu.push_back(r.cpuNs);
+            items.push_back(r.itemsPerSecond);
+        }
+        a.realNs = stat(real);
+        a.cpuNs = stat(cpu);
+        a.itemsPerSecond = stat(items);
+        a.iterations = int64_t(n);
+        out.push_back(a);
+    };
+    make("mean", [](vector<double> v) {
+        double s = 0;
+        for (double x : v) s += x;
+        return s / double(v.size());
+    });
+    make("median", [](vector<double> v) {
+        sort(v.begin(), v.end());
+        size_t m = v.size() / 2;
+        return v.size() % 2 ? v[m] : (v[m - 1] + v[m]) / 2;
+    });
+    make("stddev", [](vector<double> v) {
+        double s = 0, ss = 0;
+        for (double x : v) s += x;
+        double mean = s / double(v.size());
+        for (double x : v) ss += (x - mean) * (x - mean);
+        return v.size() > 1 ? sqrt(ss / double(v.size() - 1)) : 0.0;
+    });
+    return out;
+}
+
+string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+string number(double v) {
+    char buffer[32];
+    snprintf(buffer, sizeof buffer, "%.17g", v);
+    return buffer;
+}
+
+void writeJson(ostream& os, const vector<Run>& runs, int repetitions, const char* executable) {
+    char date[64];
+    time_t t = time(nullptr);
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S%z", localtime(&t));
+    char host[256] = "unknown";
+#ifndef _WIN32
+    gethostname(host, sizeof host - 1);
+#endif
+
+    os << "{\n  \"context\": {\n"
+       << "    \"date\": \"" << date << "\",\n"
+       << "    \"host_name\": \"" << jsonEscape(host) << "\",\n"
+       << "    \"executable\": \"" << jsonEscape(executable) << "\",\n"
+       << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+       << "    \"library_build_type\": \"release\"\n"
+#else
+       << "    \"library_build_type\": \"debug\"\n"
+#endif
+       << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const Run& r = runs[i];
+        os << (i ? ",\n" : "\n") << "    {\n"
+           << "      \"name\": \"" << jsonEscape(r.name) << "\",\n"
+           << "      \"run_name\": \"" << jsonEscape(r.runName) << "\",\n"
+           << "      \"run_type\": \"" << (r.aggregate.empty() ? "iteration" : "aggregate") << "\",\n"
+           << "      \"repetitions\": " << repetitions << ",\n";
+        if (r.aggregate.empty()) os << "      \"repetition_index\": " << r.repetitionIndex << ",\n";
+        else os << "      \"aggregate_name\": \"" << r.aggregate << "\",\n";
+        os << "      \"threads\": 1,\n"
+           << "      \"iterations\": " << r.iterations << ",\n"
+           << "      \"real_time\": " << number(r.realNs) << ",\n"
+           << "      \"cpu_time\": " << number(r.cpuNs) << ",\n"
+           << "      \"time_unit\": \"ns\"";
+        if (r.itemsPerSecond > 0) os << ",\n      \"items_per_second\": " << number(r.itemsPerSecond);
+        if (!r.label.empty()) os << ",\n      \"label\": \"" << jsonEscape(r.label) << "\"";
+        os << "\n    }";
+    }
+    os << "\n  ]\n}\n";
+}
+
+void printConsoleHeader(size_t width) {
+    string rule(width + 60, '-');
+    printf("%s\n%-*s %15s %15s %12s\n%s\n", rule.c_str(), int(width), "Benchmark", "Time", "CPU",
+           "Iterations", rule.c_str());
+}
+
+void printConsole(const Run& r, size_t width) {
+    printf("%-*s %12.0f ns %12.0f ns %12lld", int(width), r.name.c_str(), r.realNs, r.cpuNs,
+           (long long)r.iterations);
+    if (r.itemsPerSecond > 0) printf(" items_per_second=%.4g/s", r.itemsPerSecond);
+    if (!r.label.empty()) printf(" %s", r.label.c_str());
+    printf("\n");
+    fflush(stdout);
+}
+
+}
+
+State::State(int64_t iterations, const vector<int64_t>& values)
+    : maxIterations(iterations), args(values), itemsProcessed(0),
+      realStart(0), cpuStart(0), realTime(0), cpuTime(0) {}
+
+State::Iterator State::begin() {
+    realStart = now();
+    cpuStart = cpuNow();
+    return Iterator{maxIterations, this};
+}
+
+void State::stopTimer() {
+    realTime = now() - realStart;
+    cpuTime = cpuNow() - cpuStart;
+}
+
+Benchmark::Benchmark(const string& name, Function function)
+    : benchName(name), fn(function), multiplier(8) {}
+
+Benchmark* Benchmark::arg(int64_t value) {
+    sets.push_back({value});
+    return this;
+}
+
+Benchmark* Benchmark::args(const vector<int64_t>& values) {
+    sets.push_back(values);
+    return this;
+}
+
+Benchmark* Benchmark::range(int64_t lo, int64_t hi) {
+    for (int64_t v = lo; v < hi; v *= multiplier) sets.push_back({v});
+    sets.push_back({hi});
+    return this;
+}
+
+Benchmark* Benchmark::rangeMultiplier(int m) {
+    multiplier = max(2, m);
+    return this;
+}
+
+Benchmark* registerBenchmark(const string& name, Function fn) {
+    registry().emplace_back(new Benchmark(name, fn));
+    return registry().back().get();
+}
+
+void useValue(const volatile void*) {}
+
+int run(int argc, char** argv) {
+    Settings settings;
+    try {
+        settings = parseFlags(argc, argv);
+    } catch (const exception& e) {
+        cerr << e.what() << "\n";
+        return 2;
+    }
+    regex filter(settings.filter);
+
+    // every (benchmark, argument set) pair that passes the filter
+    vector<pair<const Benchmark*, vector<int64_t>>> selected;
+    size_t width = 10;
+    for (const auto& b : registry()) {
+        vector<vector<int64_t>> sets = b->argSets();
+        if (sets.empty()) sets.push_back({});
+        for (const auto& args : sets) {
+            string name = runName(*b, args);
+            if (!regex_search(name, filter)) continue;
+            selected.push_back({b.get(), args});
+            width = max(width, name.size() + (settings.repetitions > 1 ? 7 : 0));
+        }
+    }
+
+    if (settings.list) {
+        for (const auto& s : selected) cout << runName(*s.first, s.second) << "\n";
+        return 0;
+    }
+
+    if (!settings.jsonOnStdout) printConsoleHeader(width);
+    vector<Run> all;
+    for (const auto& s : selected) {
+        string name = runName(*s.first, s.second);
+        vector<Run> runs;
+        for (int rep = 0; rep < settings.repetitions; ++rep) {
+            runs.push_back(toRun(name, rep, measure(*s.first, s.second, settings.minTime)));
+            if (!settings.jsonOnStdout) printConsole(runs.back(), width);
+        }
+        all.insert(all.end(), runs.begin(), runs.end());
+        if (settings.repetitions > 1) {
+            for (const Run& a : aggregates(runs)) {
+                all.push_back(a);
+                if (!settings.jsonOnStdout) printConsole(a, width);
+            }
+        }
+    }
+
+    if (settings.jsonOnStdout) writeJson(cout, all, settings.repetitions, argv[0]);
+    if (!settings.out.empty()) {
+        ofstream file(settings.out);
+        if (!file) {
+            cerr << "Cannot write " << settings.out << "\n";
+            return 1;
+        }
+        writeJson(file, all, settings.repetitions, argv[0]);
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,108 @@
+#ifndef BENCH_BENCHMARK_H
+#define BENCH_BENCHMARK_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A small stand-in for Google Benchmark: the same registration style and
+// timing loop, and the same JSON output, so results can be read by its tools
+// and by bench/compare.py. Command line flags follow it too:
+//   --benchmark_filter=<regex>      --benchmark_min_time=<seconds>
+//   --benchmark_repetitions=<n>     --benchmark_list_tests
+//   --benchmark_format=console|json --benchmark_out=<file> (JSON)
+namespace bench {
+
+class State {
+public:
+    State(int64_t iterations, const std::vector<int64_t>& args);
+
+    // What the loop variable holds: nothing, but with a user-provided
+    // constructor and destructor, so compilers do not warn that `_` is unused
+    struct Value {
+        Value() {}
+        ~Value() {}
+    };
+
+    // for (auto _ : state) { ... } runs the timed loop
+    struct Iterator {
+        int64_t remaining;
+        State* state;
+        bool operator!=(const Iterator&) {
+            if (remaining > 0) return true;
+            state->stopTimer();
+            return false;
+        }
+        void operator++() { --remaining; }
+        Value operator*() const { return Value(); }
+    };
+    Iterator begin();
+    Iterator end() { return Iterator{0, this}; }
+
+    int64_t range(size_t i = 0) const { return args[i]; }
+    int64_t iterations() const { return maxIterations; }
+    void setItemsProcessed(int64_t items) { itemsProcessed = items; }
+    void setLabel(const std::string& text) { label = text; }
+
+    double realSeconds() const { return realTime; }
+    double cpuSeconds() const { return cpuTime; }
+    int64_t items() const { return itemsProcessed; }
+    const std::string& labelText() const { return label; }
+
+private:
+    int64_t maxIterations;
+    std::vector<int64_t> args;
+    int64_t itemsProcessed;
+    std::string label;
+    double realStart, cpuStart, realTime, cpuTime;
+
+    void stopTimer();
+};
+
+using Function = std::function<void(State&)>;
+
+// One registered benchmark and the argument sets it runs with
+class Benchmark {
+public:
+    Benchmark(const std::string& name, Function fn);
+
+    Benchmark* arg(int64_t value);
+    Benchmark* args(const std::vector<int64_t>& values);
+    Benchmark* range(int64_t lo, int64_t hi);   // lo, lo * m, ..., hi
+    Benchmark* rangeMultiplier(int multiplier);
+
+    const std::string& name() const { return benchName; }
+    const Function& function() const { return fn; }
+    const std::vector<std::vector<int64_t>>& argSets() const { return sets; }
+
+private:
+    std::string benchName;
+    Function fn;
+    std::vector<std::vector<int64_t>> sets;
+    int multiplier;
+};
+
+Benchmark* registerBenchmark(const std::string& name, Function fn);
+int run(int argc, char** argv);
+
+// Keep a value (and the work producing it) from being optimised away
+void useValue(const volatile void* p);
+template <typename T> inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    useValue(&value);
+#endif
+}
+
+}
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCHMARK(fn) \
+    static ::bench::Benchmark* BENCH_CONCAT(bench_registration_, __LINE__) = ::bench::registerBenchmark(#fn, fn)
+#define BENCHMARK_MAIN() \
+    int main(int argc, char** argv) { return ::bench::run(argc, argv); }
+
+#endif // BENCH_BENCHMARK_H
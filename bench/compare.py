@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compare two benchmark JSON files (kernel_benchmark or Google Benchmark).
+
+    compare.py baseline.json contender.json [--threshold 0.05] [--metric cpu_time]
+
+Benchmarks are matched by name. With repetitions the median aggregate is
+used, otherwise the single run. A benchmark that got slower by more than the
+threshold (relative) is flagged as a regression and the exit status is 1.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path) as f:
+        data = json.load(f)
+    plain, medians = {}, {}
+    for b in data.get("benchmarks", []):
+        if b.get("run_type") == "aggregate":
+            if b.get("aggregate_name") == "median":
+                medians[b["run_name"]] = b[metric]
+        elif b.get("repetition_index", 0) == 0:
+            plain[b.get("run_name", b["name"])] = b[metric]
+    plain.update(medians)
+    return plain
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative slowdown counted as a regression (default 0.05)")
+    parser.add_argument("--metric", choices=["cpu_time", "real_time"], default="cpu_time")
+    args = parser.parse_args()
+
+    base = load(args.baseline, args.metric)
+    new = load(args.contender, args.metric)
+
+    names = [n for n in base if n in new]
+    width = max([len(n) for n in names] + [9])
+    print(f"{'Benchmark':<{width}} {'baseline':>14} {'contender':>14} {'change':>9}")
+
+    regressions = 0
+    for name in names:
+        old, cur = base[name], new[name]
+        change = (cur - old) / old if old > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  improved"
+        print(f"{name:<{width}} {old:>14.1f} {cur:>14.1f} {change:>+8.1%}{flag}")
+
+    for name in sorted(set(base) ^ set(new)):
+        print(f"{name:<{width}} only in {'baseline' if name in base else 'contender'}")
+
+    print(f"\n{regressions} regression(s) beyond {args.threshold:.0%} in {args.metric}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
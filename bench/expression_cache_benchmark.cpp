@@ -0,0 +1,62 @@
+// Cost of getting a ready-to-evaluate expression: a fresh parse every time
+// against a lookup in the shared cache, for a working set of 200 expressions
+// requested over and over from several threads.
+//
+// Build: g++ -O2 -pthread -I headers bench/expression_cache_benchmark.cpp src/ExpressionCache.cpp src/parser.cpp src/Interval.cpp -o expression_cache_benchmark
+#include "ExpressionCache.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    vector<string> expressions;
+    for (int i = 0; i < 200; ++i)
+        expressions.push_back("sin(" + to_string(i) + "*x) + exp(-x/" + to_string(i + 1) + ") * (x^2 - " +
+                              to_string(i % 7) + ")");
+
+    const int lookups = 200000;
+    double sink = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        EquationParser parser;
+        parser.parseEquation(expressions[i % expressions.size()]);
+        sink += parser.evaluate(0.5);
+    }
+    double parseNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+
+    ExpressionCache cache(256);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i)
+        sink += cache.get(expressions[i % expressions.size()])->evaluate(0.5);
+    double cachedNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+
+    unsigned threads = max(2u, thread::hardware_concurrency());
+    vector<thread> pool;
+    vector<double> sums(threads, 0.0);
+    start = chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back([&, t] {
+            for (int i = 0; i < lookups; ++i)
+                sums[t] += cache.get(expressions[(i + 37 * t) % expressions.size()])->evaluate(0.5);
+        });
+    for (auto& th : pool) th.join();
+    double threadedNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() /
+                        (double(lookups) * threads);
+    for (double s : sums) sink += s;
+
+    ExpressionCacheStats stats = cache.stats();
+    cout << fixed << setprecision(1);
+    cout << "parse + evaluate      " << setw(10) << parseNs << " ns\n";
+    cout << "cache get + evaluate  " << setw(10) << cachedNs << " ns\n";
+    cout << "same, " << threads << " threads     " << setw(10) << threadedNs << " ns per lookup (wall / total)\n";
+    cout << "hits " << stats.hits << ", misses " << stats.misses << ", size " << stats.size << "\n";
+    cout << "(checksum " << sink << ")\n";
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Root counts from the sampling scanner (findAllRoots) against the interval
+// branch-and-bound isolator, which proves every count it reports as complete.
+// The problems have touching roots, close pairs and many oscillations.
+//
+// Build: g++ -O2 -I headers bench/interval_benchmark.cpp src/IntervalRootIsolator.cpp src/Interval.cpp src/RootScanner.cpp src/BracketedSolvers.cpp src/ExpressionCache.cpp src/parser.cpp -pthread -o interval_benchmark
+#include "IntervalRootIsolator.h"
+#include "RootScanner.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct Problem {
+    string expr;
+    double a, b;
+    int roots;   // known count
+};
+
+template <typename F>
+double microseconds(F f, int repeats) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) f();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / repeats;
+}
+
+int main() {
+    vector<Problem> problems = {
+        {"x^2 - 2",                     -3, 3,      2},
+        {"(x - 1)^2 - 1e-20",           -1, 3,      2},
+        {"(x - 1) * (x - 1.000001)",    0, 2,       2},
+        {"sin(x)",                      -100, 100,  63},
+        {"sin(1/x)",                    0.01, 1,    31},
+        {"exp(x) - 10*x",               0, 5,       2},
+        {"cos(x) - x",                  -10, 10,    1},
+        {"x^5 - 5*x^3 + 4*x",           -3, 3,      5},
+        {"sin(50*x) + 0.999",           0, 1,       16},
+        {"exp(-x^2) - 1e-3",            -10, 10,    2},
+    };
+
+    RootScanOptions scan;
+    scan.threads = 1;
+
+    cout << left << setw(28) << "problem" << setw(7) << "known"
+         << setw(8) << "scan" << setw(12) << "scan us"
+         << setw(10) << "interval" << setw(10) << "proved" << setw(8) << "boxes" << "interval us" << endl;
+
+    for (const auto& p : problems) {
+        vector<double> found;
+        IsolationResult isolated;
+        double scanTime = microseconds([&] { found = findAllRoots(p.expr, p.a, p.b, scan); }, 20);
+        double intervalTime = microseconds([&] { isolated = isolateRoots(p.expr, p.a, p.b); }, 20);
+
+        cout << left << setw(28) << p.expr << setw(7) << p.roots
+             << setw(8) << found.size() << setw(12) << fixed << setprecision(1) << scanTime
+             << setw(10) << isolated.certifiedRoots << setw(10) << (isolated.complete ? "yes" : "no")
+             << setw(8) << isolated.boxes << intervalTime << defaultfloat << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,378 @@
+// Benchmark suite for the numerical kernels: the parser, the integration
+// rules and double-exponential quadrature, both Euler solvers and their
+// ensemble mode, bisection / secant, Lagrange and divided difference
+// interpolation, polynomial fitting, Savitzky-Golay smoothing and data
+// loading, each across input sizes.
+//
+// Save a baseline and compare a later run against it:
+//   kernel_benchmark --benchmark_out=base.json
+//   kernel_benchmark --benchmark_out=new.json
+//   python3 bench/compare.py base.json new.json
+//
+// Build: cmake -S . -B build && cmake --build build --target kernel_benchmark
+#include "Benchmark.h"
+
+#include "DataSource.h"
+#include "DividedDifferenceInterpolator.h"
+#include "DoubleExponential.h"
+#include "EulerMethods.h"
+#include "LagrangeInterpolator.h"
+#include "PolynomialFitter.h"
+#include "SavitzkyGolay.h"
+#include "bisection.h"
+#include "integration.h"
+#include "parser.h"
+#include "secant.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const char* kExpression = "sin(x) * exp(-x / 4) + x^2 / (1 + x^2)";
+
+vector<double> grid(int64_t n, double a, double b) {
+    vector<double> x(static_cast<size_t>(n));
+    for (int64_t i = 0; i < n; ++i) x[size_t(i)] = a + (b - a) * double(i) / double(max<int64_t>(1, n - 1));
+    return x;
+}
+
+// ---- parser ----
+
+void BM_ParserParse(bench::State& state) {
+    for (auto _ : state) {
+        EquationParser parser;
+        parser.parseEquation(kExpression);
+        bench::doNotOptimize(parser);
+    }
+}
+BENCHMARK(BM_ParserParse);
+
+// bulk ingestion: every expression distinct, one parser reused
+vector<string> distinctExpressions(int64_t n) {
+    const char* shapes[] = {
+        "sin(%g*x) + x^2/(1 + %g) - max(x, %g, 1)",
+        "x > %g ? exp(-x/%g) : ln(1 + x^2) * %g",
+        "-(%g*x - 3)^2 + sqrt(abs(x)) * cos(pi*x/%g) + %g",
+        "atan(x/%g) - tanh(x) + floor(%g*x)/(e + %g)",
+    };
+    vector<string> out;
+    char buffer[128];
+    for (int64_t i = 0; i < n; ++i) {
+        double a = 0.5 + 0.37 * double(i), b = 1 + double(i % 97), c = 1e-3 * double(i);
+        snprintf(buffer, sizeof buffer, shapes[i % 4], a, b, c);
+        out.push_back(buffer);
+    }
+    return out;
+}
+
+void BM_ParserIngest(bench::State& state) {
+    vector<string> expressions = distinctExpressions(state.range(0));
+    EquationParser parser;
+    for (auto _ : state) {
+        for (const string& expression : expressions) parser.parseEquation(expression);
+        bench::doNotOptimize(parser);
+    }
+    state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParserIngest)->arg(4096);
+
+void BM_ParserEvaluate(bench::State& state) {
+    EquationParser parser;
+    parser.parseEquation(kExpression);
+    vector<double> x = grid(state.range(0), -5, 5);
+    for (auto _ : state) {
+        double sum = 0;
+        for (double xi : x) sum += parser.evaluate(xi);
+        bench::doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParserEvaluate)->range(64, 32768);
+
+void BM_ParserEvaluateBatch(bench::State& state) {
+    EquationParser parser;
+    parser.parseEquation(kExpression);
+    vector<double> x = grid(state.range(0), -5, 5), y(x.size());
+    for (auto _ : state) {
+        parser.evaluateBatch(x.data(), y.data(), x.size());
+        bench::doNotOptimize(y.data());
+    }
+    state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParserEvaluateBatch)->range(64, 32768);
+
+// ---- integration: points = 6k + 1 suits all three rules ----
+
+int rulePoints(int64_t n) { return int(6 * (n / 6) + 1); }
+
+void BM_IntegrateSample(bench::State& state) {
+    int n = rulePoints(state.range(0));
+    for (auto _ : state) {
+        NumericalIntegrator integrator(kExpression, 0, 10, n);
+        bench::doNotOptimize(integrator);
+    }
+    state.setItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_IntegrateSample)->range(64, 262144);
+
+template <double (NumericalIntegrator::*Rule)()>
+void integrationRule(bench::State& state) {
+    int n = rulePoints(state.range(0));
+    NumericalIntegrator integrator(kExpression, 0, 10, n);
+    for (auto _ : state) bench::doNotOptimize((integrator.*Rule)());
+    state.setItemsProcessed(state.iterations() * n);
+}
+
+void BM_Trapezoidal(bench::State& state) { integrationRule<&NumericalIntegrator::trapezoidalRule>(state); }
+void BM_Simpson13(bench::State& state) { integrationRule<&NumericalIntegrator::simpsons13Rule>(state); }
+void BM_Simpson38(bench::State& state) { integrationRule<&NumericalIntegrator::simpsons38Rule>(state); }
+BENCHMARK(BM_Trapezoidal)->range(64, 262144);
+BENCHMARK(BM_Simpson13)->range(64, 262144);
+BENCHMARK(BM_Simpson38)->range(64, 262144);
+
+// ---- double-exponential quadrature: 0 = 1/sqrt(x) on [0, 1], 1 = exp(-x) on
+// [0, inf), 2 = 1/(1 + x^2) on (-inf, inf) ----
+
+void BM_DoubleExponential(bench::State& state) {
+    struct Case { const char* expr; double a, b; };
+    const Case cases[] = {{"1/sqrt(x)", 0, 1}, {"exp(-x)", 0, HUGE_VAL}, {"1/(1 + x^2)", -HUGE_VAL, HUGE_VAL}};
+    const Case& c = cases[state.range(0)];
+    EquationParser parser;
+    parser.parseEquation(c.expr);
+    int evaluations = 0;
+    for (auto _ : state) {
+        QuadratureResult result = integrateDoubleExponential(parser, c.a, c.b);
+        evaluations = result.evaluations;
+        bench::doNotOptimize(result.value);
+    }
+    state.setLabel(string(c.expr) + " evaluations=" + to_string(evaluations));
+}
+BENCHMARK(BM_DoubleExponential)->arg(0)->arg(1)->arg(2);
+
+// ---- Euler: y' = x + y - x^2 on [0, 1] in n steps ----
+
+template <typename Method>
+void euler(bench::State& state) {
+    Method method;
+    int steps = int(state.range(0));
+    for (auto _ : state) bench::doNotOptimize(method.integrate("x + y - x^2", 0, 1, 1.0 / steps, steps));
+    state.setItemsProcessed(state.iterations() * steps);
+}
+
+void BM_BasicEuler(bench::State& state) { euler<BasicEuler>(state); }
+void BM_ModifiedEuler(bench::State& state) { euler<ModifiedEuler>(state); }
+BENCHMARK(BM_BasicEuler)->range(64, 32768);
+BENCHMARK(BM_ModifiedEuler)->range(64, 32768);
+
+// ---- Euler ensembles: argument = trajectories, 100 steps each ----
+
+// one integrate() call per trajectory
+void BM_EulerTrajectoryLoop(bench::State& state) {
+    ModifiedEuler method;
+    vector<double> y0 = grid(state.range(0), 0, 1);
+    for (auto _ : state) {
+        double sum = 0;
+        for (double y : y0) sum += method.integrate("x + y - x^2", 0, y, 0.01, 100);
+        bench::doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.iterations() * state.range(0) * 100);
+}
+BENCHMARK(BM_EulerTrajectoryLoop)->range(512, 32768);
+
+void BM_EulerEnsemble(bench::State& state) {
+    ModifiedEuler method;
+    vector<double> y0 = grid(state.range(0), 0, 1);
+    EnsembleOptions options;
+    options.threads = int(state.range(1));
+    for (auto _ : state) bench::doNotOptimize(method.integrateEnsemble("x + y - x^2", 0, y0, 0.01, 100, options).mean);
+    state.setItemsProcessed(state.iterations() * state.range(0) * 100);
+}
+BENCHMARK(BM_EulerEnsemble)->args({512, 1})->args({4096, 1})->args({32768, 1})->args({32768, 0});
+
+// ---- bracketing / secant: argument = digits of tolerance ----
+
+void BM_Bisection(bench::State& state) {
+    double tol = pow(10.0, -double(state.range(0)));
+    for (auto _ : state) {
+        bisection solver("x^3 - 2*x - 5", 2, 3, tol, 200);
+        bench::doNotOptimize(solver.bisection_solve(false));
+    }
+}
+BENCHMARK(BM_Bisection)->arg(4)->arg(8)->arg(12);
+
+void BM_Secant(bench::State& state) {
+    double tol = pow(10.0, -double(state.range(0)));
+    for (auto _ : state) {
+        SecantSolver solver("x^3 - 2*x - 5", 2, 3, tol, 200);
+        bench::doNotOptimize(solver.solve(false));
+    }
+}
+BENCHMARK(BM_Secant)->arg(4)->arg(8)->arg(12);
+
+// ---- interpolation and fitting: argument = number of data points ----
+
+vector<double> sampled(const vector<double>& x) {
+    vector<double> y;
+    for (double xi : x) y.push_back(1 / (1 + xi * xi));
+    return y;
+}
+
+void BM_LagrangeInterpolate(bench::State& state) {
+    vector<double> x = grid(state.range(0), -1, 1);
+    LagrangeInterpolator interpolator(x, sampled(x));
+    vector<double> at = grid(64, -0.99, 0.99);
+    for (auto _ : state) {
+        double sum = 0;
+        for (double a : at) sum += interpolator.interpolateY(a);
+        bench::doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.iterations() * int64_t(at.size()));
+}
+BENCHMARK(BM_LagrangeInterpolate)->rangeMultiplier(2)->range(4, 64);
+
+void BM_DividedDifference(bench::State& state) {
+    vector<double> x = grid(state.range(0), -1, 1);
+    divide interpolator(x, sampled(x));
+    vector<double> at = grid(64, -0.99, 0.99);
+    for (auto _ : state) {
+        double sum = 0;
+        for (double a : at) sum += interpolator.evaluate(a);
+        bench::doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.iterations() * int64_t(at.size()));
+}
+BENCHMARK(BM_DividedDifference)->arg(4)->arg(8)->arg(16)->arg(20);
+
+void BM_PolynomialFit(bench::State& state) {
+    vector<double> x = grid(state.range(0), -3, 3);
+    vector<double> y = sampled(x);
+    for (auto _ : state) {
+        PolynomialFitter fitter(x, y, int(state.range(1)));
+        fitter.fit();
+        bench::doNotOptimize(fitter.coefficients().data());
+    }
+    state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PolynomialFit)->args({64, 3})->args({512, 3})->args({4096, 3})->args({32768, 3})
+                           ->args({4096, 8})->args({4096, 16});
+
+// ---- sliding-window smoothing: samples, half window; quadratic fits ----
+
+vector<double> noisySignal(int64_t n) {
+    vector<double> y(static_cast<size_t>(n));
+    for (int64_t i = 0; i < n; ++i) y[size_t(i)] = sin(1e-3 * double(i)) + 0.01 * sin(12.9898 * double(i));
+    return y;
+}
+
+// a PolynomialFitter per window position
+void BM_SlidingPolynomialFit(bench::State& state) {
+    int64_t n = state.range(0);
+    int m = int(state.range(1));
+    vector<double> y = noisySignal(n), t = grid(2 * m + 1, -m, m), out(y.size());
+    for (auto _ : state) {
+        for (int64_t i = m; i < n - m; ++i) {
+            PolynomialFitter fitter(t, vector<double>(y.begin() + (i - m), y.begin() + (i + m + 1)), 2);
+            fitter.fit();
+            out[size_t(i)] = fitter.evaluate(0);
+        }
+        bench::doNotOptimize(out.data());
+    }
+    state.setItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SlidingPolynomialFit)->args({4096, 3})->args({4096, 25});
+
+void BM_SavitzkyGolay(bench::State& state) {
+    int64_t n = state.range(0);
+    SavitzkyGolayFilter filter(int(state.range(1)), 2);
+    vector<double> y = noisySignal(n), out(y.size());
+    for (auto _ : state) {
+        filter.apply(y.data(), out.data(), y.size());
+        bench::doNotOptimize(out.data());
+    }
+    state.setItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SavitzkyGolay)->args({4096, 3})->args({4096, 25})->args({1 << 20, 3})->args({1 << 20, 25})
+                           ->args({1 << 24, 3});
+
+
+// ---- data loading: argument = rows of (x, y) ----
+
+string scratchFile(const string& name) {
+    return (filesystem::temp_directory_path() / ("kernel_benchmark_" + name)).string();
+}
+
+string writeCsv(int64_t rows) {
+    string path = scratchFile("points.csv");
+    ofstream out(path);
+    out << "x,y\n";
+    char line[64];
+    for (int64_t i = 0; i < rows; ++i) {
+        double x = double(i) / double(rows);
+        snprintf(line, sizeof line, "%.17g,%.17g\n", x, sin(x));
+        out << line;
+    }
+    return path;
+}
+
+// what main.cpp used to do: operator>> one value at a time
+void BM_LoadCsvStream(bench::State& state) {
+    string path = writeCsv(state.range(0));
+    for (auto _ : state) {
+        ifstream in(path);
+        string header;
+        getline(in, header);
+        vector<double> x, y;
+        double xi, yi;
+        char comma;
+        while (in >> xi >> comma >> yi) {
+            x.push_back(xi);
+            y.push_back(yi);
+        }
+        bench::doNotOptimize(x.data());
+    }
+    remove(path.c_str());
+    state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadCsvStream)->range(4096, 262144);
+
+void BM_LoadCsv(bench::State& state) {
+    string path = writeCsv(state.range(0));
+    for (auto _ : state) {
+        CsvTable table(path);
+        bench::doNotOptimize(table.column(1).data());
+    }
+    remove(path.c_str());
+    state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadCsv)->range(4096, 262144);
+
+// map a float64 column file and fit straight from the mapping
+void BM_FitColumnFile(bench::State& state) {
+    vector<double> x = grid(state.range(0), -3, 3), y = sampled(x);
+    string path = scratchFile("points.f64");
+    {
+        ofstream out(path, ios::binary);
+        out.write(reinterpret_cast<const char*>(x.data()), streamsize(x.size() * sizeof(double)));
+        out.write(reinterpret_cast<const char*>(y.data()), streamsize(y.size() * sizeof(double)));
+    }
+    for (auto _ : state) {
+        ColumnFile file(path, 2);
+        PolynomialFitter fitter(file.column(0), file.column(1), 3);
+        fitter.fit();
+        bench::doNotOptimize(fitter.coefficients().data());
+    }
+    remove(path.c_str());
+    state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FitColumnFile)->range(4096, 262144);
+
+}
+
+BENCHMARK_MAIN()
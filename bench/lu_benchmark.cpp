@@ -0,0 +1,81 @@
+// Solve time against system size: DenseMatrix/LUDecomposition versus the
+// row-of-vectors Gaussian elimination PolynomialFitter used to carry.
+//
+// Build: g++ -O3 -march=native -I headers bench/lu_benchmark.cpp src/DenseMatrix.cpp -o lu_benchmark
+#include "DenseMatrix.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Reference: vector<vector<double>> augmented matrix, whole-row swaps
+static vector<double> naiveSolve(vector<vector<double>> B) {
+    int m = int(B.size());
+    for (int i = 0; i < m; ++i) {
+        int maxr = i;
+        for (int k = i + 1; k < m; ++k)
+            if (fabs(B[k][i]) > fabs(B[maxr][i])) maxr = k;
+        swap(B[i], B[maxr]);
+        for (int k = i + 1; k < m; ++k) {
+            double t = B[k][i] / B[i][i];
+            for (int j = i; j <= m; ++j) B[k][j] -= t * B[i][j];
+        }
+    }
+    vector<double> a(m);
+    for (int i = m - 1; i >= 0; --i) {
+        a[i] = B[i][m];
+        for (int j = i + 1; j < m; ++j) a[i] -= B[i][j] * a[j];
+        a[i] /= B[i][i];
+    }
+    return a;
+}
+
+template <typename F>
+static double bestOf(int repeats, F&& body) {
+    double best = 1e300;
+    for (int r = 0; r < repeats; ++r) {
+        auto t0 = chrono::steady_clock::now();
+        body();
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+int main() {
+    mt19937_64 rng(42);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    cout << left << setw(8) << "n" << setw(15) << "naive (ms)" << setw(15) << "blocked (ms)"
+         << setw(12) << "speedup" << setw(12) << "GFLOP/s" << "max |x - x_ref|" << endl;
+
+    for (int n : {16, 32, 64, 128, 256, 512, 1024}) {
+        DenseMatrix A(n, n);
+        vector<vector<double>> B(n, vector<double>(n + 1));
+        vector<double> b(n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) B[i][j] = A(i, j) = dist(rng);
+            B[i][n] = b[i] = dist(rng);
+        }
+
+        int repeats = n <= 128 ? 20 : 3;
+        vector<double> ref, x;
+        double naive = bestOf(repeats, [&] { ref = naiveSolve(B); });
+        double blocked = bestOf(repeats, [&] { x = LUDecomposition(A).solve(b); });
+
+        double diff = 0;
+        for (int i = 0; i < n; ++i) diff = max(diff, fabs(x[i] - ref[i]));
+
+        cout << left << setw(8) << n
+             << setw(15) << naive * 1e3
+             << setw(15) << blocked * 1e3
+             << setw(12) << naive / blocked
+             << setw(12) << (2.0 / 3.0) * n * double(n) * n / blocked * 1e-9
+             << diff << endl;
+    }
+    return 0;
+}
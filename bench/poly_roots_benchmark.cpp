@@ -0,0 +1,70 @@
+// Time to find every root of random and Wilkinson-type polynomials by
+// degree, with the worst residual |p(root)| relative to the coefficient scale.
+//
+// Build: g++ -O2 -I headers bench/poly_roots_benchmark.cpp src/PolynomialRoots.cpp -o poly_roots_benchmark
+#include "PolynomialRoots.h"
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static double worstResidual(const vector<double>& a, const vector<complex<double>>& roots) {
+    double worst = 0;
+    for (const auto& z : roots) {
+        complex<double> p = 0;
+        double scale = 0;
+        for (int k = int(a.size()) - 1; k >= 0; --k) {
+            p = p * z + a[k];
+            scale = scale * abs(z) + fabs(a[k]);
+        }
+        worst = max(worst, abs(p) / scale);
+    }
+    return worst;
+}
+
+int main() {
+    mt19937_64 rng(7);
+    normal_distribution<double> dist;
+
+    cout << left << setw(10) << "degree" << setw(16) << "random (us)" << setw(16) << "residual"
+         << setw(18) << "wilkinson (us)" << "real roots" << endl;
+
+    for (int n : {5, 10, 20, 30, 50}) {
+        vector<double> random(n + 1);
+        for (double& c : random) c = dist(rng);
+
+        // (x - 1)(x - 2)...(x - m) for m up to 20, beyond that the
+        // coefficients no longer fit a double exactly
+        int m = min(n, 20);
+        vector<double> wilkinson(1, 1.0);
+        for (int r = 1; r <= m; ++r) {
+            vector<double> next(wilkinson.size() + 1, 0.0);
+            for (size_t j = 0; j < wilkinson.size(); ++j) {
+                next[j + 1] += wilkinson[j];
+                next[j] -= r * wilkinson[j];
+            }
+            wilkinson.swap(next);
+        }
+
+        const int repeats = 200;
+        vector<complex<double>> roots;
+        auto t0 = chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) roots = polynomialRoots(random);
+        double randomTime = chrono::duration<double>(chrono::steady_clock::now() - t0).count() / repeats;
+
+        vector<double> real;
+        t0 = chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) real = realPolynomialRoots(wilkinson);
+        double wilkinsonTime = chrono::duration<double>(chrono::steady_clock::now() - t0).count() / repeats;
+
+        cout << left << setw(10) << n << setw(16) << randomTime * 1e6 << setw(16) << worstResidual(random, roots)
+             << setw(18) << wilkinsonTime * 1e6 << real.size() << "/" << m << endl;
+    }
+    return 0;
+}
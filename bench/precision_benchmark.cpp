@@ -0,0 +1,114 @@
+// Cost and accuracy of each scalar precision: expression evaluation,
+// high-degree interpolation, an ill-conditioned polynomial fit and composite
+// Simpson integration, each in double, long double and (with
+// NUMERICAL_FLOAT128) __float128.
+//
+// Build: g++ -O2 -DNUMERICAL_FLOAT128 -I headers bench/precision_benchmark.cpp src/ExtendedPrecision.cpp src/ExpressionCache.cpp src/parser.cpp src/Interval.cpp -lquadmath -o precision_benchmark
+// (drop -DNUMERICAL_FLOAT128 and -lquadmath for double and long double only)
+#include "ExtendedPrecision.h"
+#include "parser.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#ifdef NUMERICAL_FLOAT128
+using Reference = __float128;
+#else
+using Reference = long double;
+#endif
+
+template <typename F>
+double microseconds(int repeats, F&& work) {
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) work();
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / repeats;
+}
+
+double relativeError(Reference value, Reference exact) {
+    using std::fabs; using ::fabs;
+    return double(fabs((value - exact) / exact));
+}
+
+// double goes through the regular evaluator, the wider types through evaluateAs
+template <typename T> T evaluateAt(const EquationParser& f, T x) { return f.evaluateAs<T>(x); }
+double evaluateAt(const EquationParser& f, double x) { return f.evaluate(x); }
+
+template <typename T>
+void row(const char* task, double us, double error) {
+    cout << left << setw(14) << ScalarTraits<T>::name() << setw(26) << task << right
+         << setw(12) << fixed << setprecision(2) << us
+         << setw(14) << scientific << setprecision(2) << error << "\n";
+}
+
+template <typename T>
+void run(const EquationParser& f) {
+    using std::exp; using ::exp;
+
+    // 1. expression evaluation at one point
+    T x = T(3) / 7, sink = 0;
+    double us = microseconds(100000, [&] { sink += evaluateAt(f, x); x += T(1) / 1000000; });
+    Reference exact = f.evaluateAs<Reference>(Reference(3) / 7);
+    row<T>("evaluate (1 point)", us, relativeError(Reference(evaluateAt(f, T(3) / 7)), exact));
+
+    // 2. degree-29 interpolation of exp on 30 equispaced nodes, through the
+    //    monomial coefficients (the ill-conditioned route)
+    const int nodes = 30;
+    vector<T> xs(nodes), ys(nodes);
+    for (int i = 0; i < nodes; ++i) {
+        xs[i] = T(i) / (nodes - 1);
+        ys[i] = exp(xs[i]);
+    }
+    vector<T> a;
+    us = microseconds(200, [&] { a = NewtonInterpolant<T>(xs, ys).coefficients(); });
+    double worst = 0;
+    for (int i = 0; i + 1 < nodes; ++i) {
+        T t = (T(i) + T(1) / 2) / (nodes - 1), p = 0;
+        for (int k = nodes - 1; k >= 0; --k) p = p * t + a[k];
+        Reference rt = (Reference(i) + Reference(1) / 2) / (nodes - 1);
+        worst = max(worst, relativeError(Reference(p), exp(rt)));
+    }
+    row<T>("interpolate, monomial", us, worst);
+
+    // 3. degree-12 fit of sum x^k on [0, 10]; error in the monomial coefficients
+    const int points = 200, degree = 12;
+    vector<T> fx(points), fy(points);
+    for (int i = 0; i < points; ++i) {
+        fx[i] = T(10) * i / (points - 1);
+        T p = 0;
+        for (int k = degree; k >= 0; --k) p = p * fx[i] + 1;
+        fy[i] = p;
+    }
+    PrecisePolynomialFitter<T> fitter(fx, fy, degree);
+    us = microseconds(20, [&] { fitter.fit(); });
+    worst = 0;
+    for (const T& c : fitter.coefficients()) worst = max(worst, relativeError(Reference(c), Reference(1)));
+    row<T>("fit degree 12", us, worst);
+
+    // 4. Simpson's 1/3 on a cubic over [0, 1] (exact up to rounding: 1/4)
+    EquationParser g;
+    g.parseEquation("x^3 - 2*x + 1");
+    T integral = 0;
+    us = microseconds(5, [&] { integral = integrateExpression<T>(g, T(0), T(1), 20001, IntegrationRule::Simpson13); });
+    row<T>("Simpson, 20001 points", us, relativeError(Reference(integral), Reference(1) / 4));
+
+    if (sink == T(-1)) cout << "";
+}
+
+int main() {
+    EquationParser f;
+    f.parseEquation("exp(sin(x)) * ln(1 + x^2) / (pi + e)");
+
+    cout << left << setw(14) << "precision" << setw(26) << "task" << right
+         << setw(12) << "us" << setw(14) << "rel. error" << "\n";
+    run<double>(f);
+    run<long double>(f);
+#ifdef NUMERICAL_FLOAT128
+    run<__float128>(f);
+#endif
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Cost of a result cache lookup against recomputing: a root search, a
+// double-exponential integral and a polynomial fit, each timed without the
+// cache, on a first run that fills it and on a second run that hits it, plus
+// the bare lookup latency. The cache file lives in the temp directory and is
+// removed afterwards.
+//
+// Build: cmake -S . -B build && cmake --build build --target result_cache_benchmark
+#include "BracketedSolvers.h"
+#include "PolynomialFitter.h"
+#include "ResultCache.h"
+#include "integration.h"
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const int kRoots = 200;
+const int kIntegrals = 50;
+const int kFits = 10;
+
+double sink = 0;
+
+// microseconds per call of each of `count` calls
+double timeEach(int count, const function<void(int)>& call) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) call(i);
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / count;
+}
+
+void roots(int i) {
+    string expr = "x^3 - " + to_string(2 + i) + "*x - 5 + sin(x) / 10";
+    sink += brentRoot(expr, 0, 50).root;
+}
+
+void integrals(int i) {
+    string expr = "exp(-x^2 / " + to_string(1 + i) + ") / (1 + x^2)";
+    sink += NumericalIntegrator(expr, -HUGE_VAL, HUGE_VAL, 2).doubleExponential();
+}
+
+vector<double> xs, ys;
+
+void fits(int i) {
+    PolynomialFitter fitter(ColumnView(xs), ColumnView(ys), 4 + i % 5);
+    fitter.fit();
+    sink += fitter.coefficients()[0];
+}
+
+void report(const char* name, int count, void (*call)(int), const shared_ptr<ResultCache>& cache) {
+    ResultCache::setGlobal(nullptr);
+    call(count);   // warm up: expression compilation, quadrature tables
+    double plain = timeEach(count, call);
+    ResultCache::setGlobal(cache);
+    double first = timeEach(count, call);
+    double second = timeEach(count, call);
+    cout << setw(10) << name << setw(14) << plain << setw(14) << first << setw(14) << second << setw(10)
+         << plain / second << "x\n";
+}
+
+}
+
+int main() {
+    filesystem::path path = filesystem::temp_directory_path() / "result_cache_benchmark.bin";
+    filesystem::remove(path);
+    auto cache = make_shared<ResultCache>(path.string());
+
+    for (int i = 0; i < 200000; ++i) {
+        double x = -1 + 2e-5 * i;
+        xs.push_back(x);
+        ys.push_back(sin(3 * x) + 0.01 * sin(97 * x));
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "us per call     uncached  first (miss)  second (hit)   speedup\n";
+    report("root", kRoots, roots, cache);
+    report("integrate", kIntegrals, integrals, cache);
+    report("fit", kFits, fits, cache);
+
+    // the lookup alone, on a key already stored
+    ResultKey key("bench.lookup");
+    key.addExpression("x^2").add(1.0);
+    cache->store(key, {1, 2, 3, 4});
+    vector<double> values;
+    double lookupUs = timeEach(100000, [&](int) { sink += cache->lookup(key, values) ? values[0] : 0; });
+
+    ResultCacheStats stats = cache->stats();
+    cout << "lookup hit  " << lookupUs * 1000 << " ns\n";
+    cout << "hits " << stats.hits << ", misses " << stats.misses << " (" << setprecision(1)
+         << 100 * stats.hitRate() << "% hit rate), " << stats.entries << " entries, " << stats.bytes
+         << " bytes\n";
+    cout << "(checksum " << sink << ")\n";
+
+    ResultCache::setGlobal(nullptr);
+    cache.reset();
+    filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Evaluation counts of bisection, Brent and ITP on standard bracketed test
+// problems, all solved to the same bracket width.
+//
+// Build: g++ -O2 -I headers bench/root_benchmark.cpp src/BracketedSolvers.cpp src/ExpressionCache.cpp src/parser.cpp src/Interval.cpp -o root_benchmark
+#include "BracketedSolvers.h"
+
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct Problem {
+    string name;
+    function<double(double)> f;
+    double a, b;
+};
+
+int main() {
+    const double pi = acos(-1.0);
+    vector<Problem> problems = {
+        {"x^3 - 2x - 5",        [](double x) { return x * x * x - 2 * x - 5; },        2, 3},
+        {"cos(x) - x",          [](double x) { return cos(x) - x; },                   0, 1},
+        {"x e^x - 1",           [](double x) { return x * exp(x) - 1; },               0, 1},
+        {"sin(x) - x/2",        [](double x) { return sin(x) - x / 2; },               pi / 2, pi},
+        {"e^x - 2",             [](double x) { return exp(x) - 2; },                   0, 2},
+        {"ln(x)",               [](double x) { return log(x); },                       0.5, 5},
+        {"x^20 - 1",            [](double x) { return pow(x, 20) - 1; },               0, 1.5},
+        {"(x - 1)^3",           [](double x) { return pow(x - 1, 3); },                0, 1.7},
+        {"x^9",                 [](double x) { return pow(x, 9); },                    -1, 1.5},
+        {"atan(x - 0.7)",       [](double x) { return atan(x - 0.7); },                -10, 50},
+        {"e^(1/x) step",        [](double x) { return x < 0.3 ? -1.0 : exp(-1 / (x - 0.29)) - 0.5; }, 0, 2},
+        {"Wilkinson-like",      [](double x) { return (x - 1) * (x - 2) * (x - 3) * (x - 4) * (x - 5.5); }, 5, 6},
+        {"1e-6 x - 1e-12",      [](double x) { return 1e-6 * x - 1e-12; },             -1, 1},
+        {"tanh(50 (x - 0.2))",  [](double x) { return tanh(50 * (x - 0.2)); },         -1, 3},
+    };
+
+    RootOptions options;
+    options.xtol = 1e-12;
+
+    cout << left << setw(22) << "problem"
+         << setw(12) << "bisection" << setw(8) << "brent" << setw(8) << "itp"
+         << "root (brent)" << endl;
+
+    int total[3] = {0, 0, 0};
+    for (const auto& p : problems) {
+        RootResult r[3] = {
+            bisectionRoot(p.f, p.a, p.b, options),
+            brentRoot(p.f, p.a, p.b, options),
+            itpRoot(p.f, p.a, p.b, options),
+        };
+        for (int k = 0; k < 3; ++k) total[k] += r[k].evaluations;
+
+        cout << left << setw(22) << p.name
+             << setw(12) << r[0].evaluations << setw(8) << r[1].evaluations << setw(8) << r[2].evaluations
+             << setprecision(15) << r[1].root << endl;
+    }
+
+    cout << left << setw(22) << "total"
+         << setw(12) << total[0] << setw(8) << total[1] << setw(8) << total[2] << endl;
+
+    // the same solvers driven through the expression parser
+    RootResult viaParser = brentRoot("x^3 - 2*x - 5", 2, 3, options);
+    cout << "\nbrentRoot(\"x^3 - 2*x - 5\", 2, 3): " << setprecision(15) << viaParser.root
+         << " in " << viaParser.evaluations << " evaluations" << endl;
+    return 0;
+}
@@ -0,0 +1,225 @@
+// Load generator for the solver server: each client connection keeps
+// `depth` requests in flight over a mix of root, integrate, ode, fit and
+// interpolate requests, and the run reports requests per second and the
+// latency distribution (from sending a request to reading its reply).
+//
+//   server_loadgen [--socket=<path>] [--clients=4] [--depth=16] [--requests=20000]
+//                  [--threads=<clients>] [--idle=0]
+//
+// --idle opens that many extra connections first and never sends on them;
+// with more connections than server threads the run still has to finish.
+// Without --socket a SolverServer with --threads workers is started in this
+// process on a temporary socket. Against a separate process:
+//   numerical_cli --serve /tmp/solver.sock &
+//   server_loadgen --socket=/tmp/solver.sock
+//
+// Build: cmake -S . -B build && cmake --build build --target server_loadgen
+#include "SolverServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+int main() {
+    cerr << "server_loadgen needs Unix domain sockets\n";
+    return 1;
+}
+
+#else
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+const char* kMix[] = {
+    "root \"x^3 - 2*x - 5\" 2 3",
+    "root \"cos(x) - x\" 0 1 method=itp",
+    "integrate \"exp(-x^2)\" -inf inf",
+    "integrate \"1/sqrt(x)\" 0 1",
+    "ode \"x + y - x^2\" 0 1 0.01 100 method=modified",
+    "fit 2 0,1,2,3,4,5 1,2.1,4.9,10.2,16.8,26.1",
+    "interpolate 0,1,2,3 1,3,7,13 1.5 method=newton",
+    "ping",
+};
+const size_t kMixSize = sizeof kMix / sizeof kMix[0];
+
+struct Settings {
+    string socket;
+    int clients = 4, depth = 16;
+    int threads = 0, idle = 0;   // threads 0: one per client
+    long requests = 20000;
+};
+
+struct ClientResult {
+    vector<double> latencies;   // seconds
+    long errors = 0;
+};
+
+int connectTo(const string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, min(path.size(), sizeof address.sun_path - 1));
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) == 0) return fd;
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = write(fd, data.data() + sent, data.size() - sent);
+        if (n <= 0) return false;
+        sent += size_t(n);
+    }
+    return true;
+}
+
+// One connection: replies come back in request order, so the oldest send
+// time in flight belongs to the next reply
+void runClient(const Settings& s, long count, size_t first, ClientResult& result) {
+    int fd = connectTo(s.socket);
+    if (fd < 0) {
+        result.errors = count;
+        return;
+    }
+    vector<Clock::time_point> sentAt(static_cast<size_t>(count));
+    long sent = 0, received = 0;
+    size_t next = first;
+    string input;
+    char buffer[1 << 16];
+
+    auto sendUpTo = [&](long limit) {
+        string batch;
+        long from = sent;
+        for (; sent < limit; ++sent) {
+            batch += kMix[next++ % kMixSize];
+            batch += '\n';
+        }
+        Clock::time_point now = Clock::now();
+        for (long i = from; i < sent; ++i) sentAt[size_t(i)] = now;
+        return sendAll(fd, batch);
+    };
+
+    bool ok = sendUpTo(min<long>(count, s.depth));
+    while (ok && received < count) {
+        ssize_t n = read(fd, buffer, sizeof buffer);
+        if (n <= 0) break;
+        Clock::time_point now = Clock::now();
+        input.append(buffer, size_t(n));
+        size_t start = 0, end;
+        while ((end = input.find('\n', start)) != string::npos) {
+            if (input.compare(start, 3, "err") == 0) ++result.errors;
+            result.latencies.push_back(chrono::duration<double>(now - sentAt[size_t(received)]).count());
+            ++received;
+            start = end + 1;
+        }
+        input.erase(0, start);
+        ok = sendUpTo(min<long>(count, received + s.depth));
+    }
+    result.errors += count - received;
+    close(fd);
+}
+
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = size_t(p * double(sorted.size() - 1) + 0.5);
+    return sorted[min(i, sorted.size() - 1)];
+}
+
+bool readFlag(const string& arg, const string& flag, string& value) {
+    string prefix = "--" + flag + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Settings s;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i], value;
+        if (readFlag(arg, "socket", value)) s.socket = value;
+        else if (readFlag(arg, "clients", value)) s.clients = max(1, atoi(value.c_str()));
+        else if (readFlag(arg, "depth", value)) s.depth = max(1, atoi(value.c_str()));
+        else if (readFlag(arg, "requests", value)) s.requests = max(1L, atol(value.c_str()));
+        else if (readFlag(arg, "threads", value)) s.threads = max(1, atoi(value.c_str()));
+        else if (readFlag(arg, "idle", value)) s.idle = max(0, atoi(value.c_str()));
+        else {
+            cerr << "Unknown flag: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    // an in-process server unless one was named
+    SolverServer server;
+    thread serverThread;
+    if (s.socket.empty()) {
+        s.socket = (filesystem::temp_directory_path() / ("server_loadgen_" + to_string(getpid()) + ".sock")).string();
+        serverThread = thread([&] { server.serveUnixSocket(s.socket, s.threads > 0 ? s.threads : s.clients); });
+        for (int tries = 0; tries < 500; ++tries) {
+            int fd = connectTo(s.socket);
+            if (fd >= 0) {
+                close(fd);
+                break;
+            }
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+    }
+
+    vector<int> idle;
+    for (int i = 0; i < s.idle; ++i) {
+        int fd = connectTo(s.socket);
+        if (fd >= 0) idle.push_back(fd);
+    }
+
+    vector<ClientResult> results(size_t(s.clients));
+    vector<thread> clients;
+    Clock::time_point start = Clock::now();
+    for (int c = 0; c < s.clients; ++c) {
+        long count = s.requests / s.clients + (c < s.requests % s.clients ? 1 : 0);
+        clients.emplace_back(runClient, cref(s), count, size_t(c), ref(results[size_t(c)]));
+    }
+    for (auto& t : clients) t.join();
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    for (int fd : idle) close(fd);
+
+    if (serverThread.joinable()) {
+        server.stop();
+        serverThread.join();
+    }
+
+    vector<double> latencies;
+    long errors = 0;
+    for (const auto& r : results) {
+        latencies.insert(latencies.end(), r.latencies.begin(), r.latencies.end());
+        errors += r.errors;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    printf("clients=%d idle=%d depth=%d requests=%ld errors=%ld\n", s.clients, s.idle, s.depth, s.requests, errors);
+    printf("throughput  %.0f requests/s\n", double(latencies.size()) / seconds);
+    printf("latency us  p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", percentile(latencies, 0.5) * 1e6,
+           percentile(latencies, 0.99) * 1e6, percentile(latencies, 0.999) * 1e6,
+           (latencies.empty() ? 0 : latencies.back()) * 1e6);
+    return errors == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Newton against Broyden on the Broyden tridiagonal system
+//   (3 - 2 u_i) u_i - u_{i-1} - 2 u_{i+1} + 1 = 0
+// for the 2..20 unknowns typical of calibration problems.
+//
+// Build: g++ -O2 -I headers bench/system_benchmark.cpp src/NonlinearSystem.cpp src/DenseMatrix.cpp src/ExpressionCache.cpp src/parser.cpp src/Interval.cpp -o system_benchmark
+#include "NonlinearSystem.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+NonlinearSystem tridiagonal(int n) {
+    vector<string> equations, unknowns;
+    for (int i = 0; i < n; ++i) unknowns.push_back("u" + to_string(i));
+    for (int i = 0; i < n; ++i) {
+        string e = "(3-2*" + unknowns[i] + ")*" + unknowns[i];
+        if (i > 0) e += "-" + unknowns[i - 1];
+        if (i < n - 1) e += "-2*" + unknowns[i + 1];
+        equations.push_back(e + "+1");
+    }
+    return NonlinearSystem(equations, unknowns);
+}
+
+int main() {
+    const int repeats = 200;
+    cout << setw(4) << "N" << setw(10) << "method" << setw(7) << "iters"
+         << setw(7) << "F" << setw(7) << "J" << setw(12) << "residual" << setw(12) << "us/solve" << "\n";
+
+    for (int n : {2, 5, 10, 20}) {
+        NonlinearSystem system = tridiagonal(n);
+        vector<double> guess(n, -1.0);
+
+        for (SystemMethod method : {SystemMethod::Newton, SystemMethod::Broyden}) {
+            SystemOptions options;
+            options.method = method;
+
+            SystemResult r;
+            auto start = chrono::steady_clock::now();
+            for (int k = 0; k < repeats; ++k) r = system.solve(guess, options);
+            double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / repeats;
+
+            cout << setw(4) << n << setw(10) << (method == SystemMethod::Newton ? "Newton" : "Broyden")
+                 << setw(7) << r.iterations << setw(7) << r.functionEvaluations << setw(7) << r.jacobianEvaluations
+                 << setw(12) << scientific << setprecision(2) << r.residualNorm
+                 << setw(12) << fixed << setprecision(1) << us << "\n";
+        }
+    }
+    return 0;
+}
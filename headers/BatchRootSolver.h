@@ -0,0 +1,43 @@
+#ifndef BATCH_ROOT_SOLVER_H
+#define BATCH_ROOT_SOLVER_H
+
+#include <string>
+#include <vector>
+
+class EquationParser;
+
+enum class BatchMethod {
+    Newton,     // starts from a[i]; derivative by forward-mode differentiation
+    Secant,     // starts from a[i], b[i]
+    Bisection   // needs f(a[i]) and f(b[i]) of opposite sign
+};
+
+struct BatchRootOptions {
+    BatchMethod method = BatchMethod::Secant;
+    double xtol = 1e-12;   // stop a lane when its step (bracket for bisection) is this small
+    double ftol = 0.0;     // ... or when |f| is this small
+    int maxIterations = 100;
+};
+
+struct BatchRootResult {
+    std::vector<double> roots;
+    std::vector<double> values;        // f at each root
+    std::vector<int> iterations;       // per lane
+    std::vector<char> converged;       // per lane
+    long long evaluations = 0;         // lane evaluations over all lanes
+    double seconds = 0;
+    double rootsPerSecond = 0;
+};
+
+// Solve f(x; p) = 0 for many parameter sets at once.
+// Lane i uses parameter values params[k][i] (k in the parser's declaration
+// order). All lanes advance in lockstep: each iteration gathers the still
+// active lanes into contiguous arrays and evaluates them in one batched pass,
+// so converged lanes are masked out and cost nothing.
+BatchRootResult solveBatch(const EquationParser& f,
+                           const std::vector<double>& a,
+                           const std::vector<double>& b,
+                           const std::vector<std::vector<double>>& params,
+                           const BatchRootOptions& options = BatchRootOptions());
+
+#endif // BATCH_ROOT_SOLVER_H
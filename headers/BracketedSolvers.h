@@ -0,0 +1,51 @@
+#ifndef BRACKETED_SOLVERS_H
+#define BRACKETED_SOLVERS_H
+
+#include <functional>
+#include <string>
+
+// Outcome of a bracketed root search
+struct RootResult {
+    double root;
+    double value;       // f(root)
+    double a, b;        // final bracket
+    int iterations;
+    int evaluations;    // calls to f, including the two end points
+    bool converged;
+};
+
+// Stop when the bracket is at most xtol wide or |f| <= ftol
+struct RootOptions {
+    double xtol = 1e-12;
+    double ftol = 0.0;
+    int maxIterations = 200;
+};
+
+// All three need f(a) and f(b) of opposite sign (or one of them zero) and
+// throw std::invalid_argument otherwise; the root stays bracketed throughout.
+
+// Plain bisection, the reference for the two below
+RootResult bisectionRoot(const std::function<double(double)>& f, double a, double b,
+                         const RootOptions& options = RootOptions());
+
+// Brent's method: inverse quadratic / secant steps, falling back to bisection
+// whenever they do not shrink the bracket fast enough
+RootResult brentRoot(const std::function<double(double)>& f, double a, double b,
+                     const RootOptions& options = RootOptions());
+
+// ITP (Interpolate, Truncate, Project): regula falsi truncated towards the
+// midpoint and projected into a shrinking ball, never slower than bisection
+// in the worst case
+RootResult itpRoot(const std::function<double(double)>& f, double a, double b,
+                   const RootOptions& options = RootOptions());
+
+// Same, with f(x) given as an expression; served from the result cache
+// when one is enabled (ResultCache.h)
+RootResult bisectionRoot(const std::string& expr, double a, double b,
+                         const RootOptions& options = RootOptions());
+RootResult brentRoot(const std::string& expr, double a, double b,
+                     const RootOptions& options = RootOptions());
+RootResult itpRoot(const std::string& expr, double a, double b,
+                   const RootOptions& options = RootOptions());
+
+#endif // BRACKETED_SOLVERS_H
@@ -0,0 +1,60 @@
+#ifndef COLUMN_VIEW_H
+#define COLUMN_VIEW_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Read-only view of contiguous doubles, the C++17 stand-in for
+// std::span<const double>. It owns nothing: whoever hands one out keeps the
+// storage (a vector, a mapped file, a CsvTable) alive while it is used.
+class ColumnView {
+public:
+    ColumnView() : ptr(nullptr), count(0) {}
+    ColumnView(const double* data, std::size_t size) : ptr(data), count(size) {}
+    ColumnView(const std::vector<double>& v) : ptr(v.data()), count(v.size()) {}
+
+    const double* data() const { return ptr; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const double& operator[](std::size_t i) const { return ptr[i]; }
+    const double* begin() const { return ptr; }
+    const double* end() const { return ptr + count; }
+
+    // Elements [offset, offset + length), clipped to the view
+    ColumnView subview(std::size_t offset, std::size_t length = std::size_t(-1)) const {
+        if (offset > count) throw std::out_of_range("View offset past the end");
+        return ColumnView(ptr + offset, std::min(length, count - offset));
+    }
+
+private:
+    const double* ptr;
+    std::size_t count;
+};
+
+// The data a fitter or interpolator keeps: either a view of the caller's
+// storage, read in place, or its own copy of a vector. The copy is shared
+// between copies of the owner, so views into it never dangle.
+class ColumnData {
+public:
+    ColumnData(ColumnView v) : view(v) {}
+    ColumnData(std::vector<double> v)
+        : storage(std::make_shared<const std::vector<double>>(std::move(v))), view(*storage) {}
+
+    operator ColumnView() const { return view; }
+    const double* data() const { return view.data(); }
+    std::size_t size() const { return view.size(); }
+    const double& operator[](std::size_t i) const { return view[i]; }
+    const double* begin() const { return view.begin(); }
+    const double* end() const { return view.end(); }
+    std::vector<double> toVector() const { return std::vector<double>(begin(), end()); }
+
+private:
+    std::shared_ptr<const std::vector<double>> storage;
+    ColumnView view;
+};
+
+#endif // COLUMN_VIEW_H
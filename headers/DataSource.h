@@ -0,0 +1,62 @@
+#ifndef DATA_SOURCE_H
+#define DATA_SOURCE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ColumnView.h"
+
+class MappedFile;
+
+enum class ColumnType { Float64, Float32 };
+
+// Raw binary columns in native byte order, stored one after another
+// (all of column 0, then all of column 1, ...). The file is memory-mapped:
+// float64 columns are views straight into the mapping, float32 columns are
+// widened to double once when the file is opened.
+class ColumnFile {
+public:
+    explicit ColumnFile(const std::string& path, int columns = 1, ColumnType type = ColumnType::Float64);
+    ~ColumnFile();
+
+    ColumnFile(const ColumnFile&) = delete;
+    ColumnFile& operator=(const ColumnFile&) = delete;
+
+    std::size_t rows() const { return rowCount; }
+    int columns() const { return columnCount; }
+    ColumnView column(int index) const;   // valid while the ColumnFile lives
+
+private:
+    std::unique_ptr<MappedFile> file;
+    std::vector<double> widened;          // float32 files only
+    const double* values;                 // the mapping or `widened`
+    std::size_t rowCount;
+    int columnCount;
+};
+
+// A delimited text file of numbers, parsed into one contiguous column per
+// field. The file is memory-mapped and split at line boundaries across
+// threads, which each parse their share with std::from_chars straight into
+// the final columns. A first line that is not all numbers is taken as the
+// column names. Empty lines are skipped; a malformed field or a short row
+// throws std::runtime_error naming the line.
+class CsvTable {
+public:
+    // threads <= 0 uses every hardware thread
+    explicit CsvTable(const std::string& path, char delimiter = ',', int threads = 0);
+
+    std::size_t rows() const { return rowCount; }
+    int columns() const { return int(data.size()); }
+    const std::vector<std::string>& names() const { return header; }   // empty without a header line
+
+    ColumnView column(int index) const;   // valid while the CsvTable lives
+    ColumnView column(const std::string& name) const;
+
+private:
+    std::vector<std::string> header;
+    std::vector<std::vector<double>> data;
+    std::size_t rowCount;
+};
+
+#endif // DATA_SOURCE_H
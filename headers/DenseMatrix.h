@@ -0,0 +1,81 @@
+#ifndef DENSE_MATRIX_H
+#define DENSE_MATRIX_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Allocator returning storage aligned to `Alignment` bytes
+template <typename T, std::size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+    template <typename U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// Dense row-major matrix in one contiguous block.
+// Rows are padded to a whole cache line so every row starts 64-byte aligned.
+class DenseMatrix {
+public:
+    static const std::size_t kAlignment = 64;
+
+    DenseMatrix();
+    DenseMatrix(int rows, int cols, double value = 0.0);
+
+    int rows() const { return nRows; }
+    int cols() const { return nCols; }
+    std::size_t stride() const { return ld; }   // distance between rows, in doubles
+
+    double& operator()(int i, int j) { return values[i * ld + j]; }
+    double operator()(int i, int j) const { return values[i * ld + j]; }
+    double* row(int i) { return values.data() + i * ld; }
+    const double* row(int i) const { return values.data() + i * ld; }
+
+    void resize(int rows, int cols, double value = 0.0);
+    void fill(double value);
+    void swapRows(int i, int j);
+
+    DenseMatrix transposed() const;
+    std::vector<double> multiply(const std::vector<double>& v) const;
+
+private:
+    int nRows, nCols;
+    std::size_t ld;
+    std::vector<double, AlignedAllocator<double, kAlignment>> values;
+};
+
+// LU factorization with partial pivoting, P A = L U.
+// The factorization is blocked: panels of columns are factored one at a time
+// and the trailing matrix is updated with a cache-friendly matrix product.
+class LUDecomposition {
+public:
+    explicit LUDecomposition(const DenseMatrix& A);
+
+    std::vector<double> solve(const std::vector<double>& b) const;
+    void solveInPlace(double* b) const;
+    double determinant() const;
+
+    const DenseMatrix& factors() const { return LU; }    // L below the diagonal (unit), U on and above
+    const std::vector<int>& pivots() const { return perm; }
+
+private:
+    DenseMatrix LU;
+    std::vector<int> perm;   // row i of P A is row perm[i] of A
+    int swaps;
+
+    void factorPanel(int k0, int width);
+};
+
+#endif // DENSE_MATRIX_H
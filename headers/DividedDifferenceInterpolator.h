@@ -6,6 +6,8 @@
 #include <string>
 #include <cmath>
 #include <limits>
+#include <vector>
+#include "ColumnView.h"
 
 class divide {
 public:
@@ -15,11 +17,20 @@ public:
     void askXX();     // asks for x at which you want to calculate y
     void diffTable(); // calculate and display table
     void calcP();     // calculate and display the desired y
-    divide();
+    std::vector<double> coefficients() const; // monomial coefficients of P(n-1)
+    divide();   // prompts for the points and X, prints the table and P(X)
+
+    // The same points given directly (2 to 20 distinct x values), no output
+    divide(ColumnView xValues, ColumnView yValues);
+    double evaluate(double at); // P(n-1) at `at`, through the difference table
 
 private:
     double XX, x[20], f[20][20], P1;
     int n;
+
+    bool forward() const;     // forward table when XX is nearer x[0]
+    void buildTable();        // differences of f[0] for the current XX
+    double interpolate() const;
 };
 
 // Helper function declaration
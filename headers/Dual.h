@@ -0,0 +1,57 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+
+// Dual number v + d*eps (eps^2 = 0) for forward-mode differentiation:
+// evaluating f on Dual(x, 1) yields f(x) in v and f'(x) in d.
+template <typename T>
+struct Dual {
+    T v, d;
+
+    Dual() : v(0), d(0) {}
+    Dual(T value) : v(value), d(0) {}
+    Dual(T value, T derivative) : v(value), d(derivative) {}
+};
+
+template <typename T> Dual<T> operator+(const Dual<T>& a, const Dual<T>& b) { return Dual<T>(a.v + b.v, a.d + b.d); }
+template <typename T> Dual<T> operator-(const Dual<T>& a, const Dual<T>& b) { return Dual<T>(a.v - b.v, a.d - b.d); }
+template <typename T> Dual<T> operator-(const Dual<T>& a) { return Dual<T>(-a.v, -a.d); }
+template <typename T> Dual<T> operator*(const Dual<T>& a, const Dual<T>& b) { return Dual<T>(a.v * b.v, a.d * b.v + a.v * b.d); }
+template <typename T> Dual<T> operator/(const Dual<T>& a, const Dual<T>& b) {
+    T q = a.v / b.v;
+    return Dual<T>(q, (a.d - q * b.d) / b.v);
+}
+
+template <typename T> Dual<T> sin(const Dual<T>& a)  { using std::sin; using std::cos; return Dual<T>(sin(a.v), a.d * cos(a.v)); }
+template <typename T> Dual<T> cos(const Dual<T>& a)  { using std::sin; using std::cos; return Dual<T>(cos(a.v), -(a.d * sin(a.v))); }
+template <typename T> Dual<T> tan(const Dual<T>& a)  { using std::tan; T t = tan(a.v); return Dual<T>(t, a.d * (T(1) + t * t)); }
+template <typename T> Dual<T> asin(const Dual<T>& a) { using std::asin; using std::sqrt; return Dual<T>(asin(a.v), a.d / sqrt(T(1) - a.v * a.v)); }
+template <typename T> Dual<T> acos(const Dual<T>& a) { using std::acos; using std::sqrt; return Dual<T>(acos(a.v), -(a.d / sqrt(T(1) - a.v * a.v))); }
+template <typename T> Dual<T> atan(const Dual<T>& a) { using std::atan; return Dual<T>(atan(a.v), a.d / (T(1) + a.v * a.v)); }
+template <typename T> Dual<T> sinh(const Dual<T>& a) { using std::sinh; using std::cosh; return Dual<T>(sinh(a.v), a.d * cosh(a.v)); }
+template <typename T> Dual<T> cosh(const Dual<T>& a) { using std::sinh; using std::cosh; return Dual<T>(cosh(a.v), a.d * sinh(a.v)); }
+template <typename T> Dual<T> tanh(const Dual<T>& a) { using std::tanh; T t = tanh(a.v); return Dual<T>(t, a.d * (T(1) - t * t)); }
+template <typename T> Dual<T> sqrt(const Dual<T>& a) { using std::sqrt; T s = sqrt(a.v); return Dual<T>(s, a.d / (T(2) * s)); }
+template <typename T> Dual<T> exp(const Dual<T>& a)  { using std::exp; T e = exp(a.v); return Dual<T>(e, a.d * e); }
+template <typename T> Dual<T> log(const Dual<T>& a)  { using std::log; return Dual<T>(log(a.v), a.d / a.v); }
+template <typename T> Dual<T> log10(const Dual<T>& a) {
+    using std::log; using std::log10;
+    return Dual<T>(log10(a.v), a.d / (a.v * log(T(10))));
+}
+
+// Piecewise: the derivative of the active piece (0 on the flat steps of floor/ceil)
+template <typename T> Dual<T> fabs(const Dual<T>& a)  { return (a.v < T(0)) ? -a : a; }
+template <typename T> Dual<T> floor(const Dual<T>& a) { using std::floor; return Dual<T>(floor(a.v)); }
+template <typename T> Dual<T> ceil(const Dual<T>& a)  { using std::ceil; return Dual<T>(ceil(a.v)); }
+
+// a^b; the log term is only needed when the exponent itself varies
+template <typename T> Dual<T> pow(const Dual<T>& a, const Dual<T>& b) {
+    using std::pow; using std::log;
+    T p = pow(a.v, b.v);
+    T d = (b.v == T(0)) ? T(0) : b.v * pow(a.v, b.v - T(1)) * a.d;
+    if (!(b.d == T(0))) d = d + p * log(a.v) * b.d;
+    return Dual<T>(p, d);
+}
+
+#endif // DUAL_H
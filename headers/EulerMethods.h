@@ -1,25 +1,77 @@
 #ifndef EULER_METHODS_H
 #define EULER_METHODS_H
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
+class EquationParser;
+struct EulerWorkspace;
+
+struct EnsembleOptions
+{
+    std::vector<std::string> parameterNames;       // parameters the equation uses, e.g. {"k"}
+    std::vector<std::vector<double>> parameters;   // parameters[k][i]: parameter k of trajectory i
+    int statsEvery = 0;   // mean and variance every this many steps (0: after the last step only)
+    int threads = 0;      // 0: one per hardware thread
+};
+
+struct EnsembleResult
+{
+    std::vector<double> finalY;           // every trajectory after the last step
+    std::vector<double> x;                // where the statistics were taken
+    std::vector<double> mean, variance;   // across the trajectories at each x (sample variance)
+    double seconds = 0;
+    double stepsPerSecond = 0;            // trajectory steps
+};
+
+// Explicit one-step solvers for y' = f(x, y); subclasses supply the step
 class EulerMethod
 {
 public:
-    virtual void solve(const std::string& equation, double x0, double y0, double h, int steps) = 0;
+    // Prints the table of steps
+    void solve(const std::string& equation, double x0, double y0, double h, int steps);
+    // y after `steps` steps, without output
+    double integrate(const std::string& equation, double x0, double y0, double h, int steps) const;
+
+    // One trajectory per entry of y0, all from x0 with the same step. The
+    // trajectories are split into chunks of contiguous y values; each step
+    // evaluates f over a whole chunk in one batched pass, and threads take
+    // chunks in turn. finalY[i] matches integrate() from y0[i] exactly, and
+    // the statistics do not depend on the number of threads. Where integrate()
+    // would throw for a domain error, the batched pass yields NaN/inf instead,
+    // so any trajectory that turns non-finite (overflow included) throws
+    // runtime_error naming the lowest such trajectory; trajectories starting
+    // from a non-finite y0 are left as they are.
+    EnsembleResult integrateEnsemble(const std::string& equation, double x0, const std::vector<double>& y0,
+                                     double h, int steps, const EnsembleOptions& options = EnsembleOptions()) const;
     virtual ~EulerMethod() {}
+
+protected:
+    virtual const char* name() const = 0;
+    // y at x + h from y at x
+    virtual double step(const EquationParser& f, double x, double y, double h) const = 0;
+    // The same step for y[0..n) in place
+    virtual void stepBatch(const EquationParser& f, double x, double h, double* y, std::size_t n,
+                           EulerWorkspace& work) const = 0;
 };
 
 class BasicEuler : public EulerMethod
 {
-public:
-    void solve(const std::string& equation, double x0, double y0, double h, int steps) override;
+protected:
+    const char* name() const override { return "Basic Euler Method"; }
+    double step(const EquationParser& f, double x, double y, double h) const override;
+    void stepBatch(const EquationParser& f, double x, double h, double* y, std::size_t n,
+                   EulerWorkspace& work) const override;
 };
 
 class ModifiedEuler : public EulerMethod
 {
-public:
-    void solve(const std::string& equation, double x0, double y0, double h, int steps) override;
+protected:
+    const char* name() const override { return "Modified Euler Method"; }
+    double step(const EquationParser& f, double x, double y, double h) const override;
+    void stepBatch(const EquationParser& f, double x, double h, double* y, std::size_t n,
+                   EulerWorkspace& work) const override;
 };
 
 #endif // EULER_METHODS_H
@@ -0,0 +1,69 @@
+#ifndef EXPRESSION_CACHE_H
+#define EXPRESSION_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "parser.h"
+
+struct ExpressionCacheStats {
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+};
+
+// Thread-safe LRU cache of compiled expressions.
+// A parser is shared read-only once compiled: its evaluate* methods are const
+// and safe to call from several threads, so every caller asking for the same
+// expression gets the same instance and tokenizing / shunting-yard run once
+// per distinct expression. Keys are the expression with insignificant
+// whitespace removed, plus the x/y flag, the declared parameter names and the
+// user-function generation, so redefining a function never serves a stale
+// program.
+class ExpressionCache {
+public:
+    using Compiled = std::shared_ptr<const EquationParser>;
+
+    explicit ExpressionCache(std::size_t capacity = 1024);
+
+    // The process-wide instance used by the solvers
+    static ExpressionCache& global();
+
+    // Compile on a miss; parse errors propagate and nothing is cached
+    Compiled get(const std::string& expression, bool allowXY = false,
+                 const std::vector<std::string>& parameters = {});
+
+    ExpressionCacheStats stats() const;
+    void setCapacity(std::size_t capacity);
+    void clear();   // drops the entries and resets the counters
+
+    // The key text: blanks dropped where they cannot change the tokens. Only
+    // the key; the caller's own text is what gets parsed.
+    static std::string normalize(const std::string& expression);
+
+private:
+    struct Entry {
+        std::string key;
+        Compiled parser;
+    };
+
+    mutable std::mutex access;
+    std::list<Entry> entries;   // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::size_t limit;
+    long long hits, misses, evictions;
+
+    void trim();
+};
+
+// ExpressionCache::global().get(...)
+ExpressionCache::Compiled compileExpression(const std::string& expression, bool allowXY = false,
+                                            const std::vector<std::string>& parameters = {});
+
+#endif // EXPRESSION_CACHE_H
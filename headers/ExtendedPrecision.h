@@ -0,0 +1,69 @@
+#ifndef EXTENDED_PRECISION_H
+#define EXTENDED_PRECISION_H
+
+#include <vector>
+#include "Precision.h"
+
+class EquationParser;
+
+// Precision-generic kernels for interpolation, integration and fitting.
+// They are explicitly instantiated (ExtendedPrecision.cpp) for double, long
+// double and, with NUMERICAL_FLOAT128, __float128. The double versions back
+// LagrangeInterpolator and NumericalIntegrator, so that path is unchanged.
+// The wider ones are for problems where double loses most of its digits,
+// such as high-degree interpolation or ill-conditioned fits.
+
+// Lagrange form evaluated directly, as in LagrangeInterpolator::interpolateY
+template <typename T>
+T lagrangeValue(const std::vector<T>& x, const std::vector<T>& y, T at);
+template <typename T>
+T lagrangeValue(const T* x, const T* y, std::size_t n, T at);
+
+// Interpolating polynomial in Newton form (divided differences)
+template <typename T>
+class NewtonInterpolant {
+public:
+    NewtonInterpolant(const std::vector<T>& x, const std::vector<T>& y);
+
+    T evaluate(T at) const;
+    const std::vector<T>& newtonCoefficients() const { return c; }   // c[k] = f[x0..xk]
+    std::vector<T> coefficients() const;                              // monomial a[0..n-1]
+
+private:
+    std::vector<T> x, c;
+};
+
+enum class IntegrationRule { Trapezoidal, Simpson13, Simpson38 };
+
+// Composite rule over samples fx[0..n-1] spaced h apart (throws if the
+// number of intervals does not suit the rule)
+template <typename T>
+T compositeIntegral(const std::vector<T>& fx, T h, IntegrationRule rule);
+
+// The same with f sampled in precision T at `points` equally spaced points on [a, b]
+template <typename T>
+T integrateExpression(const EquationParser& f, T a, T b, int points, IntegrationRule rule);
+
+// Least-squares polynomial fit carried out entirely in precision T:
+// x is mapped onto [-1, 1] and the Vandermonde system solved by Householder QR
+template <typename T>
+class PrecisePolynomialFitter {
+public:
+    PrecisePolynomialFitter(const std::vector<T>& x, const std::vector<T>& y, int degree);
+
+    void fit();
+
+    const std::vector<T>& coefficients() const { return a; }        // in x
+    const std::vector<T>& scaledCoefficients() const { return b; }  // in t = (x - shift) / scale
+    T shift() const { return center; }
+    T scale() const { return halfWidth; }
+    T evaluate(T xValue) const;
+    T residualNorm() const { return residual; }
+
+private:
+    int N, n;
+    std::vector<T> x, y, a, b;
+    T center, halfWidth, residual;
+};
+
+#endif // EXTENDED_PRECISION_H
@@ -0,0 +1,127 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Counters, scoped timers and convergence records for the parser and the
+// solvers. The NUMERICAL_* macros below compile to nothing unless
+// NUMERICAL_INSTRUMENT is defined (CMake: -DNUMERICAL_INSTRUMENTATION=ON).
+//
+// Each thread counts into its own slots, so the hot path is a thread-local
+// add and two cycle-counter reads; a thread's totals are folded into the
+// process totals when it exits. When instrumentation is built in, a summary
+// goes to stderr at exit (NUMERICAL_INSTRUMENT_SUMMARY=<file> redirects it,
+// =0 turns it off) and NUMERICAL_CONVERGENCE_OUT=<file>.json|.csv saves the
+// convergence records.
+namespace instrumentation {
+
+struct Stat {
+    std::string name;
+    uint64_t calls;
+    double seconds;   // 0 for plain counters
+};
+
+// One iteration of a solver run
+struct ConvergenceRecord {
+    const char* solver;
+    long run;         // numbers the solver invocations of the process
+    int iteration;
+    double x;         // current estimate (first unknown for systems)
+    double residual;  // |f| or ||F||
+    double step;      // |x_k - x_(k-1)|, or the bracket width
+};
+
+constexpr bool enabled() {
+#ifdef NUMERICAL_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Totals over every thread, live or finished. Reading while other threads
+// are counting gives a consistent snapshot of each slot, not of the whole.
+std::vector<Stat> summary();
+std::vector<ConvergenceRecord> convergence();   // ordered by run, then iteration
+void reset();
+
+void writeSummary(std::ostream& os);
+void writeConvergenceJson(std::ostream& os);
+void writeConvergenceCsv(std::ostream& os);
+
+// ---- used by the macros ----
+
+int slot(const char* name);   // registers a name once per call site
+uint64_t ticks();             // cycle counter (steady_clock where there is none)
+
+struct Slot {
+    std::atomic<uint64_t> calls{0}, ticks{0};
+};
+Slot* threadSlots();          // this thread's slots, indexed by slot()
+
+inline void count(int id, uint64_t n) {
+    Slot& s = threadSlots()[id];
+    s.calls.store(s.calls.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(int slotId) : id(slotId), start(ticks()) {}
+    ~ScopedTimer() {
+        Slot& s = threadSlots()[id];
+        s.calls.store(s.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        s.ticks.store(s.ticks.load(std::memory_order_relaxed) + (ticks() - start), std::memory_order_relaxed);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    int id;
+    uint64_t start;
+};
+
+// Times one solver invocation and tags its convergence records
+class SolverScope {
+public:
+    SolverScope(int id, const char* solver);
+    void record(int iteration, double x, double residual, double step);
+
+private:
+    ScopedTimer timer;
+    const char* solver;
+    long run;
+};
+
+}
+
+#define NUMERICAL_CONCAT_(a, b) a##b
+#define NUMERICAL_CONCAT(a, b) NUMERICAL_CONCAT_(a, b)
+
+#ifdef NUMERICAL_INSTRUMENT
+// Time the rest of the enclosing scope under `name`
+#define NUMERICAL_TIMED(name)                                                                   \
+    static const int NUMERICAL_CONCAT(numerical_slot_, __LINE__) = ::instrumentation::slot(name); \
+    ::instrumentation::ScopedTimer NUMERICAL_CONCAT(numerical_timer_, __LINE__)(NUMERICAL_CONCAT(numerical_slot_, __LINE__))
+// Add n to the counter `name`
+#define NUMERICAL_COUNT(name, n)                                                    \
+    do {                                                                            \
+        static const int numerical_slot_ = ::instrumentation::slot(name);           \
+        ::instrumentation::count(numerical_slot_, static_cast<uint64_t>(n));        \
+    } while (0)
+// Declare `scope` timing this solver run; NUMERICAL_CONVERGENCE(scope, ...) records an iteration
+#define NUMERICAL_SOLVER(scope, name)                                                           \
+    static const int NUMERICAL_CONCAT(numerical_slot_, __LINE__) = ::instrumentation::slot(name); \
+    ::instrumentation::SolverScope scope(NUMERICAL_CONCAT(numerical_slot_, __LINE__), name)
+#define NUMERICAL_CONVERGENCE(scope, iteration, x, residual, step) (scope).record(iteration, x, residual, step)
+#else
+#define NUMERICAL_TIMED(name) ((void)0)
+#define NUMERICAL_COUNT(name, n) ((void)0)
+#define NUMERICAL_SOLVER(scope, name) ((void)0)
+#define NUMERICAL_CONVERGENCE(scope, iteration, x, residual, step) ((void)0)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,91 @@
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include <string>
+#include "Dual.h"
+#include "Precision.h"
+
+// Closed interval [lo, hi] of reals with outward rounding: every operation
+// widens its rounded-to-nearest result by one ulp on each side (two for the
+// library functions), so the true result over all points of the operands is
+// always enclosed. Functions are restricted to their domain (sqrt([-1, 4]) is
+// [0, 2]); an operation with no defined point gives the empty interval,
+// stored as NaN bounds, and division by an interval containing 0 gives
+// [-inf, inf].
+struct Interval {
+    double lo, hi;
+
+    Interval() : lo(0), hi(0) {}
+    Interval(double value) : lo(value), hi(value) {}
+    Interval(double lower, double upper) : lo(lower), hi(upper) {}
+
+    static Interval empty();
+    static Interval entire();
+
+    bool isEmpty() const { return !(lo <= hi); }
+    double width() const { return hi - lo; }
+    double mid() const;
+    bool contains(double v) const { return lo <= v && v <= hi; }
+    bool contains(const Interval& inner) const { return lo <= inner.lo && inner.hi <= hi; }
+    bool containsInInterior(const Interval& inner) const { return lo < inner.lo && inner.hi < hi; }
+};
+
+// identical bounds (not a comparison of the enclosed values)
+bool operator==(const Interval& a, const Interval& b);
+bool operator!=(const Interval& a, const Interval& b);
+
+Interval hull(const Interval& a, const Interval& b);
+Interval intersect(const Interval& a, const Interval& b);
+
+Interval operator+(const Interval& a, const Interval& b);
+Interval operator-(const Interval& a, const Interval& b);
+Interval operator-(const Interval& a);
+Interval operator*(const Interval& a, const Interval& b);
+Interval operator/(const Interval& a, const Interval& b);
+Interval& operator+=(Interval& a, const Interval& b);
+Interval& operator-=(Interval& a, const Interval& b);
+Interval& operator*=(Interval& a, const Interval& b);
+
+Interval sin(const Interval& a);
+Interval cos(const Interval& a);
+Interval tan(const Interval& a);
+Interval asin(const Interval& a);
+Interval acos(const Interval& a);
+Interval atan(const Interval& a);
+Interval sinh(const Interval& a);
+Interval cosh(const Interval& a);
+Interval tanh(const Interval& a);
+Interval sqrt(const Interval& a);
+Interval exp(const Interval& a);
+Interval log(const Interval& a);
+Interval log10(const Interval& a);
+Interval fabs(const Interval& a);
+Interval floor(const Interval& a);
+Interval ceil(const Interval& a);
+Interval pow(const Interval& a, const Interval& b);   // exact integer powers when b is a point integer
+
+// Comparisons over every pair of points: [1, 1] always true, [0, 0] never,
+// [0, 1] depends on the point
+Interval compareLess(const Interval& a, const Interval& b);
+Interval compareLessEqual(const Interval& a, const Interval& b);
+Interval compareEqual(const Interval& a, const Interval& b);
+Interval select(const Interval& condition, const Interval& a, const Interval& b);
+Interval minimum(const Interval& a, const Interval& b);
+Interval maximum(const Interval& a, const Interval& b);
+
+// |x| with a derivative enclosure that covers both slopes across 0
+Dual<Interval> fabs(const Dual<Interval>& a);
+
+// Literals read into the smallest interval certain to contain the decimal value
+template <> struct ScalarTraits<Interval> {
+    static const char* name() { return "interval"; }
+    static int digits() { return 17; }
+    static Interval parse(const std::string& text);
+    static std::string format(const Interval& v, int digits);
+};
+
+template <> struct ScalarTraits<Dual<Interval>> {
+    static Dual<Interval> parse(const std::string& text) { return Dual<Interval>(ScalarTraits<Interval>::parse(text)); }
+};
+
+#endif // INTERVAL_H
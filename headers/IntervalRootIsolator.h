@@ -0,0 +1,50 @@
+#ifndef INTERVAL_ROOT_ISOLATOR_H
+#define INTERVAL_ROOT_ISOLATOR_H
+
+#include <string>
+#include <vector>
+#include "Interval.h"
+
+class EquationParser;
+
+struct IsolationOptions {
+    double xtol = 1e-12;       // boxes narrower than xtol * max(1, |x|) are not split further
+    long maxBoxes = 200000;    // boxes examined before giving up on the rest
+    bool newton = true;        // interval Newton steps (smooth expressions only)
+};
+
+struct RootEnclosure {
+    double lo, hi;
+    bool unique;   // proved to hold exactly one root; otherwise it may hold any
+                   // number, including none (multiple roots, roots at a or b)
+};
+
+struct IsolationResult {
+    std::vector<RootEnclosure> enclosures;   // sorted and disjoint
+    int certifiedRoots = 0;                  // enclosures with unique set
+    bool complete = false;     // every enclosure is unique: f has exactly certifiedRoots roots in [a, b]
+    double excludedWidth = 0;  // total width proved free of roots
+    long boxes = 0;            // boxes examined
+};
+
+// Branch and bound over [a, b] with interval arithmetic. A box whose
+// enclosure of f excludes 0 is proved root-free and dropped without sampling.
+// Otherwise, when f' is enclosed away from 0, an interval Newton step
+// N = m - f(m) / f'(X) either shrinks the box or, if N lands inside it,
+// proves that it holds exactly one root, which is then contracted to a few
+// ulps. Boxes that stay undecided down to xtol are merged and reported
+// without the unique flag. Every claim holds despite rounding, unlike sign
+// tests on sampled points.
+IsolationResult isolateRoots(const EquationParser& parser, double a, double b,
+                             const IsolationOptions& options = IsolationOptions());
+IsolationResult isolateRoots(const std::string& expr, double a, double b,
+                             const IsolationOptions& options = IsolationOptions());
+
+// Guaranteed bounds on f over [a, b] and on its integral, from the interval
+// enclosures over `pieces` equal subintervals (tighter with more pieces).
+// Points where f is undefined are left out of the range; the integral throws
+// if a whole piece is undefined.
+Interval rangeEnclosure(const EquationParser& parser, double a, double b, int pieces = 64);
+Interval integralEnclosure(const EquationParser& parser, double a, double b, int pieces = 64);
+
+#endif // INTERVAL_ROOT_ISOLATOR_H
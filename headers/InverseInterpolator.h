@@ -0,0 +1,41 @@
+// InverseInterpolator.h
+#ifndef INVERSE_INTERPOLATOR_H
+#define INVERSE_INTERPOLATOR_H
+
+#include <vector>
+#include "ColumnView.h"
+
+// Answers y -> x queries on tabulated data.
+// The data is split into monotone runs of y; each run gets a shape-preserving
+// (Fritsch-Carlson) cubic, so inside a run every y has exactly one preimage.
+class InverseInterpolator {
+public:
+    InverseInterpolator(ColumnView xData, ColumnView yData);
+
+    // Every x with p(x) = yValue, sorted ascending (empty if yValue is out of range)
+    std::vector<double> solve(double yValue) const;
+
+    // One solution list per query
+    std::vector<std::vector<double>> solve(const std::vector<double>& yValues) const;
+
+    // The piecewise cubic that solve() inverts
+    double evaluate(double xValue) const;
+
+private:
+    struct Run {
+        int first, last;   // node indices, first < last
+        bool increasing;
+        double yMin, yMax;
+    };
+
+    std::vector<double> x, y, d;   // nodes sorted by x, d = node slopes
+    std::vector<Run> runs;
+
+    void computeSlopes();
+    void buildRuns();
+    int locateSegment(const Run& run, double yValue) const;
+    double invertSegment(int k, double yValue) const;
+    double hermite(int k, double t, double* derivative) const;
+};
+
+#endif
@@ -2,18 +2,36 @@
 #ifndef LAGRANGE_INTERPOLATOR_H
 #define LAGRANGE_INTERPOLATOR_H
 
+#include <memory>
 #include <vector>
+#include "ColumnView.h"
+#include "InverseInterpolator.h"
 
 class LagrangeInterpolator {
 public:
     LagrangeInterpolator(const std::vector<double>& xData, const std::vector<double>& yData);
+    // Reads the data in place; it must outlive the interpolator
+    LagrangeInterpolator(ColumnView xData, ColumnView yData);
 
     double interpolateY(double xValue) const;
-    double interpolateX(double yValue) const;
+
+    // Monomial coefficients a[0..n-1] of the interpolating polynomial
+    std::vector<double> coefficients() const;
+
+    // Inverse queries go through monotone local segments, not the global
+    // polynomial, so they stay stable when y turns or repeats. The segments
+    // are built on the first inverse query, which throws if the data cannot
+    // be inverted (fewer than two points, repeated x).
+    double interpolateX(double yValue) const;                        // smallest solution
+    std::vector<double> interpolateXAll(double yValue) const;        // every solution
+    std::vector<std::vector<double>> interpolateX(const std::vector<double>& yValues) const;
 
 private:
-    std::vector<double> x;
-    std::vector<double> y;
+    ColumnData x;
+    ColumnData y;
+    mutable std::shared_ptr<const InverseInterpolator> inverse;   // built on first use
+
+    const InverseInterpolator& inverted() const;
 };
 
 #endif
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include "DenseMatrix.h"
+
+// Least squares by incremental Householder QR.
+// Blocks of rows are folded into an upper-triangular factor R together with
+// the transformed right-hand side Q^T b, so the whole design matrix never has
+// to exist at once and the condition number is not squared as in the normal
+// equations.
+class QRLeastSquares {
+public:
+    explicit QRLeastSquares(int columns);
+
+    // Fold `rows` rows into the factorization.
+    // At is the block transposed (columns x rows, so each column of A is a
+    // contiguous row of At); it is used as scratch and overwritten.
+    // b holds the rows' right-hand sides.
+    void addRows(DenseMatrix& At, double* b, int rows);
+
+    // Fold in another factorization of the same width, as if its rows had
+    // been added here (used to combine per-thread partial fits)
+    void merge(const QRLeastSquares& other);
+
+    // Solve R c = Q^T b (throws if R is singular)
+    std::vector<double> solve() const;
+
+    // ||A c - b||_2 of the rows folded so far
+    double residualNorm() const;
+
+    // 1-norm condition number of R, which estimates that of A
+    double conditionEstimate() const;
+
+    int columns() const { return n; }
+    long long rows() const { return count; }
+
+private:
+    int n;
+    long long count;
+    DenseMatrix R;             // n x n upper triangle
+    std::vector<double> qtb;   // first n entries of Q^T b
+    double residualSq;
+};
@@ -0,0 +1,71 @@
+#ifndef NONLINEAR_SYSTEM_H
+#define NONLINEAR_SYSTEM_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "DenseMatrix.h"
+#include "ExpressionCache.h"
+
+enum class SystemMethod {
+    Newton,    // exact Jacobian every iteration
+    Broyden    // exact Jacobian once, then rank-1 secant updates
+};
+
+struct SystemOptions {
+    SystemMethod method = SystemMethod::Newton;
+    double ftol = 1e-12;       // stop when max |F_i| <= ftol
+    double xtol = 1e-14;       // ... or when the step is below xtol * (1 + |v|), in the max norm
+    int maxIterations = 100;
+    bool lineSearch = true;    // backtrack on 0.5 |F|^2 so every step makes progress
+};
+
+struct SystemResult {
+    std::vector<double> solution;
+    std::vector<double> residual;   // F at the solution
+    double residualNorm;            // max |F_i|
+    int iterations;
+    int functionEvaluations;        // F evaluations, not counting Jacobians
+    int jacobianEvaluations;
+    bool converged;
+};
+
+// A square system F(v) = 0 of N equations in N unknowns.
+// Built from expressions, the Jacobian is exact (forward-mode differentiation
+// of each equation); built from a callback without one, it is approximated by
+// forward differences.
+class NonlinearSystem {
+public:
+    using Function = std::function<void(const std::vector<double>& v, std::vector<double>& F)>;
+    using Jacobian = std::function<void(const std::vector<double>& v, DenseMatrix& J)>;
+
+    // Equations are expressions in the unknowns, either "lhs = rhs" or an
+    // expression meant to be zero. `constants` binds other names used in them.
+    NonlinearSystem(const std::vector<std::string>& equations,
+                    const std::vector<std::string>& unknowns,
+                    const std::map<std::string, double>& constants = {});
+    NonlinearSystem(int size, Function F, Jacobian J = nullptr);
+
+    int size() const { return n; }
+    const std::vector<std::string>& unknowns() const { return names; }
+
+    void evaluate(const std::vector<double>& v, std::vector<double>& F) const;
+    void jacobian(const std::vector<double>& v, DenseMatrix& J) const;
+
+    SystemResult solve(const std::vector<double>& guess,
+                       const SystemOptions& options = SystemOptions()) const;
+
+private:
+    int n;
+    std::vector<std::string> names;
+    std::vector<ExpressionCache::Compiled> equations;
+    std::vector<int> slot;               // unknown j -> 0 (x), 1 (y) or 2 + parameter index
+    std::vector<double> parameterValues; // unknowns first, then the constants
+    Function callback;
+    Jacobian callbackJacobian;
+
+    void load(const std::vector<double>& v, double& x, double& y, std::vector<double>& params) const;
+};
+
+#endif // NONLINEAR_SYSTEM_H
@@ -1,25 +1,66 @@
 #pragma once
 #include <vector>
+#include "ColumnView.h"
+#include "WeightedLeastSquares.h"
 
 class PolynomialFitter {
 public:
-    // Construct with data points and desired degree
+    // Construct with data points and desired degree.
+    // With scaleX, x is mapped onto [-1, 1] before fitting, which keeps the
+    // Vandermonde columns well conditioned for higher degrees.
     PolynomialFitter(const std::vector<double>& x,
                      const std::vector<double>& y,
-                     int degree);
+                     int degree,
+                     bool scaleX = true);
 
-    // Fit the polynomial (runs the normal-equation solver)
+    // Fit data read in place (e.g. a ColumnFile or CsvTable column), without
+    // copying it; the data must outlive the fitter
+    PolynomialFitter(ColumnView x, ColumnView y, int degree, bool scaleX = true);
+
+    // Fit the polynomial (Householder QR on the Vandermonde matrix); served
+    // from the result cache when one is enabled (ResultCache.h)
     void fit();
 
-    // Retrieve coefficients a[0..degree]
+    // Per-point weights for fit() and fitRobust(), e.g. 1 / sigma^2
+    void setWeights(const std::vector<double>& w);
+
+    // Iteratively reweighted fit that down-weights outliers
+    // (tuning <= 0 picks the usual default for the loss)
+    void fitRobust(RobustLoss loss = RobustLoss::Huber, double tuning = 0.0,
+                   int maxIterations = 50);
+
+    // Final weight of every point after fitRobust (0 = rejected by Tukey)
+    const std::vector<double>& robustWeights() const;
+
+    // Retrieve coefficients a[0..degree] of y = sum a[k] x^k
     const std::vector<double>& coefficients() const;
 
+    // Coefficients in the scaled variable t = (x - shift) / scale; evaluating
+    // through these is more accurate than through coefficients()
+    const std::vector<double>& scaledCoefficients() const;
+    double shift() const { return center; }
+    double scale() const { return halfWidth; }
+    double evaluate(double xValue) const;
+
+    // Real roots and critical points of the fitted polynomial (found in the
+    // scaled variable, then mapped back to x)
+    std::vector<double> roots() const;
+    std::vector<double> extrema() const;
+
+    // Fit diagnostics
+    double residualNorm() const;        // ||V a - y||_2
+    double conditionEstimate() const;   // 1-norm condition of the (scaled) Vandermonde matrix
+
 private:
     int N, n;                              // N = # data points, n = degree
-    std::vector<double> x, y, a;           // data & solution
-    std::vector<std::vector<double>> B;    // augmented normal‐equation matrix
+    ColumnData x, y;                       // data
+    std::vector<double> a, b;              // solution in x and in t
+    std::vector<double> w, finalW;         // user weights, weights after IRLS
+    double center, halfWidth;              // t = (x - center) / halfWidth
+    double residual, condition;
 
-    void buildNormalMatrix();
-    void gaussianElimination();
-    void backSubstitution();
+    PolynomialFitter(ColumnData x, ColumnData y, int degree, bool scaleX);
+    void computeScaling(bool scaleX);
+    DenseMatrix designMatrix() const;      // Vandermonde in t, transposed
+    void store(const WeightedLeastSquares& solver, const std::vector<double>& coeffs);
 };
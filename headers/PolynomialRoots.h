@@ -0,0 +1,66 @@
+#ifndef POLYNOMIAL_ROOTS_H
+#define POLYNOMIAL_ROOTS_H
+
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// Polynomials are given by coefficients a[0..n] of sum a[k] x^k, the same
+// order PolynomialFitter::coefficients() returns.
+
+// All n complex roots (with multiplicity) by Aberth-Ehrlich simultaneous
+// iteration, each polished with Newton steps on Horner evaluation.
+// Sorted by real part, then imaginary part.
+std::vector<std::complex<double>> polynomialRoots(const std::vector<double>& a,
+                                                  int maxIterations = 200);
+
+// The real ones among them (|imag| <= imagTol * max(1, |root|)), sorted
+std::vector<double> realPolynomialRoots(const std::vector<double>& a,
+                                        double imagTol = 1e-8);
+
+// Real critical points: real roots of the derivative
+std::vector<double> polynomialExtrema(const std::vector<double>& a,
+                                      double imagTol = 1e-8);
+
+std::vector<double> polynomialDerivative(const std::vector<double>& a);
+
+// Newton coefficients c[k] = f[x0..xk] of the points (x[i], c[i]), by
+// divided differences built in place over c. Nodes is anything indexable
+// (a vector, a ColumnView); throws if two x values coincide.
+template <typename T, typename Nodes>
+void dividedDifferences(const Nodes& x, std::vector<T>& c) {
+    int n = int(c.size());
+    for (int k = 1; k < n; ++k)
+        for (int i = n - 1; i >= k; --i) {
+            T dx = x[i] - x[i - k];
+            if (dx == 0) throw std::invalid_argument("x values must be distinct");
+            c[i] = (c[i] - c[i - 1]) / dx;
+        }
+}
+
+// Monomial coefficients of the Newton form
+// c[0] + c[1](x - x0) + c[2](x - x0)(x - x1) + ...
+// in any precision (see ExtendedPrecision.h)
+template <typename T>
+std::vector<T> newtonToMonomial(const std::vector<T>& nodes, const std::vector<T>& c) {
+    if (c.empty()) return std::vector<T>();
+    if (nodes.size() + 1 < c.size())
+        throw std::invalid_argument("Need a node for every Newton coefficient but the last");
+
+    // Horner on the Newton form: p <- p (x - nodes[k]) + c[k]
+    int n = int(c.size()) - 1;
+    std::vector<T> p(1, c[n]);
+    for (int k = n - 1; k >= 0; --k) {
+        std::vector<T> next(p.size() + 1, T(0));
+        for (std::size_t j = 0; j < p.size(); ++j) {
+            next[j + 1] += p[j];
+            next[j] -= p[j] * nodes[k];
+        }
+        next[0] += c[k];
+        p.swap(next);
+    }
+    return p;
+}
+
+#endif // POLYNOMIAL_ROOTS_H
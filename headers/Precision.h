@@ -0,0 +1,79 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Scalar types the precision-generic code is instantiated for: double and
+// long double always, and GCC's software __float128 (113-bit mantissa) when
+// built with -DNUMERICAL_FLOAT128 and linked with -lquadmath.
+#ifdef NUMERICAL_FLOAT128
+#include <quadmath.h>
+
+// <cmath>-style overloads, so generic code calling sin(v), pow(a, b), ...
+// (after `using std::sin;` and `using ::sin;`) also accepts __float128
+inline __float128 sin(__float128 v)   { return sinq(v); }
+inline __float128 cos(__float128 v)   { return cosq(v); }
+inline __float128 tan(__float128 v)   { return tanq(v); }
+inline __float128 asin(__float128 v)  { return asinq(v); }
+inline __float128 acos(__float128 v)  { return acosq(v); }
+inline __float128 atan(__float128 v)  { return atanq(v); }
+inline __float128 sinh(__float128 v)  { return sinhq(v); }
+inline __float128 cosh(__float128 v)  { return coshq(v); }
+inline __float128 tanh(__float128 v)  { return tanhq(v); }
+inline __float128 sqrt(__float128 v)  { return sqrtq(v); }
+inline __float128 exp(__float128 v)   { return expq(v); }
+inline __float128 log(__float128 v)   { return logq(v); }
+inline __float128 log10(__float128 v) { return log10q(v); }
+inline __float128 fabs(__float128 v)  { return fabsq(v); }
+inline __float128 floor(__float128 v) { return floorq(v); }
+inline __float128 ceil(__float128 v)  { return ceilq(v); }
+inline __float128 pow(__float128 a, __float128 b) { return powq(a, b); }
+#endif
+
+template <typename T> struct ScalarTraits;
+
+template <> struct ScalarTraits<double> {
+    static const char* name() { return "double"; }
+    static int digits() { return 15; }
+    static double parse(const std::string& text) { return std::strtod(text.c_str(), nullptr); }
+    static std::string format(double v, int digits) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof buffer, "%.*g", digits, v);
+        return buffer;
+    }
+};
+
+template <> struct ScalarTraits<long double> {
+    static const char* name() { return "long double"; }
+    static int digits() { return 18; }   // x87 80-bit; 15 where long double is double
+    static long double parse(const std::string& text) { return std::strtold(text.c_str(), nullptr); }
+    static std::string format(long double v, int digits) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof buffer, "%.*Lg", digits, v);
+        return buffer;
+    }
+};
+
+#ifdef NUMERICAL_FLOAT128
+template <> struct ScalarTraits<__float128> {
+    static const char* name() { return "__float128"; }
+    static int digits() { return 33; }
+    static __float128 parse(const std::string& text) { return strtoflt128(text.c_str(), nullptr); }
+    static std::string format(__float128 v, int digits) {
+        char buffer[80];
+        quadmath_snprintf(buffer, sizeof buffer, "%.*Qg", digits, v);
+        return buffer;
+    }
+};
+#endif
+
+// isfinite for every supported scalar
+template <typename T> inline bool isFiniteValue(T v) { using std::isfinite; return isfinite(v); }
+#ifdef NUMERICAL_FLOAT128
+template <> inline bool isFiniteValue(__float128 v) { return finiteq(v); }
+#endif
+
+#endif // PRECISION_H
@@ -0,0 +1,113 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Bumped whenever a solver may return different numbers for the same input,
+// so results cached by an older build are never served
+constexpr uint32_t kResultCacheVersion = 1;
+
+// 128-bit content address of one solver call: the method name, the
+// normalized expression and the exact bits of every input, plus
+// kResultCacheVersion
+class ResultKey {
+public:
+    explicit ResultKey(const char* method);
+
+    ResultKey& add(double value);
+    ResultKey& add(const double* values, std::size_t count);
+    ResultKey& add(const std::string& text);
+    ResultKey& addExpression(const std::string& expression);   // ExpressionCache::normalize'd
+
+    uint64_t high() const;
+    uint64_t low() const;
+
+private:
+    uint64_t h1, h2, length;
+    void mix(uint64_t word);
+};
+
+struct ResultCacheStats {
+    long long hits = 0;
+    long long misses = 0;
+    long long stores = 0;
+    long long evictions = 0;    // entries dropped by compaction
+    std::size_t entries = 0;
+    std::size_t bytes = 0;      // file size
+    std::size_t capacity = 0;
+
+    double hitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+};
+
+// Persistent memo of solver results, shared by every process that opens the
+// same file. The file is an append-only log of records (key, last-use stamp,
+// values) behind a small header. Each record is appended under a file lock
+// with a single write() and carries a checksum, so readers (who never lock)
+// skip a record still being written, and a torn record left by a crash is
+// dropped at the next compaction.
+// Lookups go through an in-memory index over a shared read-write mapping and
+// bump the record's stamp in place; records appended by other processes are
+// indexed on the next miss. When the file would outgrow its capacity it is
+// compacted into a fresh file holding the most recently used half, which is
+// renamed over the old one. POSIX only.
+class ResultCache {
+public:
+    explicit ResultCache(const std::string& path, std::size_t capacity = std::size_t(64) << 20);
+    ~ResultCache();
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // The cache named by NUMERICAL_RESULT_CACHE=<file>, or null when unset
+    // (or when the file cannot be opened, which is reported once on stderr).
+    // The solvers consult it before computing and fill it afterwards; a
+    // summary of its statistics goes to stderr at exit
+    // (NUMERICAL_RESULT_CACHE_SUMMARY=0 silences it).
+    static std::shared_ptr<ResultCache> global();
+    static void setGlobal(std::shared_ptr<ResultCache> cache);   // null disables
+    // global(), or null once user functions are defined: their definitions
+    // are not part of a key, so a cached value could be stale
+    static std::shared_ptr<ResultCache> globalForExpressions();
+
+    bool lookup(const ResultKey& key, std::vector<double>& values);
+    void store(const ResultKey& key, const std::vector<double>& values);
+
+    ResultCacheStats stats() const;
+    const std::string& path() const { return file; }
+    void clear();   // empties the file and resets the counters
+
+private:
+    struct Key {
+        uint64_t high, low;
+        bool operator==(const Key& other) const { return high == other.high && low == other.low; }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& k) const { return std::size_t(k.low); }
+    };
+
+    std::string file;
+    std::size_t limit;
+    mutable std::mutex access;
+    std::unordered_map<Key, std::size_t, KeyHash> index;   // key -> record offset
+    int fd;
+    uint64_t inode;
+    unsigned char* mapping;
+    std::size_t mappedLength, scanned;
+    uint64_t clock;
+    long long hits, misses, stores, evictions;
+
+    void open();
+    void close();
+    void scan();
+    bool reopenIfReplaced();
+    void lockFile();
+    void compact(std::size_t incoming);
+};
+
+#endif // RESULT_CACHE_H
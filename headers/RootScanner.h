@@ -0,0 +1,31 @@
+#ifndef ROOT_SCANNER_H
+#define ROOT_SCANNER_H
+
+#include <string>
+#include <vector>
+
+class EquationParser;
+
+struct RootScanOptions {
+    int samples = 1000;          // grid cells across [a, b]
+    double xtol = 1e-12;         // width each bracket is solved to
+    double tangentTol = 1e-10;   // |f| at a local extremum that counts as a (double) root,
+                                 // relative to max(1, max |f| on the grid)
+    int threads = 0;             // 0 = one per hardware thread
+};
+
+// Every root of f in [a, b], sorted, without duplicates.
+// f is sampled on a uniform grid in one batched pass; cells with a sign change
+// become brackets, and cells where f' changes sign are searched for the
+// extremum so that touching (even-multiplicity) roots and pairs of roots
+// inside one cell are not missed. Brackets are then solved in parallel with
+// Brent's method. Roots closer together than the grid spacing can still merge.
+// A sign change across a pole (tan(x) at pi/2) is not a root: a bracket is
+// dropped when |f| where Brent converges exceeds |f| at both of its ends, or
+// when f is undefined somewhere inside it.
+std::vector<double> findAllRoots(const EquationParser& parser, double a, double b,
+                                 const RootScanOptions& options = RootScanOptions());
+std::vector<double> findAllRoots(const std::string& expr, double a, double b,
+                                 const RootScanOptions& options = RootScanOptions());
+
+#endif // ROOT_SCANNER_H
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "ColumnView.h"
+
+// Savitzky-Golay smoothing and differentiation of evenly spaced samples.
+// Fitting a degree-n polynomial to each window of 2m+1 samples by least
+// squares and evaluating it (or a derivative) at the window centre is a
+// fixed linear combination of the window, so the weights are solved for once
+// per (window, degree, derivative) by the QR least-squares core and the
+// filter is then a single FIR pass over the signal. The first and last m
+// outputs evaluate the fit of the first and last whole window off centre,
+// instead of padding the signal.
+class SavitzkyGolayFilter {
+public:
+    // halfWindow = m (window of 2m+1 samples), degree < 2m+1,
+    // derivative <= degree; spacing is the sample step, for derivatives
+    SavitzkyGolayFilter(int halfWindow, int degree, int derivative = 0, double spacing = 1.0);
+
+    // out[i] = smoothed value or derivative at sample i; count must be at
+    // least the window and out must not overlap signal. The interior is
+    // split across `threads` threads (0: one per hardware thread).
+    void apply(const double* signal, double* out, std::size_t count, int threads = 1) const;
+    std::vector<double> apply(ColumnView signal, int threads = 1) const;
+
+    // Weights that evaluate at window position 0..2m of the window's fit;
+    // position m is the interior filter
+    const std::vector<double>& weights(int position) const { return table[position]; }
+    int window() const { return 2 * m + 1; }
+    int degree() const { return n; }
+
+private:
+    int m, n, d;
+    std::vector<std::vector<double>> table;   // one row per window position
+
+    void applyInterior(const double* signal, double* out, std::size_t begin, std::size_t end) const;
+};
@@ -0,0 +1,67 @@
+#ifndef SOLVER_SERVER_H
+#define SOLVER_SERVER_H
+
+#include <atomic>
+#include <iosfwd>
+#include <mutex>
+#include <set>
+#include <string>
+
+// A long-running solver process: requests arrive one per line, over stdin /
+// stdout or a Unix domain socket, and every request gets exactly one reply
+// line, in order, so a client may pipeline as many requests as it likes.
+// Compiled expressions stay in the process-wide ExpressionCache and the
+// quadrature tables stay built between requests. With NUMERICAL_RESULT_CACHE
+// set, root and fit results are also memoized on disk (ResultCache.h).
+//
+// Fields are separated by blanks; quote an expression that contains blanks.
+// Lists are comma separated. Optional settings are key=value with one of the
+// keys below, unquoted; a quoted field is always positional.
+//   root <expr> <a> <b> [method=brent|itp|bisection] [xtol=1e-12]
+//       -> ok <root> <f(root)> <iterations> <converged 0|1>
+//   integrate <expr> <a> <b> [tol=1e-8]                (a, b may be -inf / inf)
+//       -> ok <value> <error estimate> <evaluations>
+//   ode <f(x,y)> <x0> <y0> <h> <steps> [method=euler|modified]
+//       -> ok <y at x0 + steps h>
+//   fit <degree> <x1,x2,...> <y1,y2,...>              -> ok <a0> <a1> ... <a_degree>
+//   interpolate <x1,...> <y1,...> <at> [method=lagrange|newton]   -> ok <value>
+//   stats                                               -> ok requests=... errors=... cache_hits=...
+//                                                          (and result_hits=... with a result cache)
+//   ping                                                -> ok pong
+// A failed request answers "err <message>"; the connection stays open.
+class SolverServer {
+public:
+    SolverServer();
+
+    // The reply to one request line, without the newline. Thread-safe.
+    std::string handle(const std::string& request);
+
+    // Serve lines from `in` until end of input, flushing whenever no more
+    // input is already buffered
+    void serveStream(std::istream& in, std::ostream& out);
+
+    // Listen on `path` (replacing a stale socket file) until stop(), which
+    // also drops the open connections. The calling thread polls every
+    // connection and hands the complete lines that arrived on one to one of
+    // `threads` worker threads (0: one per hardware thread); that connection
+    // is not read again until they are answered, so its replies keep their
+    // order, and an idle connection holds no worker. A line longer than 1 MiB
+    // is answered with err and the connection closed. POSIX only.
+    void serveUnixSocket(const std::string& path, int threads = 0);
+    void stop();
+
+    long long requests() const { return requestCount; }
+    long long errors() const { return errorCount; }
+
+private:
+    std::atomic<long long> requestCount, errorCount;
+    std::atomic<bool> stopping;
+    std::atomic<int> listener;
+    std::atomic<int> wakeup;          // write end of the pipe that wakes the polling thread
+    std::mutex connectionLock;
+    std::set<int> connections;        // open client sockets, closed by stop()
+
+    std::string dispatch(const std::string& request);
+};
+
+#endif // SOLVER_SERVER_H
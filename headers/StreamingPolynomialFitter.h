@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "LeastSquares.h"
+
+// Single-pass polynomial least squares over data that arrives in chunks.
+// Only the (degree+1)^2 QR factor is kept, never the samples, and two
+// fitters built over disjoint data can be merged, so chunks can be
+// processed on separate threads.
+class StreamingPolynomialFitter {
+public:
+    // Without a domain x is used as is; with one, x is mapped from
+    // [xMin, xMax] onto [-1, 1] (recommended above degree ~8)
+    explicit StreamingPolynomialFitter(int degree);
+    StreamingPolynomialFitter(int degree, double xMin, double xMax);
+
+    // Fold count samples x[i*stride], y[i*stride] into the fit
+    void add(const double* x, const double* y, std::size_t count, std::size_t stride = 1);
+
+    // Same, splitting the samples across `threads` worker threads
+    void addParallel(const double* x, const double* y, std::size_t count,
+                     std::size_t stride, int threads);
+
+    // Memory-map a file of native float64 (x, y) pairs and fold it in
+    void addFile(const std::string& path, int threads = 1);
+
+    // Combine with a fitter of the same degree and domain
+    void merge(const StreamingPolynomialFitter& other);
+
+    // Results (solve the accumulated system on every call)
+    std::vector<double> coefficients() const;          // in powers of x
+    std::vector<double> scaledCoefficients() const;    // in powers of t = (x - shift) / scale
+    double shift() const { return center; }
+    double scale() const { return halfWidth; }
+    double residualNorm() const;
+    double conditionEstimate() const;
+    long long count() const;
+
+    // Expand sum b[k] ((x - center) / halfWidth)^k into powers of x, in any
+    // precision (see ExtendedPrecision.h)
+    template <typename T>
+    static std::vector<T> toMonomial(const std::vector<T>& b, T center, T halfWidth) {
+        std::vector<T> p(1, b.back());
+        for (int k = int(b.size()) - 2; k >= 0; --k) {
+            // p <- p * (x - center) / halfWidth + b[k]
+            std::vector<T> next(p.size() + 1, T(0));
+            for (std::size_t j = 0; j < p.size(); ++j) {
+                next[j + 1] += p[j] / halfWidth;
+                next[j] -= p[j] * center / halfWidth;
+            }
+            next[0] += b[k];
+            p.swap(next);
+        }
+        return p;
+    }
+
+private:
+    int n;                      // degree
+    double center, halfWidth;
+    QRLeastSquares qr;
+};
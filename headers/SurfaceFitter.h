@@ -0,0 +1,42 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "WeightedLeastSquares.h"
+
+// Least-squares polynomial surface z = sum c[k] x^i y^j over all i + j <= degree.
+// x and y are scaled to [-1, 1] internally; terms are ordered by total degree,
+// then by rising power of y: 1, x, y, x^2, xy, y^2, ...
+class SurfaceFitter {
+public:
+    SurfaceFitter(const std::vector<double>& x,
+                  const std::vector<double>& y,
+                  const std::vector<double>& z,
+                  int degree);
+
+    void fit();
+    void setWeights(const std::vector<double>& w);
+    void fitRobust(RobustLoss loss = RobustLoss::Huber, double tuning = 0.0,
+                   int maxIterations = 50);
+
+    // evaluate and coefficients throw std::logic_error before fit() or fitRobust()
+    double evaluate(double xValue, double yValue) const;
+
+    // Coefficients in powers of the original x and y, in term order
+    std::vector<double> coefficients() const;
+    // (i, j) exponents of every term
+    const std::vector<std::pair<int, int>>& terms() const { return exponents; }
+
+    double residualNorm() const { return residual; }
+    double conditionEstimate() const { return condition; }
+    const std::vector<double>& robustWeights() const { return finalW; }
+
+private:
+    int N, n;
+    std::vector<double> x, y, z, c, w, finalW;     // c is in the scaled variables
+    std::vector<std::pair<int, int>> exponents;
+    double cx, sx, cy, sy;                          // tx = (x - cx) / sx, ty = (y - cy) / sy
+    double residual, condition;
+
+    DenseMatrix designMatrix() const;
+    void store(const WeightedLeastSquares& solver, const std::vector<double>& coeffs);
+};
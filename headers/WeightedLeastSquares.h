@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include "DenseMatrix.h"
+
+// Loss functions for robust (IRLS) fitting
+enum class RobustLoss {
+    Huber,   // quadratic near zero, linear in the tails (default tuning 1.345)
+    Tukey    // biweight, rejects gross outliers entirely (default tuning 4.685)
+};
+
+// Least squares over a fixed design matrix with per-row weights.
+// The basis is evaluated once and the QR workspace is allocated once, so
+// each reweighting in an IRLS loop is only a scaling pass plus a
+// refactorization, never a rebuild of the design matrix.
+class WeightedLeastSquares {
+public:
+    // basisT is the design matrix transposed: row k holds basis function k
+    // at every sample
+    WeightedLeastSquares(DenseMatrix basisT, std::vector<double> y);
+
+    std::vector<double> solve();                                   // unweighted
+    std::vector<double> solve(const std::vector<double>& weights); // weights >= 0
+
+    // Iteratively reweighted least squares. priorWeights (may be empty) are
+    // multiplied into the robust weights; tuning <= 0 picks the default.
+    std::vector<double> solveRobust(RobustLoss loss, double tuning,
+                                    const std::vector<double>& priorWeights,
+                                    int maxIterations = 50, double tolerance = 1e-10);
+
+    // y - X c for every sample
+    std::vector<double> residuals(const std::vector<double>& c) const;
+
+    // Diagnostics of the last solve
+    double residualNorm() const { return residual; }          // weighted ||W^1/2 (X c - y)||
+    double conditionEstimate() const { return condition; }
+    const std::vector<double>& weights() const { return lastWeights; }
+    int iterations() const { return iterationCount; }
+
+private:
+    DenseMatrix basis;   // columns x N
+    DenseMatrix work;    // scaled copy handed to the QR solver
+    std::vector<double> y, rhs, lastWeights;
+    double residual, condition;
+    int iterationCount;
+};
@@ -9,8 +9,11 @@ class bisection{
         double a, b, tol;
         int maxIter;
     public:
-        bisection();
+        bisection();   // prompts for the inputs and solves
+        bisection(const string& expr, double a, double b, double tol, int maxIter);
         void get_input();
-        void bisection_solve();
+        // Root, or NaN if f(a) and f(b) have the same sign; verbose prints
+        // the iteration table (and the interval analysis when there is no sign change)
+        double bisection_solve(bool verbose = true);
 };
 #endif // BISECTION_H
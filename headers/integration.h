@@ -1,7 +1,7 @@
 #ifndef NUMERICAL_INTEGRATOR_H
 #define NUMERICAL_INTEGRATOR_H
 
-#include "parser.h"
+#include "ExpressionCache.h"
 #include <vector>
 #include <string>
 #include <iostream>
@@ -10,22 +10,34 @@
 
 class NumericalIntegrator {
 private:
-    EquationParser parser;
+    ExpressionCache::Compiled parser;
+    std::string equation;
     double a, b;
     int n;
     std::vector<double> x, fx;
     double h;
 
-    double getBoundInput(const std::string& prompt);
+    double getBoundInput(const std::string& prompt, double excluded);   // excluded: the infinity rejected at this end
     void getValidInput(const std::string& prompt, int& value, int min_val);
     void generatePoints();
+    void ensurePoints();
     void displayTable();
+
+public:
+    NumericalIntegrator();   // interactive calculator
+    // n equally spaced points of the equation on [a, b], without prompting.
+    // With a result cache enabled (ResultCache.h) every rule is looked up
+    // first and the points are only sampled on a miss: f is still evaluated
+    // at a and b here, but a point inside where f is undefined throws from
+    // the first rule that misses rather than from the constructor.
+    NumericalIntegrator(const std::string& equation, double a, double b, int n);
+
     double trapezoidalRule();
     double simpsons13Rule();
     double simpsons38Rule();
-
-public:
-    NumericalIntegrator();
+    // Tanh-sinh / exp-sinh / sinh-sinh on [a, b] (DoubleExponential.h); needs
+    // no samples, so it also covers infinite bounds and end point singularities
+    double doubleExponential();
 };
 
 #endif // NUMERICAL_INTEGRATOR_H
\ No newline at end of file
@@ -14,26 +14,70 @@
 #include <iomanip>  
 #include <map>  
 #include <limits>  
+#include <string_view>
+#include "Dual.h"
+
+struct Interval;
+
+// A syntax error in an expression; position() is the offset of the
+// offending character in the text (also given in what())
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string& message, size_t position);
+    size_t position() const { return offset; }
+
+private:
+    size_t offset;
+};
 
 class EquationParser {  
-private:  
-    std::vector<std::string> tokens;  
-    std::vector<std::string> postfix;  
+public:
+    // Opcodes of the compiled program, one per postfix token
+    enum class OpCode {
+        PushX, PushY, PushConst, PushParam,
+        Add, Sub, Mul, Div, Pow,
+        Sin, Cos, Tan, Asin, Acos, Atan,
+        Sinh, Cosh, Tanh, Sqrt, Exp, Ln, Log,
+        Abs, Floor, Ceil, Min, Max,
+        Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual,   // 1 or 0
+        Select   // c ? a : b; both branches are evaluated, so it never branches per point
+    };
 
-    const std::vector<std::string> math_functions = {  
-        "sin", "cos", "tan", "asin", "acos", "atan",  
-        "sinh", "cosh", "tanh", "sqrt", "exp", "ln", "log"  
-    };  
+    struct Instruction {
+        OpCode op;
+        double value; // constant for PushConst
+        int index;    // parameter slot for PushParam, literal slot for PushConst
+    };
 
-    const std::map<std::string, double> constants = {  
-        {"pi", 3.141592654}, {"e", 2.718281828}  
-    };  
+private:  
+    std::vector<std::string> postfix;       // filled by convertToPostfix
+    std::vector<Instruction> program;  
+    std::vector<std::string> parameter_names;  
+    std::vector<double> parameter_values;   // used when no values are passed in
+    std::vector<std::string> literal_text;  // source digits of every PushConst
+    std::vector<long double> wide_literals; // the same, read as long double
+    int max_depth;          // deepest value stack the program needs
+    bool uses_x, uses_y;
 
-    bool isOperator(char c);  
-    int precedence(char op);  
     bool isFunction(const std::string& token);  
     bool isConstant(const std::string& token);  
-    void validateTokens();  
+    bool isParameter(const std::string& token) const;  
+    int findParameter(std::string_view name) const;
+
+    // Single-pass precedence-climbing parser: the text is read once through
+    // string_views and compiled straight into the program, no tokens or tree
+    struct Lexer;   // parser.cpp
+    void parseExpression(Lexer& in, int min_precedence);
+    void parseOperand(Lexer& in, int min_precedence);
+    int parseArguments(Lexer& in, std::string_view name, size_t position, std::vector<size_t>* bounds);
+    void pushLiteral(std::string_view digits, double value);
+    void finish();   // stack depth and variable use of the program
+
+    template <typename T> std::vector<T> literalsAs() const;
+    template <typename V> V run(const V& x_value, const V& y_value, const V* param_values,
+                                const V* literal_values = nullptr) const;
+    template <typename V> void runBatch(const V* x_values, const V* y_values, const V* const* param_values,
+                                        V* out, size_t count) const;
 
     bool allow_xy; // Flag to allow both x and y in the same expression
 
@@ -43,9 +87,80 @@ public:
     // Set the flag to allow or disallow both x and y in the same expression
     void setAllowXY(bool allow); 
 
+    // Named parameters, e.g. {"a", "k"} for "a*exp(-k*x)". Declare them before
+    // parseEquation; their values are supplied at evaluation time.
+    void setParameters(const std::vector<std::string>& names);
+    const std::vector<std::string>& parameters() const { return parameter_names; }
+    int parameterIndex(const std::string& name) const; // -1 if not declared
+    void setParameterValue(const std::string& name, double value); // default binding
+
+    // User-defined functions, e.g. defineFunction("ramp", {"t"}, "t > 0 ? t : 0").
+    // Calls are inlined when an expression is parsed, so they cost nothing at
+    // evaluation time; the body may use its arguments, x, y, constants and
+    // functions defined before it. Definitions are process-wide; redefining a
+    // name only affects expressions parsed afterwards.
+    static void defineFunction(const std::string& name, const std::vector<std::string>& arguments,
+                               const std::string& body);
+    static bool isUserFunction(const std::string& name);
+    static unsigned long functionGeneration(); // changes with every definition
+
+    // Compile the equation. Syntax errors throw ParseError with the offset of
+    // the offending character.
     void parseEquation(const std::string& equation);  
+    // Fill the postfix (reverse Polish) text of the compiled program, for printPostfix
     void convertToPostfix();  
-    double evaluate(double x_value);  
-    double evaluate(double x_value, double y_value); // Evaluate for both x and y
+    // A domain error (division by zero, root or log of a negative number)
+    // throws only if it leaves the result non-finite, so the branch of a
+    // conditional that is not taken cannot fail.
+    double evaluate(double x_value) const;  
+    double evaluate(double x_value, double y_value) const; // Evaluate for both x and y
+
+    // f and its derivative (forward-mode, exact up to rounding) with respect
+    // to the single variable, as in evaluate(x_value)
+    double evaluateDerivative(double x_value, double& derivative) const;
+
+    // Evaluate at many points in one pass over the program per block of points.
+    // Domain errors yield NaN/inf for the affected points instead of throwing.
+    void evaluateBatch(const double* x_values, double* out, size_t count) const;
+    void evaluateBatch(const double* x_values, const double* y_values, double* out, size_t count) const;
+    void evaluateDerivativeBatch(const double* x_values, double* out, double* derivatives, size_t count) const;
+
+    // The same with explicit parameter values (in declaration order).
+    // For the batch versions param_values[k] holds parameter k for every point.
+    double evaluate(double x_value, const double* param_values) const;
+    double evaluate(double x_value, double y_value, const double* param_values) const;
+    double evaluateDerivative(double x_value, const double* param_values, double& derivative) const;
+    void evaluateBatch(const double* x_values, const double* const* param_values,
+                       double* out, size_t count) const;
+    void evaluateBatch(const double* x_values, const double* y_values, const double* const* param_values,
+                       double* out, size_t count) const;
+    void evaluateDerivativeBatch(const double* x_values, const double* const* param_values,
+                                 double* out, double* derivatives, size_t count) const;
+
+    // Evaluate in another precision: T = long double, or __float128 when built
+    // with NUMERICAL_FLOAT128 (see Precision.h). Literals and pi / e are read
+    // from their text in T, so they are as precise as T and not rounded to double.
+    // Parameters default to their double bindings when param_values is null.
+    template <typename T> T evaluateAs(const T& x_value) const;
+    template <typename T> T evaluateAs(const T& x_value, const T& y_value,
+                                       const T* param_values = nullptr) const;
+    // Many points of the single variable, reading the literals once
+    template <typename T> void evaluateBatchAs(const T* x_values, T* out, size_t count) const;
+
+    // Interval evaluation (Interval.h): an enclosure of f over every point of
+    // x_value, with outward rounding, so e.g. 0 outside the result proves f has
+    // no root in x_value. Points where f is undefined are left out; if there
+    // are no others the result is empty. Parameters take their default bindings.
+    Interval evaluateInterval(const Interval& x_value) const;
+    // The same together with an enclosure of f' over x_value
+    Interval evaluateIntervalDerivative(const Interval& x_value, Interval& derivative) const;
+    // false if the program uses abs, floor, ceil, min, max, a comparison or a
+    // conditional, so f may have kinks or jumps where f' is meaningless
+    bool isSmooth() const;
+
+    // f(x, y; p) and its gradient: gradient[0] = df/dx, gradient[1] = df/dy,
+    // gradient[2 + k] = df/dp_k. Variables the expression does not use get 0.
+    double evaluateGradient(double x_value, double y_value, const double* param_values,
+                            double* gradient) const;
     void printPostfix();  
 };  
@@ -12,11 +12,13 @@ private:
     double x0, x1, tol;
     int maxIter;
 public:
-    SecantSolver();
+    SecantSolver();   // prompts for the inputs and solves
+    SecantSolver(const string& expr, double x0, double x1, double tol, int maxIter);
     
     void get_input();
 
-    double solve();
+    // Last iterate; verbose prints every iteration
+    double solve(bool verbose = true);
 };
 
 #endif // SECANT_H
@@ -8,27 +8,92 @@
 #include "DividedDifferenceInterpolator.h"
 
 #include <iomanip>
+#include <memory>
+#include <string>
+#include "DataSource.h"
 #include "PolynomialFitter.h"
+#include "SolverServer.h"
+
+namespace {
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    // numerical_cli --serve                      requests on stdin, replies on stdout
+    // numerical_cli --serve <socket> [threads]   requests over a Unix domain socket
+    if (argc > 1 && std::string(argv[1]) == "--serve") {
+        SolverServer server;
+        try {
+            if (argc > 2) server.serveUnixSocket(argv[2], argc > 3 ? std::stoi(argv[3]) : 0);
+            else server.serveStream(std::cin, std::cout);
+        }
+        catch (const std::exception& ex) {
+            std::cerr << "Error: " << ex.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // numerical_cli --data <file>   fit a .csv (x and y columns) or raw float64
+    //                               file (all x then all y) instead of typed points
+    std::string path;
+    if (argc > 1 && std::string(argv[1]) == "--data") {
+        if (argc < 3) {
+            std::cerr << "Usage: numerical_cli --data <file.csv | file of float64 x then y>\n";
+            return 2;
+        }
+        path = argv[2];
+    }
 
-int main() {
     std::cout << std::fixed << std::setprecision(4);
 
-    int N;
-    std::cout << "Enter number of data points: ";
-    std::cin >> N;
+    // file data is fitted in place: the mapping or the parsed columns are
+    // handed to the fitter as views
+    std::vector<double> x, y;
+    std::unique_ptr<CsvTable> table;
+    std::unique_ptr<ColumnFile> columns;
+    ColumnView xs, ys;
+    try {
+        if (path.empty()) {
+            int N;
+            std::cout << "Enter number of data points: ";
+            std::cin >> N;
 
-    std::vector<double> x(N), y(N);
-    std::cout << "Enter x values:\n";
-    for (auto& xi : x) std::cin >> xi;
-    std::cout << "Enter y values:\n";
-    for (auto& yi : y) std::cin >> yi;
+            x.resize(N);
+            y.resize(N);
+            std::cout << "Enter x values:\n";
+            for (auto& xi : x) std::cin >> xi;
+            std::cout << "Enter y values:\n";
+            for (auto& yi : y) std::cin >> yi;
+            xs = x;
+            ys = y;
+        } else if (endsWith(path, ".csv")) {
+            table.reset(new CsvTable(path));
+            if (table->columns() < 2) throw std::runtime_error("Need x and y columns in " + path);
+            xs = table->column(0);
+            ys = table->column(1);
+        } else {
+            columns.reset(new ColumnFile(path, 2));
+            xs = columns->column(0);
+            ys = columns->column(1);
+        }
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    if (!path.empty()) std::cout << "Read " << xs.size() << " points\n";
 
     int degree;
     std::cout << "Enter polynomial degree: ";
     std::cin >> degree;
 
     try {
-        PolynomialFitter fitter(x, y, degree);
+        PolynomialFitter fitter(xs, ys, degree);
         fitter.fit();
         const auto& a = fitter.coefficients();
 
@@ -0,0 +1,183 @@
+#include "BatchRootSolver.h"
+#include "parser.h"
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Active lanes gathered into contiguous arrays for one batched evaluation
+class LaneBatch {
+public:
+    LaneBatch(const EquationParser& f, const vector<vector<double>>& params)
+        : parser(f), source(params), columns(params.size()), rows(params.size()) {}
+
+    // f (and f' if derivatives is non-null) at x[lane] for the listed lanes
+    void evaluate(const vector<int>& lanes, const vector<double>& x,
+                  vector<double>& values, vector<double>* derivatives) {
+        size_t n = lanes.size();
+        xs.resize(n);
+        out.resize(n);
+        for (size_t j = 0; j < n; ++j) xs[j] = x[lanes[j]];
+        for (size_t k = 0; k < columns.size(); ++k) {
+            columns[k].resize(n);
+            for (size_t j = 0; j < n; ++j) columns[k][j] = source[k][lanes[j]];
+            rows[k] = columns[k].data();
+        }
+
+        if (derivatives) {
+            slopes.resize(n);
+            parser.evaluateDerivativeBatch(xs.data(), rows.data(), out.data(), slopes.data(), n);
+            for (size_t j = 0; j < n; ++j) (*derivatives)[lanes[j]] = slopes[j];
+        } else {
+            parser.evaluateBatch(xs.data(), rows.data(), out.data(), n);
+        }
+        for (size_t j = 0; j < n; ++j) values[lanes[j]] = out[j];
+    }
+
+private:
+    const EquationParser& parser;
+    const vector<vector<double>>& source;
+    vector<vector<double>> columns;
+    vector<const double*> rows;
+    vector<double> xs, out, slopes;
+};
+
+}
+
+BatchRootResult solveBatch(const EquationParser& f,
+                           const vector<double>& a,
+                           const vector<double>& b,
+                           const vector<vector<double>>& params,
+                           const BatchRootOptions& options) {
+    size_t lanes = a.size();
+    if (b.size() != lanes)
+        throw invalid_argument("Need the same number of a and b values");
+    if (params.size() != f.parameters().size())
+        throw invalid_argument("Need one value array per declared parameter");
+    for (const auto& column : params)
+        if (column.size() != lanes) throw invalid_argument("Need one parameter value per lane");
+
+    auto start = chrono::steady_clock::now();
+
+    BatchRootResult result;
+    result.roots.assign(lanes, 0.0);
+    result.values.assign(lanes, 0.0);
+    result.iterations.assign(lanes, 0);
+    result.converged.assign(lanes, 0);
+
+    LaneBatch batch(f, params);
+    vector<int> active(lanes), still;
+    for (size_t i = 0; i < lanes; ++i) active[i] = int(i);
+
+    vector<double>& x = result.roots;
+    vector<double>& fx = result.values;
+    vector<double> x0(a), f0(lanes), x1(b), f1(lanes), d(lanes);
+
+    auto done = [&](double value) {
+        return fabs(value) <= options.ftol || value == 0;
+    };
+
+    if (options.method == BatchMethod::Bisection) {
+        batch.evaluate(active, x0, f0, nullptr);
+        batch.evaluate(active, x1, f1, nullptr);
+        result.evaluations += 2 * lanes;
+
+        still.clear();
+        for (int i : active) {
+            if (f0[i] == 0 || f1[i] == 0) {
+                x[i] = (f0[i] == 0) ? x0[i] : x1[i];
+                fx[i] = 0;
+                result.converged[i] = 1;
+            } else if ((f0[i] > 0) != (f1[i] > 0)) {
+                still.push_back(i);
+            } else {
+                x[i] = 0.5 * (x0[i] + x1[i]);   // no bracket, lane fails
+                fx[i] = NAN;
+            }
+        }
+        active.swap(still);
+
+        for (int iter = 1; iter <= options.maxIterations && !active.empty(); ++iter) {
+            for (int i : active) x[i] = 0.5 * (x0[i] + x1[i]);
+            batch.evaluate(active, x, fx, nullptr);
+            result.evaluations += active.size();
+
+            still.clear();
+            for (int i : active) {
+                result.iterations[i] = iter;
+                if ((fx[i] > 0) == (f0[i] > 0)) { x0[i] = x[i]; f0[i] = fx[i]; }
+                else { x1[i] = x[i]; f1[i] = fx[i]; }
+
+                if (done(fx[i]) || fabs(x1[i] - x0[i]) <= options.xtol) result.converged[i] = 1;
+                else still.push_back(i);
+            }
+            active.swap(still);
+        }
+    }
+    else if (options.method == BatchMethod::Newton) {
+        x = a;
+        for (int iter = 1; iter <= options.maxIterations && !active.empty(); ++iter) {
+            batch.evaluate(active, x, fx, &d);
+            result.evaluations += active.size();
+
+            still.clear();
+            for (int i : active) {
+                if (done(fx[i])) { result.converged[i] = 1; continue; }
+                if (d[i] == 0 || !isfinite(d[i]) || !isfinite(fx[i])) continue;   // lane fails
+
+                double step = fx[i] / d[i];
+                x[i] -= step;
+                result.iterations[i] = iter;
+                if (fabs(step) <= options.xtol) result.converged[i] = 1;
+                else still.push_back(i);
+            }
+            active.swap(still);
+        }
+        // values at the final iterates of the lanes that stopped on the step size
+        vector<int> all(lanes);
+        for (size_t i = 0; i < lanes; ++i) all[i] = int(i);
+        batch.evaluate(all, x, fx, nullptr);
+        result.evaluations += lanes;
+    }
+    else {
+        batch.evaluate(active, x0, f0, nullptr);
+        batch.evaluate(active, x1, f1, nullptr);
+        result.evaluations += 2 * lanes;
+        x = x1;
+        fx = f1;
+
+        for (int iter = 1; iter <= options.maxIterations && !active.empty(); ++iter) {
+            still.clear();
+            for (int i : active) {
+                if (done(f1[i])) { result.converged[i] = 1; continue; }
+                if (f1[i] == f0[i] || !isfinite(f1[i])) continue;   // flat secant, lane fails
+                x[i] = x1[i] - f1[i] * (x1[i] - x0[i]) / (f1[i] - f0[i]);
+                still.push_back(i);
+            }
+            active.swap(still);
+            if (active.empty()) break;
+
+            batch.evaluate(active, x, fx, nullptr);
+            result.evaluations += active.size();
+
+            still.clear();
+            for (int i : active) {
+                result.iterations[i] = iter;
+                double step = x[i] - x1[i];
+                x0[i] = x1[i]; f0[i] = f1[i];
+                x1[i] = x[i]; f1[i] = fx[i];
+                if (fabs(step) <= options.xtol || done(fx[i])) result.converged[i] = 1;
+                else still.push_back(i);
+            }
+            active.swap(still);
+        }
+    }
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.rootsPerSecond = result.seconds > 0 ? lanes / result.seconds : 0;
+    return result;
+}
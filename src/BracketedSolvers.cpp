@@ -0,0 +1,251 @@
+#include "BracketedSolvers.h"
+#include "ExpressionCache.h"
+#include "Instrumentation.h"
+#include "ResultCache.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const double kEps = numeric_limits<double>::epsilon();
+
+// Evaluates the end points; returns true (and fills result) when one of them
+// already is a root
+bool checkBracket(const function<double(double)>& f, double a, double b,
+                  double& fa, double& fb, RootResult& result) {
+    if (!(a < b) && !(b < a))
+        throw invalid_argument("Bracket end points must differ");
+
+    fa = f(a);
+    fb = f(b);
+    result.evaluations = 2;
+    result.iterations = 0;
+    result.a = min(a, b);
+    result.b = max(a, b);
+
+    if (fa == 0 || fb == 0) {
+        result.root = (fa == 0) ? a : b;
+        result.value = 0;
+        result.converged = true;
+        return true;
+    }
+    if ((fa > 0) == (fb > 0))
+        throw invalid_argument("No sign change: f(a) and f(b) must have opposite signs");
+    return false;
+}
+
+}
+
+RootResult bisectionRoot(const function<double(double)>& f, double a, double b,
+                         const RootOptions& options) {
+    NUMERICAL_SOLVER(telemetry, "solver.bisection_root");
+    RootResult result;
+    double fa, fb;
+    if (checkBracket(f, a, b, fa, fb, result)) return result;
+
+    result.converged = false;
+    double c = 0.5 * (a + b), fc = fa;
+    for (int i = 1; i <= options.maxIterations; ++i) {
+        c = 0.5 * (a + b);
+        fc = f(c);
+        result.evaluations++;
+        result.iterations = i;
+
+        if ((fa > 0) == (fc > 0)) { a = c; fa = fc; }
+        else { b = c; fb = fc; }
+        NUMERICAL_CONVERGENCE(telemetry, i, c, fabs(fc), fabs(b - a));
+
+        if (fc == 0 || fabs(fc) <= options.ftol || fabs(b - a) <= options.xtol) {
+            result.converged = true;
+            break;
+        }
+    }
+
+    result.root = c;
+    result.value = fc;
+    result.a = min(a, b);
+    result.b = max(a, b);
+    return result;
+}
+
+RootResult brentRoot(const function<double(double)>& f, double a, double b,
+                     const RootOptions& options) {
+    NUMERICAL_SOLVER(telemetry, "solver.brent");
+    RootResult result;
+    double fa, fb;
+    if (checkBracket(f, a, b, fa, fb, result)) return result;
+
+    double c = b, fc = fb;
+    double d = b - a, e = d;
+    result.converged = false;
+
+    for (int i = 1; i <= options.maxIterations; ++i) {
+        result.iterations = i;
+
+        // keep the root between b and c, with b the best estimate
+        if ((fb > 0) == (fc > 0)) {
+            c = a; fc = fa;
+            d = e = b - a;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+
+        double tol = 2 * kEps * fabs(b) + 0.5 * options.xtol;
+        double m = 0.5 * (c - b);
+        if (fabs(m) <= tol || fb == 0 || fabs(fb) <= options.ftol) {
+            result.converged = true;
+            break;
+        }
+
+        if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+            double s = fb / fa, p, q;
+            if (a == c) {
+                // secant
+                p = 2 * m * s;
+                q = 1 - s;
+            } else {
+                // inverse quadratic interpolation
+                double qa = fa / fc, r = fb / fc;
+                p = s * (2 * m * qa * (qa - r) - (b - a) * (r - 1));
+                q = (qa - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0) q = -q;
+            else p = -p;
+
+            // accept only if it lands inside the bracket and shrinks fast enough
+            if (2 * p < min(3 * m * q - fabs(tol * q), fabs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = m;
+                e = d;
+            }
+        } else {
+            d = m;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+        b += (fabs(d) > tol) ? d : (m > 0 ? tol : -tol);
+        fb = f(b);
+        result.evaluations++;
+        NUMERICAL_CONVERGENCE(telemetry, i, b, fabs(fb), fabs(b - a));
+    }
+
+    result.root = b;
+    result.value = fb;
+    result.a = min(b, c);
+    result.b = max(b, c);
+    return result;
+}
+
+RootResult itpRoot(const function<double(double)>& f, double a, double b,
+                   const RootOptions& options) {
+    NUMERICAL_SOLVER(telemetry, "solver.itp");
+    RootResult result;
+    double fa, fb;
+    if (checkBracket(f, a, b, fa, fb, result)) return result;
+    if (a > b) { swap(a, b); swap(fa, fb); }
+
+    // hyper-parameters from Oliveira & Takahashi (2020)
+    double eps = max(0.5 * options.xtol, kEps * max(fabs(a), fabs(b)));
+    double k1 = 0.2 / (b - a), k2 = 2.0;
+    int n0 = 1;
+    int nHalf = int(ceil(log2((b - a) / (2 * eps))));
+    int nMax = nHalf + n0;
+
+    result.converged = false;
+    double x = 0.5 * (a + b), fx = fa;
+
+    for (int j = 0; j < options.maxIterations; ++j) {
+        if (b - a <= 2 * eps) {
+            result.converged = true;
+            break;
+        }
+        result.iterations = j + 1;
+
+        double mid = 0.5 * (a + b);
+        double radius = eps * ldexp(1.0, nMax - j) - 0.5 * (b - a);
+        // (at least eps, or in floating point regula falsi can stall on one side)
+        double delta = max(k1 * pow(b - a, k2), eps);
+
+        // interpolate (regula falsi), truncate towards the midpoint ...
+        double xf = (fb * a - fa * b) / (fb - fa);
+        double sigma = (mid > xf) ? 1.0 : (mid < xf ? -1.0 : 0.0);
+        double xt = (delta <= fabs(mid - xf)) ? xf + sigma * delta : mid;
+
+        // ... and project into the minmax ball around it
+        x = (fabs(xt - mid) <= radius) ? xt : mid - sigma * radius;
+
+        fx = f(x);
+        result.evaluations++;
+        NUMERICAL_CONVERGENCE(telemetry, j + 1, x, fabs(fx), b - a);
+
+        if (fx == 0 || fabs(fx) <= options.ftol) {
+            a = b = x;
+            result.converged = true;
+            break;
+        }
+        if ((fx > 0) == (fa > 0)) { a = x; fa = fx; }
+        else { b = x; fb = fx; }
+    }
+
+    if (a != b) {
+        // best estimate: the end point with the smaller residual
+        x = (fabs(fa) < fabs(fb)) ? a : b;
+        fx = (fabs(fa) < fabs(fb)) ? fa : fb;
+    }
+    result.root = x;
+    result.value = fx;
+    result.a = a;
+    result.b = b;
+    return result;
+}
+
+namespace {
+
+// Served from the result cache when one is enabled (ResultCache.h)
+template <typename Solver>
+RootResult solveExpression(Solver solver, const char* method, const string& expr, double a, double b,
+                           const RootOptions& options) {
+    shared_ptr<ResultCache> cache = ResultCache::globalForExpressions();
+    ResultKey key(method);
+    vector<double> cached;
+    if (cache) {
+        key.addExpression(expr).add(a).add(b).add(options.xtol).add(options.ftol).add(double(options.maxIterations));
+        if (cache->lookup(key, cached) && cached.size() == 7)
+            return RootResult{cached[0], cached[1], cached[2], cached[3], int(cached[4]), int(cached[5]),
+                              cached[6] != 0};
+    }
+
+    auto parser = compileExpression(expr);
+    RootResult result = solver([&](double x) { return parser->evaluate(x); }, a, b, options);
+    if (cache)
+        cache->store(key, {result.root, result.value, result.a, result.b, double(result.iterations),
+                           double(result.evaluations), result.converged ? 1.0 : 0.0});
+    return result;
+}
+
+using Signature = RootResult (*)(const function<double(double)>&, double, double, const RootOptions&);
+
+}
+
+RootResult bisectionRoot(const string& expr, double a, double b, const RootOptions& options) {
+    return solveExpression(static_cast<Signature>(bisectionRoot), "root.bisection", expr, a, b, options);
+}
+
+RootResult brentRoot(const string& expr, double a, double b, const RootOptions& options) {
+    return solveExpression(static_cast<Signature>(brentRoot), "root.brent", expr, a, b, options);
+}
+
+RootResult itpRoot(const string& expr, double a, double b, const RootOptions& options) {
+    return solveExpression(static_cast<Signature>(itpRoot), "root.itp", expr, a, b, options);
+}
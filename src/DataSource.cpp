@@ -0,0 +1,210 @@
+#include "DataSource.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Below this much text per thread, splitting the file costs more than it saves
+const size_t kMinBytesPerThread = size_t(1) << 20;
+
+bool isBlank(char c, char delimiter) {
+    return (c == ' ' || c == '\t' || c == '\r') && c != delimiter;
+}
+
+const char* lineEnd(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+    return eol ? eol : end;
+}
+
+bool blankLine(const char* p, const char* eol, char delimiter) {
+    while (p < eol && isBlank(*p, delimiter)) ++p;
+    return p == eol;
+}
+
+void trim(const char*& p, const char*& end, char delimiter) {
+    while (p < end && isBlank(*p, delimiter)) ++p;
+    while (end > p && isBlank(end[-1], delimiter)) --end;
+}
+
+bool parseField(const char* p, const char* end, char delimiter, double& value) {
+    trim(p, end, delimiter);
+    if (p < end && *p == '+') ++p;
+    if (p == end) return false;
+    auto parsed = from_chars(p, end, value);
+    return parsed.ec == errc() && parsed.ptr == end;
+}
+
+// The fields of the line [p, eol)
+vector<pair<const char*, const char*>> splitLine(const char* p, const char* eol, char delimiter) {
+    vector<pair<const char*, const char*>> fields;
+    while (true) {
+        const char* next = static_cast<const char*>(memchr(p, delimiter, size_t(eol - p)));
+        if (!next) next = eol;
+        fields.push_back({p, next});
+        if (next == eol) return fields;
+        p = next + 1;
+    }
+}
+
+// Run work(0) .. work(n-1) on n threads, the first on this one
+template <typename Work>
+void parallelFor(int n, const Work& work) {
+    vector<thread> workers;
+    for (int t = 1; t < n; ++t) workers.emplace_back(work, t);
+    work(0);
+    for (auto& worker : workers) worker.join();
+}
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    size_t rows;            // non-blank lines
+    size_t firstRow;
+    const char* errorAt;    // first bad line, if any
+    string error;
+};
+
+}
+
+ColumnFile::ColumnFile(const string& path, int columns, ColumnType type)
+    : file(new MappedFile(path)), values(nullptr), rowCount(0), columnCount(columns) {
+    if (columns < 1) throw invalid_argument("Need at least one column");
+
+    size_t width = type == ColumnType::Float64 ? sizeof(double) : sizeof(float);
+    if (file->size() % (width * size_t(columns)) != 0)
+        throw runtime_error("File size is not a whole number of rows of " + to_string(columns) +
+                            (type == ColumnType::Float64 ? " float64" : " float32") + " values: " + path);
+    rowCount = file->size() / (width * size_t(columns));
+
+    if (type == ColumnType::Float64) {
+        values = static_cast<const double*>(file->data());
+    } else {
+        const float* in = static_cast<const float*>(file->data());
+        widened.assign(in, in + rowCount * size_t(columns));
+        values = widened.data();
+    }
+}
+
+ColumnFile::~ColumnFile() = default;
+
+ColumnView ColumnFile::column(int index) const {
+    if (index < 0 || index >= columnCount) throw out_of_range("Column index out of range");
+    return ColumnView(values + size_t(index) * rowCount, rowCount);
+}
+
+CsvTable::CsvTable(const string& path, char delimiter, int threads) : rowCount(0) {
+    MappedFile file(path);
+    const char* text = static_cast<const char*>(file.data());
+    const char* end = text + file.size();
+    const char* p = text;
+    if (end - p >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3;   // UTF-8 byte order mark
+
+    // the first non-blank line fixes the column count, and may be the header
+    const char* eol = p;
+    while (p < end) {
+        eol = lineEnd(p, end);
+        if (!blankLine(p, eol, delimiter)) break;
+        p = eol == end ? end : eol + 1;
+    }
+    if (p == end) return;
+
+    auto fields = splitLine(p, eol, delimiter);
+    bool numeric = true;
+    for (const auto& f : fields) {
+        double value;
+        if (!parseField(f.first, f.second, delimiter, value)) numeric = false;
+    }
+    if (!numeric) {
+        for (auto f : fields) {
+            trim(f.first, f.second, delimiter);
+            header.emplace_back(f.first, f.second);
+        }
+        p = eol == end ? end : eol + 1;
+    }
+    size_t width = fields.size();
+
+    // split the rest at line starts
+    size_t bytes = size_t(end - p);
+    if (threads <= 0) threads = max(1, int(thread::hardware_concurrency()));
+    threads = int(min<size_t>(size_t(threads), max<size_t>(1, bytes / kMinBytesPerThread)));
+    vector<Chunk> chunks(size_t(threads), Chunk{p, end, 0, 0, nullptr, string()});
+    for (size_t t = 1; t < chunks.size(); ++t) {
+        // the first line start at or after the even split point
+        const char* nl = lineEnd(p + bytes * t / chunks.size() - 1, end);
+        chunks[t].begin = max(nl == end ? end : nl + 1, chunks[t - 1].begin);
+        chunks[t - 1].end = chunks[t].begin;
+    }
+
+    // pass 1: rows per chunk, so every thread knows where its rows go
+    parallelFor(threads, [&](int t) {
+        Chunk& c = chunks[size_t(t)];
+        for (const char* line = c.begin; line < c.end;) {
+            const char* stop = lineEnd(line, c.end);
+            if (!blankLine(line, stop, delimiter)) ++c.rows;
+            line = stop + 1;
+        }
+    });
+    for (size_t t = 0; t < chunks.size(); ++t) {
+        chunks[t].firstRow = rowCount;
+        rowCount += chunks[t].rows;
+    }
+    data.assign(width, vector<double>(rowCount));
+
+    // pass 2: parse straight into the columns
+    parallelFor(threads, [&](int t) {
+        Chunk& c = chunks[size_t(t)];
+        size_t row = c.firstRow;
+        for (const char* line = c.begin; line < c.end;) {
+            const char* stop = lineEnd(line, c.end);
+            if (!blankLine(line, stop, delimiter)) {
+                const char* field = line;
+                for (size_t k = 0; k < width; ++k) {
+                    const char* next = static_cast<const char*>(memchr(field, delimiter, size_t(stop - field)));
+                    if (!next) next = stop;
+                    if (k + 1 < width && next == stop) {
+                        c.errorAt = line;
+                        c.error = "expected " + to_string(width) + " fields";
+                        return;
+                    }
+                    if (k + 1 == width && next != stop) {
+                        c.errorAt = line;
+                        c.error = "more than " + to_string(width) + " fields";
+                        return;
+                    }
+                    if (!parseField(field, next, delimiter, data[k][row])) {
+                        c.errorAt = line;
+                        c.error = "not a number in field " + to_string(k + 1);
+                        return;
+                    }
+                    field = next + 1;
+                }
+                ++row;
+            }
+            line = stop + 1;
+        }
+    });
+
+    for (const Chunk& c : chunks) {
+        if (!c.errorAt) continue;
+        size_t line = 1 + size_t(count(text, c.errorAt, '\n'));
+        throw runtime_error(path + ":" + to_string(line) + ": " + c.error);
+    }
+}
+
+ColumnView CsvTable::column(int index) const {
+    if (index < 0 || index >= columns()) throw out_of_range("Column index out of range");
+    return data[size_t(index)];
+}
+
+ColumnView CsvTable::column(const string& name) const {
+    auto it = find(header.begin(), header.end(), name);
+    if (it == header.end()) throw out_of_range("No column named " + name);
+    return column(int(it - header.begin()));
+}
@@ -0,0 +1,175 @@
+#include "DenseMatrix.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+const int kPanelWidth = 32;     // columns factored together in LU
+const int kColumnTile = 256;    // trailing-update columns kept hot in cache
+
+std::size_t paddedStride(int cols) {
+    const std::size_t perLine = DenseMatrix::kAlignment / sizeof(double);
+    return (std::size_t(cols) + perLine - 1) / perLine * perLine;
+}
+}
+
+DenseMatrix::DenseMatrix() : nRows(0), nCols(0), ld(0) {}
+
+DenseMatrix::DenseMatrix(int rows, int cols, double value) : nRows(0), nCols(0), ld(0) {
+    resize(rows, cols, value);
+}
+
+void DenseMatrix::resize(int rows, int cols, double value) {
+    if (rows < 0 || cols < 0)
+        throw std::invalid_argument("Matrix dimensions must be non-negative");
+    nRows = rows;
+    nCols = cols;
+    ld = paddedStride(cols);
+    values.assign(std::size_t(rows) * ld, value);
+}
+
+void DenseMatrix::fill(double value) {
+    std::fill(values.begin(), values.end(), value);
+}
+
+void DenseMatrix::swapRows(int i, int j) {
+    if (i == j) return;
+    std::swap_ranges(row(i), row(i) + nCols, row(j));
+}
+
+DenseMatrix DenseMatrix::transposed() const {
+    DenseMatrix T(nCols, nRows);
+    for (int i = 0; i < nRows; ++i)
+        for (int j = 0; j < nCols; ++j)
+            T(j, i) = (*this)(i, j);
+    return T;
+}
+
+std::vector<double> DenseMatrix::multiply(const std::vector<double>& v) const {
+    if (int(v.size()) != nCols)
+        throw std::invalid_argument("Vector length does not match matrix columns");
+    std::vector<double> result(nRows, 0.0);
+    for (int i = 0; i < nRows; ++i) {
+        const double* r = row(i);
+        double sum = 0;
+        for (int j = 0; j < nCols; ++j) sum += r[j] * v[j];
+        result[i] = sum;
+    }
+    return result;
+}
+
+LUDecomposition::LUDecomposition(const DenseMatrix& A) : LU(A), perm(A.rows()), swaps(0) {
+    if (A.rows() != A.cols())
+        throw std::invalid_argument("LU needs a square matrix");
+
+    int n = A.rows();
+    for (int i = 0; i < n; ++i) perm[i] = i;
+
+    for (int k0 = 0; k0 < n; k0 += kPanelWidth) {
+        int w = std::min(kPanelWidth, n - k0);
+        int k1 = k0 + w;
+
+        factorPanel(k0, w);
+
+        // U12 = L11^-1 A12 (rows of the panel, columns right of it)
+        for (int r = k0; r < k1; ++r) {
+            double* __restrict target = LU.row(r);
+            for (int p = k0; p < r; ++p) {
+                double l = target[p];
+                const double* __restrict source = LU.row(p);
+                for (int j = k1; j < n; ++j) target[j] -= l * source[j];
+            }
+        }
+
+        // A22 -= L21 U12, tiled over columns so the U12 strip stays in cache
+        for (int j0 = k1; j0 < n; j0 += kColumnTile) {
+            int j1 = std::min(n, j0 + kColumnTile);
+            for (int i = k1; i < n; ++i) {
+                double* __restrict target = LU.row(i);
+                int p = k0;
+                // four rank-1 updates per sweep: one load/store of target per four FMAs
+                for (; p + 4 <= k1; p += 4) {
+                    double l0 = target[p], l1 = target[p + 1], l2 = target[p + 2], l3 = target[p + 3];
+                    const double* __restrict s0 = LU.row(p);
+                    const double* __restrict s1 = LU.row(p + 1);
+                    const double* __restrict s2 = LU.row(p + 2);
+                    const double* __restrict s3 = LU.row(p + 3);
+                    for (int j = j0; j < j1; ++j)
+                        target[j] -= l0 * s0[j] + l1 * s1[j] + l2 * s2[j] + l3 * s3[j];
+                }
+                for (; p < k1; ++p) {
+                    double l = target[p];
+                    const double* __restrict source = LU.row(p);
+                    for (int j = j0; j < j1; ++j) target[j] -= l * source[j];
+                }
+            }
+        }
+    }
+}
+
+// Unblocked elimination restricted to columns k0 .. k0+w-1
+void LUDecomposition::factorPanel(int k0, int w) {
+    int n = LU.rows();
+    int k1 = k0 + w;
+
+    for (int j = k0; j < k1; ++j) {
+        int pivot = j;
+        for (int i = j + 1; i < n; ++i)
+            if (std::fabs(LU(i, j)) > std::fabs(LU(pivot, j)))
+                pivot = i;
+        if (LU(pivot, j) == 0)
+            throw std::runtime_error("Matrix is singular");
+
+        if (pivot != j) {
+            LU.swapRows(j, pivot);
+            std::swap(perm[j], perm[pivot]);
+            ++swaps;
+        }
+
+        const double* __restrict pivotRow = LU.row(j);
+        double inv = 1.0 / pivotRow[j];
+        for (int i = j + 1; i < n; ++i) {
+            double* __restrict r = LU.row(i);
+            double l = (r[j] *= inv);
+            for (int c = j + 1; c < k1; ++c) r[c] -= l * pivotRow[c];
+        }
+    }
+}
+
+void LUDecomposition::solveInPlace(double* b) const {
+    int n = LU.rows();
+    std::vector<double> y(n);
+    for (int i = 0; i < n; ++i) y[i] = b[perm[i]];
+
+    // L y = P b (unit diagonal)
+    for (int i = 0; i < n; ++i) {
+        const double* r = LU.row(i);
+        double sum = y[i];
+        for (int j = 0; j < i; ++j) sum -= r[j] * y[j];
+        y[i] = sum;
+    }
+
+    // U x = y
+    for (int i = n - 1; i >= 0; --i) {
+        const double* r = LU.row(i);
+        double sum = y[i];
+        for (int j = i + 1; j < n; ++j) sum -= r[j] * y[j];
+        y[i] = sum / r[i];
+    }
+
+    std::copy(y.begin(), y.end(), b);
+}
+
+std::vector<double> LUDecomposition::solve(const std::vector<double>& b) const {
+    if (int(b.size()) != LU.rows())
+        throw std::invalid_argument("Right-hand side length does not match matrix size");
+    std::vector<double> x(b);
+    solveInPlace(x.data());
+    return x;
+}
+
+double LUDecomposition::determinant() const {
+    double det = (swaps % 2) ? -1.0 : 1.0;
+    for (int i = 0; i < LU.rows(); ++i) det *= LU(i, i);
+    return det;
+}
@@ -1,4 +1,7 @@
 #include "DividedDifferenceInterpolator.h"
+#include "PolynomialRoots.h"
+
+#include <stdexcept>
 
 using namespace std;
 
@@ -71,75 +74,106 @@ void divide::askXX() {
     }
 }
 
-void divide::diffTable() {
-    if (abs(XX - x[0]) < abs(XX - x[n - 1])) {
-        // Forward difference table
+bool divide::forward() const {
+    return abs(XX - x[0]) < abs(XX - x[n - 1]);
+}
+
+void divide::buildTable() {
+    if (forward()) {
         for (int i = 1; i < n; i++) {
             for (int j = 0; j < n - i; j++) {
                 f[i][j] = (f[i - 1][j + 1] - f[i - 1][j]) / (x[i + j] - x[j]);
             }
         }
-
-        cout << endl << "Sn\tXi\tf(Xi)\t";
-        for (int i = 0; i < n - 1; i++) cout << i + 1 << " diff\t";
-        cout << endl;
-
-        for (int i = 0; i < n; i++) {
-            cout << i + 1 << "\t" << x[i] << "\t";
-            for (int j = 0; j < n - i; j++) {
-                cout << fixed << setprecision(4) << f[j][i] << "\t";
-            }
-            cout << endl;
-        }
     } else {
-        // Backward difference table
         for (int i = 1; i < n; i++) {
             for (int j = n - 1; j >= i; j--) {
                 f[i][j] = (f[i - 1][j] - f[i - 1][j - 1]) / (x[j] - x[j - i]);
             }
         }
-
-        cout << endl << "Sn\tXi\tf(Xi)\t";
-        for (int i = 0; i < n - 1; i++) cout << i + 1 << " diff\t";
-        cout << endl;
-
-        for (int i = 0; i < n; i++) {
-            cout << i + 1 << "\t" << x[i] << "\t";
-            for (int j = 0; j <= i; j++) {
-                cout << fixed << setprecision(4) << f[j][i] << "\t";
-            }
-            cout << endl;
-        }
     }
 }
 
-void divide::calcP() {
-    if (abs(XX - x[0]) < abs(XX - x[n - 1])) {
+double divide::interpolate() const {
+    double p = 0;
+    if (forward()) {
         // Forward interpolation
-        P1 = 0;
         for (int i = 0; i < n; i++) {
             double k = 1;
             for (int j = 0; j < i; j++) {
                 k *= (XX - x[j]);
             }
-            P1 += k * f[i][0];
+            p += k * f[i][0];
         }
     } else {
         // Backward interpolation
-        P1 = 0;
         for (int i = 0; i < n; i++) {
             double k = 1;
             for (int j = 0; j < i; j++) {
                 k *= (XX - x[n - 1 - j]);
             }
-            P1 += k * f[i][n - 1];
+            p += k * f[i][n - 1];
+        }
+    }
+    return p;
+}
+
+void divide::diffTable() {
+    buildTable();
+
+    cout << endl << "Sn\tXi\tf(Xi)\t";
+    for (int i = 0; i < n - 1; i++) cout << i + 1 << " diff\t";
+    cout << endl;
+
+    for (int i = 0; i < n; i++) {
+        cout << i + 1 << "\t" << x[i] << "\t";
+        if (forward()) {
+            // Forward difference table
+            for (int j = 0; j < n - i; j++) {
+                cout << fixed << setprecision(4) << f[j][i] << "\t";
+            }
+        } else {
+            // Backward difference table
+            for (int j = 0; j <= i; j++) {
+                cout << fixed << setprecision(4) << f[j][i] << "\t";
+            }
         }
+        cout << endl;
     }
+}
+
+void divide::calcP() {
+    P1 = interpolate();
 
     cout << endl << "The value of P" << n - 1 << "(" << XX << "): " 
          << fixed << setprecision(6) << P1 << endl << endl;
 }
 
+double divide::evaluate(double at) {
+    XX = at;
+    buildTable();
+    return P1 = interpolate();
+}
+
+vector<double> divide::coefficients() const {
+    // forward divided differences f[x0..xi] from the entered values
+    vector<double> c(f[0], f[0] + n), nodes(x, x + n);
+    dividedDifferences(nodes, c);
+    return newtonToMonomial(nodes, c);
+}
+
+divide::divide(ColumnView xValues, ColumnView yValues) : XX(0), P1(0) {
+    n = int(xValues.size());
+    if (n < 2 || n > 20 || yValues.size() != xValues.size())
+        throw invalid_argument("Need 2 to 20 points with one y per x");
+    for (int i = 0; i < n; i++) {
+        x[i] = xValues[i];
+        f[0][i] = yValues[i];
+        for (int j = 0; j < i; j++)
+            if (abs(x[i] - x[j]) < 1e-9) throw invalid_argument("X values must be distinct");
+    }
+}
+
 divide::divide()
 {
     askP();
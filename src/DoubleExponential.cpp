@@ -0,0 +1,225 @@
+#include "DoubleExponential.h"
+#include "ExpressionCache.h"
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const double kHalfPi = 1.5707963267948966;
+const int kTableLevels = 10;
+
+// Terms below this fraction of the largest one on the first level mark
+// where the tails can be cut for the finer levels
+const double kNegligible = 1e-20;
+
+enum class Transform { TanhSinh, ExpSinh, SinhSinh };
+
+// One node of the t grid: for tanh-sinh `offset` is the distance to the
+// nearer end point on [-1, 1], for exp-sinh exp(u), for sinh-sinh sinh(u)
+struct Node {
+    double t, offset, weight;
+};
+
+// levels[0] holds t = 0, +-1, +-2, ...; levels[k] the odd multiples of 2^-k
+using Table = vector<vector<Node>>;
+
+bool makeNode(Transform kind, double t, Node& node) {
+    double u = kHalfPi * sinh(t), c = kHalfPi * cosh(t);
+    switch (kind) {
+    case Transform::TanhSinh: {
+        double e = exp(-2 * fabs(u));             // 1 - tanh|u| = 2e / (1 + e)
+        node = {t, 2 * e / (1 + e), c * 4 * e / ((1 + e) * (1 + e))};
+        return node.offset > 1e-300;
+    }
+    case Transform::ExpSinh:
+        node = {t, exp(u), c * exp(u)};
+        return u > -690 && u < 690;
+    case Transform::SinhSinh:
+        node = {t, sinh(u), c * cosh(u)};
+        return fabs(u) < 690;
+    }
+    return false;
+}
+
+Table buildTable(Transform kind) {
+    Table table(kTableLevels + 1);
+    for (int level = 0; level <= kTableLevels; ++level) {
+        double h = ldexp(1.0, -level);
+        for (int side = -1; side <= 1; side += 2) {
+            for (int j = (level == 0 && side > 0) ? 0 : 1;; j += (level == 0 ? 1 : 2)) {
+                double t = side * j * h;
+                Node node;
+                if (!makeNode(kind, t, node)) break;
+                table[level].push_back(node);
+            }
+        }
+        sort(table[level].begin(), table[level].end(), [](const Node& p, const Node& q) { return p.t < q.t; });
+    }
+    return table;
+}
+
+const Table& nodes(Transform kind) {
+    static const Table tables[] = {buildTable(Transform::TanhSinh), buildTable(Transform::ExpSinh),
+                                   buildTable(Transform::SinhSinh)};
+    return tables[int(kind)];
+}
+
+// Maps the nodes onto the integration range
+struct Range {
+    Transform kind;
+    double a, b, scale;
+
+    // false if the abscissa rounds onto a finite end point or overflows
+    bool abscissa(const Node& node, double& x) const {
+        switch (kind) {
+        case Transform::TanhSinh:
+            x = node.t < 0 ? a + scale * node.offset : (node.t > 0 ? b - scale * node.offset : 0.5 * (a + b));
+            return x > a && x < b;
+        case Transform::ExpSinh:
+            x = isinf(b) ? a + node.offset : b - node.offset;
+            return isfinite(x) && x != (isinf(b) ? a : b);
+        case Transform::SinhSinh:
+            x = node.offset;
+            return isfinite(x);
+        }
+        return false;
+    }
+};
+
+// evaluate(xs, fx) fills fx with f at every abscissa of one level
+template <typename Evaluate>
+QuadratureResult integrate(const Evaluate& evaluate, double a, double b, const QuadratureOptions& options) {
+    if (isnan(a) || isnan(b)) throw invalid_argument("Bounds must not be NaN");
+    if (options.maxLevel < 1) throw invalid_argument("Need at least one refinement level");
+    QuadratureResult result = {0, 0, 0, 0, true};
+    if (a == b) return result;
+    double sign = 1;
+    if (b < a) {
+        swap(a, b);
+        sign = -1;
+    }
+
+    Range range;
+    if (isfinite(a) && isfinite(b)) range = {Transform::TanhSinh, a, b, 0.5 * (b - a)};
+    else if (isfinite(a) || isfinite(b)) range = {Transform::ExpSinh, a, b, 1};
+    else range = {Transform::SinhSinh, a, b, 1};
+    const Table& table = nodes(range.kind);
+    int maxLevel = min(options.maxLevel, kTableLevels);
+
+    double sum = 0, absSum = 0, previous = 0, previousEstimate = HUGE_VAL;
+    double lowest = -HUGE_VAL, highest = HUGE_VAL;   // tails cut after the first level
+    double first = HUGE_VAL, last = -HUGE_VAL;       // where the first level's terms matter
+    double dropBelow = -HUGE_VAL, dropAbove = HUGE_VAL;
+    vector<double> xs, fx, ws, ts;
+    result.converged = false;
+    for (int level = 0; level <= maxLevel; ++level) {
+        xs.clear();
+        ws.clear();
+        ts.clear();
+        for (const Node& node : table[level]) {
+            double x;
+            if (node.t <= lowest || node.t >= highest || !range.abscissa(node, x)) continue;
+            xs.push_back(x);
+            ws.push_back(node.weight);
+            ts.push_back(node.t);
+        }
+        fx.resize(xs.size());
+        evaluate(xs, fx);
+        result.evaluations += int(xs.size());
+
+        double largest = 0;
+        for (size_t i = 0; i < xs.size(); ++i) {
+            if (!isfinite(fx[i])) continue;
+            double term = ws[i] * fx[i];
+            sum += term;
+            absSum += fabs(term);
+            largest = max(largest, fabs(term));
+        }
+
+        if (level == 0) {
+            // the t extent of the terms that matter; keep one coarse step
+            // beyond it on the finer levels
+            for (size_t i = 0; i < xs.size(); ++i) {
+                if (!isfinite(fx[i]) || fabs(ws[i] * fx[i]) < kNegligible * largest) continue;
+                first = min(first, ts[i]);
+                last = max(last, ts[i]);
+            }
+            if (last >= first) {
+                lowest = first - 1;
+                highest = last + 1;
+                // past two finite, negligible terms a tail has decayed, and f
+                // may turn 0/0 or overflow there (x^3 / (exp(x) - 1) on [0, inf))
+                int quiet = 0;
+                for (size_t i = xs.size(); i-- > 0 && quiet < 2;)
+                    if (ts[i] < first) {
+                        if (!isfinite(fx[i])) break;
+                        if (++quiet == 2) dropBelow = ts[i];
+                    }
+                quiet = 0;
+                for (size_t i = 0; i < xs.size() && quiet < 2; ++i)
+                    if (ts[i] > last) {
+                        if (!isfinite(fx[i])) break;
+                        if (++quiet == 2) dropAbove = ts[i];
+                    }
+            }
+        }
+
+        // a non-finite value is dropped in such a tail, or where its weight
+        // could not move the sum; anywhere else it throws
+        for (size_t i = 0; i < xs.size(); ++i) {
+            if (isfinite(fx[i]) || ts[i] < dropBelow || ts[i] > dropAbove ||
+                range.scale * ws[i] < DBL_EPSILON * absSum)
+                continue;
+            char where[32];
+            snprintf(where, sizeof where, "%.17g", xs[i]);
+            throw domain_error(string("Integrand is not finite at x = ") + where);
+        }
+
+        double h = ldexp(1.0, -level);
+        double value = range.scale * h * sum;
+        result.value = sign * value;
+        result.levels = level;
+        if (level >= 2) {
+            result.errorEstimate = fabs(value - previous);
+            if (result.errorEstimate <= options.tolerance * range.scale * h * absSum) {
+                result.converged = true;
+                break;
+            }
+            if (level >= 4 && result.errorEstimate > 0.5 * previousEstimate) break;   // at the noise floor
+            previousEstimate = result.errorEstimate;
+        }
+        previous = value;
+    }
+    return result;
+}
+
+}
+
+QuadratureResult integrateDoubleExponential(const function<double(double)>& f, double a, double b,
+                                            const QuadratureOptions& options) {
+    NUMERICAL_TIMED("quadrature.double_exponential");
+    return integrate([&](const vector<double>& xs, vector<double>& fx) {
+        for (size_t i = 0; i < xs.size(); ++i) fx[i] = f(xs[i]);
+    }, a, b, options);
+}
+
+QuadratureResult integrateDoubleExponential(const EquationParser& f, double a, double b,
+                                            const QuadratureOptions& options) {
+    NUMERICAL_TIMED("quadrature.double_exponential");
+    return integrate([&](const vector<double>& xs, vector<double>& fx) {
+        f.evaluateBatch(xs.data(), fx.data(), xs.size());
+    }, a, b, options);
+}
+
+QuadratureResult integrateDoubleExponential(const string& expr, double a, double b,
+                                            const QuadratureOptions& options) {
+    return integrateDoubleExponential(*compileExpression(expr), a, b, options);
+}
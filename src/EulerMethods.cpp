@@ -1,46 +1,231 @@
 #include "EulerMethods.h"
-#include "parser.h"
+#include "ExpressionCache.h"
+#include "Instrumentation.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
 #include <iostream>
 #include <iomanip> // for std::setw and std::setprecision
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
-void BasicEuler::solve(const std::string& equation, double x0, double y0, double h, int steps)
+void EulerMethod::solve(const std::string& equation, double x0, double y0, double h, int steps)
 {
-    EquationParser parser;
-    parser.setAllowXY(true);
-    parser.parseEquation(equation);
+    NUMERICAL_TIMED("solver.euler");
+    auto parser = compileExpression(equation, true);
 
-    std::cout << "\nBasic Euler Method:\n";
+    std::cout << "\n" << name() << ":\n";
     std::cout << std::fixed << std::setprecision(6);
     std::cout << std::setw(6) << "Step" << std::setw(15) << "x" << std::setw(15) << "y\n";
     std::cout << "----------------------------------------\n";
 
     for (int i = 0; i < steps; ++i)
     {
-        double f = parser.evaluate(x0, y0);
-        y0 += h * f;
+        y0 = step(*parser, x0, y0, h);
         x0 += h;
         std::cout << std::setw(6) << i + 1 << std::setw(15) << x0 << std::setw(15) << y0 << "\n";
     }
 }
 
-void ModifiedEuler::solve(const std::string& equation, double x0, double y0, double h, int steps)
+double EulerMethod::integrate(const std::string& equation, double x0, double y0, double h, int steps) const
 {
-    EquationParser parser;
-    parser.setAllowXY(true);
-    parser.parseEquation(equation);
-
-    std::cout << "\nModified Euler Method:\n";
-    std::cout << std::fixed << std::setprecision(6);
-    std::cout << std::setw(6) << "Step" << std::setw(15) << "x" << std::setw(15) << "y\n";
-    std::cout << "----------------------------------------\n";
+    NUMERICAL_TIMED("solver.euler");
+    auto parser = compileExpression(equation, true);
 
     for (int i = 0; i < steps; ++i)
     {
-        double k1 = parser.evaluate(x0, y0);
-        double k2 = parser.evaluate(x0 + h, y0 + h * k1);
-        y0 += h * (k1 + k2) / 2;
+        y0 = step(*parser, x0, y0, h);
         x0 += h;
-        std::cout << std::setw(6) << i + 1 << std::setw(15) << x0 << std::setw(15) << y0 << "\n";
     }
+    return y0;
+}
+
+namespace
+{
+
+// Trajectories per chunk: a few parser blocks, small enough to stay in cache
+const std::size_t kEnsembleChunk = 512;
+
+struct Moments
+{
+    double count, mean, m2;
+};
+
+Moments moments(const double* y, std::size_t n)
+{
+    double mean = 0, m2 = 0;
+    for (std::size_t i = 0; i < n; ++i) mean += y[i];
+    mean /= double(n);
+    for (std::size_t i = 0; i < n; ++i) m2 += (y[i] - mean) * (y[i] - mean);
+    return {double(n), mean, m2};
+}
+
+// Chan et al.: the moments of the union of two disjoint samples
+void merge(Moments& a, const Moments& b)
+{
+    if (b.count == 0) return;
+    double n = a.count + b.count, delta = b.mean - a.mean;
+    a.mean += delta * b.count / n;
+    a.m2 += b.m2 + delta * delta * a.count * b.count / n;
+    a.count = n;
+}
+
+}
+
+// Scratch arrays of one thread, sized for a chunk
+struct EulerWorkspace
+{
+    std::vector<double> x, k1, k2, trial;
+    std::vector<const double*> params;
+};
+
+EnsembleResult EulerMethod::integrateEnsemble(const std::string& equation, double x0, const std::vector<double>& y0,
+                                              double h, int steps, const EnsembleOptions& options) const
+{
+    NUMERICAL_TIMED("solver.euler_ensemble");
+    std::size_t lanes = y0.size();
+    if (steps < 0)
+        throw std::invalid_argument("Number of steps must not be negative");
+    if (options.parameters.size() != options.parameterNames.size())
+        throw std::invalid_argument("Need one value array per parameter name");
+    for (const auto& column : options.parameters)
+        if (column.size() != lanes) throw std::invalid_argument("Need one parameter value per trajectory");
+
+    auto parser = compileExpression(equation, true, options.parameterNames);
+    auto start = std::chrono::steady_clock::now();
+
+    // steps after which the statistics are taken; always the last one
+    std::vector<int> recordSteps;
+    if (options.statsEvery > 0)
+        for (int s = options.statsEvery; s < steps; s += options.statsEvery) recordSteps.push_back(s);
+    recordSteps.push_back(steps);
+
+    EnsembleResult result;
+    result.finalY = y0;   // integrated in place
+    std::size_t records = recordSteps.size();
+    std::size_t chunks = (lanes + kEnsembleChunk - 1) / kEnsembleChunk;
+    std::vector<Moments> chunkMoments(chunks * records);
+
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr failure;
+    std::mutex failureLock;
+    // first trajectory to turn non-finite, and the x where it did
+    std::size_t failedLane = lanes;
+    double failedX = 0;
+    auto worker = [&]() {
+        EulerWorkspace work;
+        work.x.resize(kEnsembleChunk);
+        work.k1.resize(kEnsembleChunk);
+        work.k2.resize(kEnsembleChunk);
+        work.trial.resize(kEnsembleChunk);
+        work.params.resize(options.parameters.size());
+        std::vector<char> finite(kEnsembleChunk);
+        try {
+            for (std::size_t c = next++; c < chunks; c = next++) {
+                std::size_t first = c * kEnsembleChunk, n = std::min(kEnsembleChunk, lanes - first);
+                double* y = result.finalY.data() + first;
+                for (std::size_t k = 0; k < work.params.size(); ++k) work.params[k] = options.parameters[k].data() + first;
+
+                double x = x0;
+                std::size_t r = 0;
+                if (recordSteps[0] == 0) chunkMoments[c * records + r++] = moments(y, n);
+                for (std::size_t i = 0; i < n; ++i) finite[i] = std::isfinite(y[i]);
+                // the batch pass turns a domain error into NaN/inf instead of
+                // throwing, so watch for lanes that stop being finite
+                std::size_t lost = n;
+                double lostX = 0;
+                for (int s = 1; s <= steps; ++s) {
+                    stepBatch(*parser, x, h, y, n, work);
+                    x += h;
+                    for (std::size_t i = 0; i < n; ++i)
+                        if (finite[i] && !std::isfinite(y[i])) {
+                            finite[i] = 0;
+                            if (i < lost) {
+                                lost = i;
+                                lostX = x;
+                            }
+                        }
+                    if (r < records && recordSteps[r] == s) chunkMoments[c * records + r++] = moments(y, n);
+                }
+                if (lost < n) {
+                    std::lock_guard<std::mutex> guard(failureLock);
+                    if (first + lost < failedLane) {
+                        failedLane = first + lost;
+                        failedX = lostX;
+                    }
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(failureLock);
+            if (!failure) failure = std::current_exception();
+            next = chunks;
+        }
+    };
+
+    int threads = options.threads > 0 ? options.threads : int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::min<std::size_t>(std::size_t(threads), std::max<std::size_t>(1, chunks)));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (failure) std::rethrow_exception(failure);
+    if (failedLane < lanes) {
+        std::ostringstream message;
+        message << "Trajectory " << failedLane << " (y0 = " << y0[failedLane] << ") is not finite at x = "
+                << failedX << "; check the equation's domain along it";
+        throw std::runtime_error(message.str());
+    }
+
+    // merge in chunk order, so the result does not depend on the schedule
+    double x = x0;
+    for (int s = 0, r = 0; r < int(records); ++s) {
+        if (s > 0) x += h;
+        if (recordSteps[r] != s) continue;
+        Moments total = {0, 0, 0};
+        for (std::size_t c = 0; c < chunks; ++c) merge(total, chunkMoments[c * records + r]);
+        result.x.push_back(x);
+        result.mean.push_back(lanes ? total.mean : NAN);
+        result.variance.push_back(total.count > 1 ? total.m2 / (total.count - 1) : 0.0);
+        ++r;
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (result.seconds > 0) result.stepsPerSecond = double(lanes) * steps / result.seconds;
+    return result;
+}
+
+double BasicEuler::step(const EquationParser& f, double x, double y, double h) const
+{
+    return y + h * f.evaluate(x, y);
+}
+
+double ModifiedEuler::step(const EquationParser& f, double x, double y, double h) const
+{
+    double k1 = f.evaluate(x, y);
+    double k2 = f.evaluate(x + h, y + h * k1);
+    return y + h * (k1 + k2) / 2;
+}
+
+void BasicEuler::stepBatch(const EquationParser& f, double x, double h, double* y, std::size_t n,
+                           EulerWorkspace& work) const
+{
+    std::fill(work.x.begin(), work.x.begin() + n, x);
+    f.evaluateBatch(work.x.data(), y, work.params.data(), work.k1.data(), n);
+    for (std::size_t i = 0; i < n; ++i) y[i] = y[i] + h * work.k1[i];
+}
+
+void ModifiedEuler::stepBatch(const EquationParser& f, double x, double h, double* y, std::size_t n,
+                              EulerWorkspace& work) const
+{
+    std::fill(work.x.begin(), work.x.begin() + n, x);
+    f.evaluateBatch(work.x.data(), y, work.params.data(), work.k1.data(), n);
+    for (std::size_t i = 0; i < n; ++i) work.trial[i] = y[i] + h * work.k1[i];
+    std::fill(work.x.begin(), work.x.begin() + n, x + h);
+    f.evaluateBatch(work.x.data(), work.trial.data(), work.params.data(), work.k2.data(), n);
+    for (std::size_t i = 0; i < n; ++i) y[i] = y[i] + h * (work.k1[i] + work.k2[i]) / 2;
 }
@@ -0,0 +1,132 @@
+#include "ExpressionCache.h"
+
+#include <cctype>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+bool isWordChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+}
+
+// A blank between `before` and `after` can change the tokens when it splits
+// a word or number, a two-character comparison ("< ="), or an exponent from
+// its sign ("1e -5"); `last` is the character before `before`
+bool blankMatters(char last, char before, char after) {
+    if (isWordChar(before) && isWordChar(after)) return true;
+    if (after == '=' && (before == '<' || before == '>' || before == '=' || before == '!')) return true;
+    if ((before == 'e' || before == 'E') && (after == '+' || after == '-')) return true;
+    return (before == '+' || before == '-') && (last == 'e' || last == 'E');
+}
+
+}
+
+ExpressionCache::ExpressionCache(size_t capacity)
+    : limit(capacity), hits(0), misses(0), evictions(0) {
+    if (capacity == 0) throw invalid_argument("Cache capacity must be positive");
+}
+
+ExpressionCache& ExpressionCache::global() {
+    static ExpressionCache cache;
+    return cache;
+}
+
+// Blanks are dropped wherever the parser would read the same tokens
+// without them, so equivalent spellings share one key
+string ExpressionCache::normalize(const string& expression) {
+    string text;
+    text.reserve(expression.size());
+    for (size_t i = 0; i < expression.size(); ++i) {
+        char c = expression[i];
+        if (!isspace(static_cast<unsigned char>(c))) {
+            text += c;
+            continue;
+        }
+        size_t j = i;
+        while (j + 1 < expression.size() && isspace(static_cast<unsigned char>(expression[j + 1]))) ++j;
+        if (!text.empty() && j + 1 < expression.size()) {
+            char last = text.size() > 1 ? text[text.size() - 2] : ' ';
+            if (blankMatters(last, text.back(), expression[j + 1])) text += ' ';
+        }
+        i = j;
+    }
+    return text;
+}
+
+ExpressionCache::Compiled ExpressionCache::get(const string& expression, bool allowXY,
+                                               const vector<string>& parameters) {
+    string text = normalize(expression);   // the key only
+    // the generation changes whenever a user function is (re)defined
+    string key = to_string(EquationParser::functionGeneration()) + (allowXY ? "|xy|" : "|x|");
+    for (const auto& name : parameters) key += name + ",";
+    key += "|" + text;
+
+    {
+        lock_guard<mutex> lock(access);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            ++hits;
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->parser;
+        }
+        ++misses;
+    }
+
+    // compile outside the lock so one slow parse does not block other lookups;
+    // the caller's text is parsed, so errors point into it, and any spelling
+    // with the same key reads as the same tokens
+    auto parser = make_shared<EquationParser>();
+    parser->setAllowXY(allowXY);
+    if (!parameters.empty()) parser->setParameters(parameters);
+    parser->parseEquation(expression);
+
+    lock_guard<mutex> lock(access);
+    auto it = index.find(key);
+    if (it != index.end()) {   // another thread compiled it meanwhile
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->parser;
+    }
+    entries.push_front(Entry{key, parser});
+    index[key] = entries.begin();
+    trim();
+    return parser;
+}
+
+void ExpressionCache::trim() {
+    while (entries.size() > limit) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++evictions;
+    }
+}
+
+ExpressionCacheStats ExpressionCache::stats() const {
+    lock_guard<mutex> lock(access);
+    ExpressionCacheStats s;
+    s.hits = hits;
+    s.misses = misses;
+    s.evictions = evictions;
+    s.size = entries.size();
+    s.capacity = limit;
+    return s;
+}
+
+void ExpressionCache::setCapacity(size_t capacity) {
+    if (capacity == 0) throw invalid_argument("Cache capacity must be positive");
+    lock_guard<mutex> lock(access);
+    limit = capacity;
+    trim();
+}
+
+void ExpressionCache::clear() {
+    lock_guard<mutex> lock(access);
+    entries.clear();
+    index.clear();
+    hits = misses = evictions = 0;
+}
+
+ExpressionCache::Compiled compileExpression(const string& expression, bool allowXY,
+                                            const vector<string>& parameters) {
+    return ExpressionCache::global().get(expression, allowXY, parameters);
+}
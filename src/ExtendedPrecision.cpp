@@ -0,0 +1,181 @@
+#include "ExtendedPrecision.h"
+#include "PolynomialRoots.h"
+#include "StreamingPolynomialFitter.h"
+#include "parser.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+template <typename T>
+T lagrangeValue(const vector<T>& x, const vector<T>& y, T at) {
+    return lagrangeValue(x.data(), y.data(), x.size(), at);
+}
+
+template <typename T>
+T lagrangeValue(const T* x, const T* y, size_t count, T at) {
+    int n = int(count);
+    T result = 0;
+    for (int i = 0; i < n; ++i) {
+        T numerator = 1, denominator = 1;
+        for (int j = 0; j < n; ++j) {
+            if (i != j) {
+                numerator *= (at - x[j]);
+                denominator *= (x[i] - x[j]);
+            }
+        }
+        result += y[i] * (numerator / denominator);
+    }
+    return result;
+}
+
+template <typename T>
+NewtonInterpolant<T>::NewtonInterpolant(const vector<T>& xv, const vector<T>& yv) : x(xv), c(yv) {
+    if (xv.size() != yv.size() || xv.empty())
+        throw invalid_argument("Need the same, nonzero number of x and y values");
+    dividedDifferences(x, c);
+}
+
+template <typename T>
+T NewtonInterpolant<T>::evaluate(T at) const {
+    int n = int(c.size()) - 1;
+    T p = c[n];
+    for (int k = n - 1; k >= 0; --k) p = p * (at - x[k]) + c[k];
+    return p;
+}
+
+template <typename T>
+vector<T> NewtonInterpolant<T>::coefficients() const {
+    return newtonToMonomial(x, c);
+}
+
+template <typename T>
+T compositeIntegral(const vector<T>& fx, T h, IntegrationRule rule) {
+    int n = int(fx.size());
+    if (n < 2) throw invalid_argument("Need at least two points");
+
+    T sum = fx[0] + fx[n - 1];
+    switch (rule) {
+    case IntegrationRule::Trapezoidal:
+        for (int i = 1; i < n - 1; i++) sum += 2 * fx[i];
+        return (h / 2) * sum;
+    case IntegrationRule::Simpson13:
+        if ((n - 1) % 2 != 0) throw runtime_error("Simpson's 1/3 needs even intervals");
+        for (int i = 1; i < n - 1; i++) sum += (i % 2 == 0) ? 2 * fx[i] : 4 * fx[i];
+        return (h / 3) * sum;
+    case IntegrationRule::Simpson38:
+        if ((n - 1) % 3 != 0) throw runtime_error("Simpson's 3/8 needs intervals divisible by 3");
+        for (int i = 1; i < n - 1; i++) sum += (i % 3 == 0) ? 2 * fx[i] : 3 * fx[i];
+        return (3 * h / 8) * sum;
+    }
+    return sum;
+}
+
+namespace {
+template <typename T>
+void sample(const EquationParser& f, const vector<T>& x, vector<T>& fx) {
+    f.evaluateBatchAs<T>(x.data(), fx.data(), x.size());
+}
+void sample(const EquationParser& f, const vector<double>& x, vector<double>& fx) {
+    f.evaluateBatch(x.data(), fx.data(), x.size());
+}
+}
+
+template <typename T>
+T integrateExpression(const EquationParser& f, T a, T b, int points, IntegrationRule rule) {
+    if (points < 2) throw invalid_argument("Need at least two points");
+    T h = (b - a) / (points - 1);
+    vector<T> x(points), fx(points);
+    for (int i = 0; i < points; i++) x[i] = a + i * h;
+    sample(f, x, fx);
+    return compositeIntegral(fx, h, rule);
+}
+
+template <typename T>
+PrecisePolynomialFitter<T>::PrecisePolynomialFitter(const vector<T>& xv, const vector<T>& yv, int degree)
+    : N(int(xv.size())), n(degree), x(xv), y(yv), a(degree + 1), b(degree + 1),
+      center(0), halfWidth(1), residual(0) {
+    if (N == 0 || degree < 0 || N <= degree)
+        throw invalid_argument("Need more points than degree");
+    if (yv.size() != xv.size())
+        throw invalid_argument("x and y must have the same number of points");
+
+    auto range = minmax_element(x.begin(), x.end());
+    center = (*range.first + *range.second) / 2;
+    halfWidth = (*range.second - *range.first) / 2;
+    if (halfWidth == 0) halfWidth = 1;
+}
+
+template <typename T>
+void PrecisePolynomialFitter<T>::fit() {
+    using std::sqrt; using ::sqrt;
+    int m = n + 1;
+
+    // Vandermonde columns in t
+    vector<vector<T>> V(m, vector<T>(N));
+    for (int i = 0; i < N; ++i) {
+        T t = (x[i] - center) / halfWidth, p = 1;
+        for (int k = 0; k < m; ++k, p *= t) V[k][i] = p;
+    }
+    vector<T> r(y);
+
+    // Householder QR, applied to r as it goes
+    for (int j = 0; j < m; ++j) {
+        vector<T>& v = V[j];
+        T sigma = 0;
+        for (int i = j; i < N; ++i) sigma += v[i] * v[i];
+        if (sigma == 0) throw runtime_error("Least-squares system is rank deficient");
+        T norm = sqrt(sigma);
+        T alpha = (v[j] > 0) ? -norm : norm;
+        v[j] -= alpha;
+        T vv = sigma - 2 * alpha * (v[j] + alpha) + alpha * alpha;   // |v|^2 after the shift
+
+        for (int k = j + 1; k < m; ++k) {
+            T s = 0;
+            for (int i = j; i < N; ++i) s += v[i] * V[k][i];
+            s = 2 * s / vv;
+            for (int i = j; i < N; ++i) V[k][i] -= s * v[i];
+        }
+        T s = 0;
+        for (int i = j; i < N; ++i) s += v[i] * r[i];
+        s = 2 * s / vv;
+        for (int i = j; i < N; ++i) r[i] -= s * v[i];
+        v[j] = alpha;   // R(j, j)
+    }
+
+    // R b = first m entries of Q^T y; R(i, k) sits in V[k][i]
+    for (int i = m - 1; i >= 0; --i) {
+        T sum = r[i];
+        for (int k = i + 1; k < m; ++k) sum -= V[k][i] * b[k];
+        b[i] = sum / V[i][i];
+    }
+
+    T rr = 0;
+    for (int i = m; i < N; ++i) rr += r[i] * r[i];
+    residual = sqrt(rr);
+
+    a = StreamingPolynomialFitter::toMonomial(b, center, halfWidth);
+}
+
+template <typename T>
+T PrecisePolynomialFitter<T>::evaluate(T xValue) const {
+    T t = (xValue - center) / halfWidth;
+    T result = 0;
+    for (int k = n; k >= 0; --k) result = result * t + b[k];
+    return result;
+}
+
+#define INSTANTIATE_EXTENDED_PRECISION(T)                                                           \
+    template T lagrangeValue<T>(const vector<T>&, const vector<T>&, T);                            \
+    template T lagrangeValue<T>(const T*, const T*, size_t, T);                                    \
+    template class NewtonInterpolant<T>;                                                           \
+    template T compositeIntegral<T>(const vector<T>&, T, IntegrationRule);                         \
+    template T integrateExpression<T>(const EquationParser&, T, T, int, IntegrationRule);          \
+    template class PrecisePolynomialFitter<T>;
+
+INSTANTIATE_EXTENDED_PRECISION(double)
+INSTANTIATE_EXTENDED_PRECISION(long double)
+#ifdef NUMERICAL_FLOAT128
+INSTANTIATE_EXTENDED_PRECISION(__float128)
+#endif
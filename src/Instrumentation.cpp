@@ -0,0 +1,247 @@
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define NUMERICAL_HAVE_RDTSC
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define NUMERICAL_HAVE_RDTSC
+#endif
+
+using namespace std;
+
+namespace instrumentation {
+
+namespace {
+
+const int kMaxSlots = 256;
+const size_t kMaxRecords = size_t(1) << 20;   // per thread
+
+double steadySeconds() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ThreadBlock;
+
+struct Registry {
+    mutex lock;
+    vector<string> names;
+    vector<ThreadBlock*> live;
+    uint64_t retiredCalls[kMaxSlots] = {}, retiredTicks[kMaxSlots] = {};
+    vector<ConvergenceRecord> retiredRecords;
+    atomic<long> runs{0};
+    uint64_t tick0;
+    double time0;
+
+    Registry() : tick0(ticks()), time0(steadySeconds()) {}
+    ~Registry();
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+struct ThreadBlock {
+    Slot slots[kMaxSlots];
+    vector<ConvergenceRecord> records;
+
+    ThreadBlock() {
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        r.live.push_back(this);
+    }
+
+    // fold this thread's totals into the process totals
+    ~ThreadBlock() {
+        Registry& r = registry();
+        lock_guard<mutex> guard(r.lock);
+        for (int i = 0; i < kMaxSlots; ++i) {
+            r.retiredCalls[i] += slots[i].calls.load(memory_order_relaxed);
+            r.retiredTicks[i] += slots[i].ticks.load(memory_order_relaxed);
+        }
+        r.retiredRecords.insert(r.retiredRecords.end(), records.begin(), records.end());
+        r.live.erase(find(r.live.begin(), r.live.end(), this));
+    }
+};
+
+ThreadBlock& threadBlock() {
+    thread_local ThreadBlock block;
+    return block;
+}
+
+// Seconds per tick, measured against steady_clock since the registry started
+double secondsPerTick(Registry& r) {
+#ifdef NUMERICAL_HAVE_RDTSC
+    double start = steadySeconds();
+    while (steadySeconds() - r.time0 < 0.01 && steadySeconds() - start < 0.01) {}
+    uint64_t elapsed = ticks() - r.tick0;
+    return elapsed ? (steadySeconds() - r.time0) / double(elapsed) : 0.0;
+#else
+    (void)r;
+    return 1e-9;
+#endif
+}
+
+string jsonNumber(double v) {
+    if (!isfinite(v)) return "null";
+    char buffer[32];
+    snprintf(buffer, sizeof buffer, "%.17g", v);
+    return buffer;
+}
+
+// At exit, after every thread (the main one included) has folded in its totals
+Registry::~Registry() {
+    if (!enabled()) return;
+    try {
+        const char* out = getenv("NUMERICAL_CONVERGENCE_OUT");
+        if (out && *out) {
+            ofstream file(out);
+            string path = out;
+            bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+            if (csv) writeConvergenceCsv(file);
+            else writeConvergenceJson(file);
+        }
+
+        const char* target = getenv("NUMERICAL_INSTRUMENT_SUMMARY");
+        if (target && string(target) == "0") return;
+        if (target && *target) {
+            ofstream file(target);
+            writeSummary(file);
+        } else {
+            writeSummary(cerr);
+        }
+    } catch (const exception&) {
+        // nothing sensible to do this late
+    }
+}
+
+}
+
+uint64_t ticks() {
+#ifdef NUMERICAL_HAVE_RDTSC
+    return __rdtsc();
+#else
+    return uint64_t(chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+int slot(const char* name) {
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    auto it = find(r.names.begin(), r.names.end(), name);
+    if (it != r.names.end()) return int(it - r.names.begin());
+    if (int(r.names.size()) == kMaxSlots) throw runtime_error("Too many instrumentation names");
+    r.names.push_back(name);
+    return int(r.names.size()) - 1;
+}
+
+Slot* threadSlots() { return threadBlock().slots; }
+
+SolverScope::SolverScope(int id, const char* name)
+    : timer(id), solver(name), run(++registry().runs) {}
+
+void SolverScope::record(int iteration, double x, double residual, double step) {
+    vector<ConvergenceRecord>& records = threadBlock().records;
+    if (records.size() < kMaxRecords) records.push_back({solver, run, iteration, x, residual, step});
+}
+
+vector<Stat> summary() {
+    Registry& r = registry();
+    double scale = secondsPerTick(r);
+    lock_guard<mutex> guard(r.lock);
+
+    vector<Stat> stats;
+    for (size_t i = 0; i < r.names.size(); ++i) {
+        uint64_t calls = r.retiredCalls[i], t = r.retiredTicks[i];
+        for (const ThreadBlock* block : r.live) {
+            calls += block->slots[i].calls.load(memory_order_relaxed);
+            t += block->slots[i].ticks.load(memory_order_relaxed);
+        }
+        stats.push_back({r.names[i], calls, double(t) * scale});
+    }
+    sort(stats.begin(), stats.end(), [](const Stat& a, const Stat& b) { return a.name < b.name; });
+    return stats;
+}
+
+vector<ConvergenceRecord> convergence() {
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    vector<ConvergenceRecord> all = r.retiredRecords;
+    for (const ThreadBlock* block : r.live) all.insert(all.end(), block->records.begin(), block->records.end());
+    stable_sort(all.begin(), all.end(), [](const ConvergenceRecord& a, const ConvergenceRecord& b) {
+        return a.run != b.run ? a.run < b.run : a.iteration < b.iteration;
+    });
+    return all;
+}
+
+void reset() {
+    Registry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    fill(begin(r.retiredCalls), end(r.retiredCalls), 0);
+    fill(begin(r.retiredTicks), end(r.retiredTicks), 0);
+    r.retiredRecords.clear();
+    for (ThreadBlock* block : r.live) {
+        for (Slot& s : block->slots) {
+            s.calls.store(0, memory_order_relaxed);
+            s.ticks.store(0, memory_order_relaxed);
+        }
+        block->records.clear();
+    }
+}
+
+void writeSummary(ostream& os) {
+    vector<Stat> stats = summary();
+    char line[160];
+    os << "---- instrumentation summary ----\n";
+    snprintf(line, sizeof line, "%-36s %12s %14s %12s\n", "name", "calls", "total ms", "mean us");
+    os << line;
+    for (const Stat& s : stats) {
+        if (s.seconds > 0)
+            snprintf(line, sizeof line, "%-36s %12llu %14.3f %12.3f\n", s.name.c_str(),
+                     (unsigned long long)s.calls, s.seconds * 1e3, s.calls ? s.seconds * 1e6 / double(s.calls) : 0.0);
+        else
+            snprintf(line, sizeof line, "%-36s %12llu %14s %12s\n", s.name.c_str(),
+                     (unsigned long long)s.calls, "-", "-");
+        os << line;
+    }
+    vector<ConvergenceRecord> records = convergence();
+    long runs = records.empty() ? 0 : 1;
+    for (size_t i = 1; i < records.size(); ++i)
+        if (records[i].run != records[i - 1].run) ++runs;
+    os << "convergence records: " << records.size() << " in " << runs << " solver run(s)\n";
+}
+
+void writeConvergenceJson(ostream& os) {
+    vector<ConvergenceRecord> records = convergence();
+    os << "{\n  \"records\": [";
+    for (size_t i = 0; i < records.size(); ++i) {
+        const ConvergenceRecord& c = records[i];
+        os << (i ? ",\n" : "\n") << "    {\"solver\": \"" << c.solver << "\", \"run\": " << c.run
+           << ", \"iteration\": " << c.iteration << ", \"x\": " << jsonNumber(c.x)
+           << ", \"residual\": " << jsonNumber(c.residual) << ", \"step\": " << jsonNumber(c.step) << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+void writeConvergenceCsv(ostream& os) {
+    os << "solver,run,iteration,x,residual,step\n";
+    char line[160];
+    for (const ConvergenceRecord& c : convergence()) {
+        snprintf(line, sizeof line, "%s,%ld,%d,%.17g,%.17g,%.17g\n", c.solver, c.run, c.iteration,
+                 c.x, c.residual, c.step);
+        os << line;
+    }
+}
+
+}
@@ -0,0 +1,408 @@
+#include "Interval.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+const double kInf = numeric_limits<double>::infinity();
+const double kPi = 3.14159265358979323846;
+
+// Below this the rounding errors recovered with fma are no longer exact
+const double kTiny = 0x1p-960;
+
+double down(double v) { return nextafter(v, -kInf); }
+double up(double v) { return nextafter(v, kInf); }
+
+// Library functions are not correctly rounded: allow two ulps
+double down2(double v) { return down(down(v)); }
+double up2(double v) { return up(up(v)); }
+
+// a + b rounded down / up. The rounding error of the sum is exact (TwoSum),
+// so the rounded result only moves when it landed on the wrong side.
+double addDown(double a, double b) {
+    double s = a + b;
+    if (!isfinite(s)) return down(s);
+    double t = s - a;
+    double e = (a - (s - t)) + (b - t);
+    return e < 0 ? down(s) : s;
+}
+
+double addUp(double a, double b) {
+    double s = a + b;
+    if (!isfinite(s)) return up(s);
+    double t = s - a;
+    double e = (a - (s - t)) + (b - t);
+    return e > 0 ? up(s) : s;
+}
+
+// a * b rounded down / up, with 0 * inf = 0 (an infinite bound is never attained)
+double mulDown(double a, double b) {
+    if (a == 0 || b == 0) return 0;
+    double p = a * b;
+    if (!isfinite(p) || fabs(p) < kTiny) return down(p);
+    double e = fma(a, b, -p);
+    return e < 0 ? down(p) : p;
+}
+
+double mulUp(double a, double b) {
+    if (a == 0 || b == 0) return 0;
+    double p = a * b;
+    if (!isfinite(p) || fabs(p) < kTiny) return up(p);
+    double e = fma(a, b, -p);
+    return e > 0 ? up(p) : p;
+}
+
+// a / b (b != 0) rounded down / up; a - q b is exact, and its sign over b's
+// says on which side of the quotient q lies
+double divDown(double a, double b) {
+    if (a == 0) return 0;
+    double q = a / b;
+    if (!isfinite(q) || fabs(q) < kTiny || fabs(a) < kTiny) return down(q);
+    double r = fma(-q, b, a);
+    return (r != 0 && (r < 0) != (b < 0)) ? down(q) : q;
+}
+
+double divUp(double a, double b) {
+    if (a == 0) return 0;
+    double q = a / b;
+    if (!isfinite(q) || fabs(q) < kTiny || fabs(a) < kTiny) return up(q);
+    double r = fma(-q, b, a);
+    return (r != 0 && (r < 0) == (b < 0)) ? up(q) : q;
+}
+
+double sqrtDown(double v) {
+    double s = std::sqrt(v);
+    if (!isfinite(s) || s < kTiny) return max(0.0, down(s));
+    return fma(-s, s, v) < 0 ? down(s) : s;
+}
+
+double sqrtUp(double v) {
+    double s = std::sqrt(v);
+    if (!isfinite(s) || s < kTiny) return up(s);
+    return fma(-s, s, v) > 0 ? up(s) : s;
+}
+
+// m^n for m >= 0 by repeated squaring, rounded down or up throughout
+double powMagnitude(double m, long long n, bool upward) {
+    double result = 1, base = m;
+    for (; n > 0; n >>= 1) {
+        if (n & 1) result = upward ? mulUp(result, base) : mulDown(result, base);
+        if (n > 1) base = upward ? mulUp(base, base) : mulDown(base, base);
+    }
+    return result;
+}
+
+// x^n of an odd n, which keeps the sign of x
+double powOdd(double x, long long n, bool upward) {
+    return x >= 0 ? powMagnitude(x, n, upward) : -powMagnitude(-x, n, !upward);
+}
+
+// Enclosure of a monotone library function from its values at the ends
+Interval increasing(double (*f)(double), const Interval& a) {
+    return Interval(down2(f(a.lo)), up2(f(a.hi)));
+}
+
+Interval decreasing(double (*f)(double), const Interval& a) {
+    return Interval(down2(f(a.hi)), up2(f(a.lo)));
+}
+
+Interval clampTo(Interval v, double lo, double hi) {
+    return Interval(max(v.lo, lo), min(v.hi, hi));
+}
+
+// Whether a contains some point offset + k period. Points within rounding
+// distance of a count as inside, which can only widen the enclosures.
+bool hitsLattice(const Interval& a, double offset, double period) {
+    double slack = 8 * DBL_EPSILON * max(1.0, max(fabs(a.lo), fabs(a.hi)));
+    double k = std::ceil((a.lo - offset) / period);
+    return offset + (k - 1) * period >= a.lo - slack || offset + k * period <= a.hi + slack;
+}
+
+bool bothEmpty(const Interval& a, const Interval& b) { return a.isEmpty() || b.isEmpty(); }
+
+// Exactly representable decimal literal: m * 10^e with m below 2^53 once
+// its trailing zeros are gone and every 5 of 10^-e divides it out
+bool exactDecimal(const string& text) {
+    const uint64_t limit = uint64_t(1) << 53;
+    size_t i = (!text.empty() && (text[0] == '-' || text[0] == '+')) ? 1 : 0;
+    uint64_t m = 0;
+    int digits = 0, e = 0;
+    bool fraction = false;
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '.') { fraction = true; continue; }
+        if (!isdigit((unsigned char)c)) break;
+        if (fraction) --e;
+        if (m == 0 && c == '0') continue;
+        if (++digits > 19) return false;
+        m = m * 10 + uint64_t(c - '0');
+    }
+    if (i < text.size()) {
+        if (text[i] != 'e' && text[i] != 'E') return false;
+        e += atoi(text.c_str() + i + 1);
+    }
+    if (m == 0) return true;
+    while (m % 10 == 0) { m /= 10; ++e; }
+    for (; e > 0; --e) {
+        if (m > limit / 10) return false;
+        m *= 10;
+    }
+    for (; e < 0; ++e) {
+        if (m % 5 != 0) return false;
+        m /= 5;
+    }
+    return m <= limit;
+}
+
+}
+
+Interval Interval::empty() {
+    double nan = numeric_limits<double>::quiet_NaN();
+    return Interval(nan, nan);
+}
+
+Interval Interval::entire() { return Interval(-kInf, kInf); }
+
+double Interval::mid() const {
+    if (isfinite(lo) && isfinite(hi)) return 0.5 * lo + 0.5 * hi;
+    if (lo == -kInf && hi == kInf) return 0;
+    return lo == -kInf ? -DBL_MAX : DBL_MAX;
+}
+
+bool operator==(const Interval& a, const Interval& b) { return a.lo == b.lo && a.hi == b.hi; }
+bool operator!=(const Interval& a, const Interval& b) { return !(a == b); }
+
+Interval hull(const Interval& a, const Interval& b) {
+    if (a.isEmpty()) return b;
+    if (b.isEmpty()) return a;
+    return Interval(min(a.lo, b.lo), max(a.hi, b.hi));
+}
+
+Interval intersect(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    double lo = max(a.lo, b.lo), hi = min(a.hi, b.hi);
+    return lo <= hi ? Interval(lo, hi) : Interval::empty();
+}
+
+Interval operator+(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    return Interval(addDown(a.lo, b.lo), addUp(a.hi, b.hi));
+}
+
+Interval operator-(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    return Interval(addDown(a.lo, -b.hi), addUp(a.hi, -b.lo));
+}
+
+Interval operator-(const Interval& a) { return Interval(-a.hi, -a.lo); }
+
+Interval operator*(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    double lo = min(min(mulDown(a.lo, b.lo), mulDown(a.lo, b.hi)), min(mulDown(a.hi, b.lo), mulDown(a.hi, b.hi)));
+    double hi = max(max(mulUp(a.lo, b.lo), mulUp(a.lo, b.hi)), max(mulUp(a.hi, b.lo), mulUp(a.hi, b.hi)));
+    return Interval(lo, hi);
+}
+
+Interval operator/(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    if (b.lo == 0 && b.hi == 0) return Interval::empty();
+    if (b.contains(0.0)) return Interval::entire();
+    double q[4] = {divDown(a.lo, b.lo), divDown(a.lo, b.hi), divDown(a.hi, b.lo), divDown(a.hi, b.hi)};
+    double r[4] = {divUp(a.lo, b.lo), divUp(a.lo, b.hi), divUp(a.hi, b.lo), divUp(a.hi, b.hi)};
+    double lo = kInf, hi = -kInf;
+    for (int i = 0; i < 4; ++i) {
+        if (std::isnan(q[i]) || std::isnan(r[i])) return Interval::entire();   // inf / inf
+        lo = min(lo, q[i]);
+        hi = max(hi, r[i]);
+    }
+    return Interval(lo, hi);
+}
+
+Interval& operator+=(Interval& a, const Interval& b) { return a = a + b; }
+Interval& operator-=(Interval& a, const Interval& b) { return a = a - b; }
+Interval& operator*=(Interval& a, const Interval& b) { return a = a * b; }
+
+Interval sin(const Interval& a) {
+    if (a.isEmpty()) return a;
+    if (!isfinite(a.lo) || !isfinite(a.hi) || a.width() >= 2 * kPi) return Interval(-1, 1);
+    double s = std::sin(a.lo), t = std::sin(a.hi);
+    Interval r(down2(min(s, t)), up2(max(s, t)));
+    if (hitsLattice(a, kPi / 2, 2 * kPi)) r.hi = 1;
+    if (hitsLattice(a, -kPi / 2, 2 * kPi)) r.lo = -1;
+    return clampTo(r, -1, 1);
+}
+
+Interval cos(const Interval& a) {
+    if (a.isEmpty()) return a;
+    if (!isfinite(a.lo) || !isfinite(a.hi) || a.width() >= 2 * kPi) return Interval(-1, 1);
+    double s = std::cos(a.lo), t = std::cos(a.hi);
+    Interval r(down2(min(s, t)), up2(max(s, t)));
+    if (hitsLattice(a, 0, 2 * kPi)) r.hi = 1;
+    if (hitsLattice(a, kPi, 2 * kPi)) r.lo = -1;
+    return clampTo(r, -1, 1);
+}
+
+Interval tan(const Interval& a) {
+    if (a.isEmpty()) return a;
+    if (!isfinite(a.lo) || !isfinite(a.hi) || a.width() >= kPi || hitsLattice(a, kPi / 2, kPi))
+        return Interval::entire();
+    return increasing(std::tan, a);
+}
+
+Interval asin(const Interval& a) {
+    Interval d = intersect(a, Interval(-1, 1));
+    if (d.isEmpty()) return d;
+    return increasing(std::asin, d);
+}
+
+Interval acos(const Interval& a) {
+    Interval d = intersect(a, Interval(-1, 1));
+    if (d.isEmpty()) return d;
+    return clampTo(decreasing(std::acos, d), 0, kInf);
+}
+
+Interval atan(const Interval& a) {
+    if (a.isEmpty()) return a;
+    return increasing(std::atan, a);
+}
+
+Interval sinh(const Interval& a) {
+    if (a.isEmpty()) return a;
+    return increasing(std::sinh, a);
+}
+
+Interval cosh(const Interval& a) {
+    if (a.isEmpty()) return a;
+    if (a.lo >= 0) return clampTo(increasing(std::cosh, a), 1, kInf);
+    if (a.hi <= 0) return clampTo(decreasing(std::cosh, a), 1, kInf);
+    return Interval(1, up2(std::cosh(max(-a.lo, a.hi))));
+}
+
+Interval tanh(const Interval& a) {
+    if (a.isEmpty()) return a;
+    return clampTo(increasing(std::tanh, a), -1, 1);
+}
+
+Interval sqrt(const Interval& a) {
+    Interval d = intersect(a, Interval(0, kInf));
+    if (d.isEmpty()) return d;
+    return Interval(sqrtDown(d.lo), sqrtUp(d.hi));
+}
+
+Interval exp(const Interval& a) {
+    if (a.isEmpty()) return a;
+    return clampTo(increasing(std::exp, a), 0, kInf);
+}
+
+Interval log(const Interval& a) {
+    if (a.isEmpty() || a.hi <= 0) return Interval::empty();
+    return Interval(a.lo <= 0 ? -kInf : down2(std::log(a.lo)), up2(std::log(a.hi)));
+}
+
+Interval log10(const Interval& a) {
+    if (a.isEmpty() || a.hi <= 0) return Interval::empty();
+    return Interval(a.lo <= 0 ? -kInf : down2(std::log10(a.lo)), up2(std::log10(a.hi)));
+}
+
+Interval fabs(const Interval& a) {
+    if (a.isEmpty() || a.lo >= 0) return a;
+    if (a.hi <= 0) return -a;
+    return Interval(0, max(-a.lo, a.hi));
+}
+
+Interval floor(const Interval& a) { return Interval(std::floor(a.lo), std::floor(a.hi)); }
+Interval ceil(const Interval& a) { return Interval(std::ceil(a.lo), std::ceil(a.hi)); }
+
+Interval pow(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+
+    // integer exponent: defined for negative bases, and even powers are >= 0
+    if (b.lo == b.hi && b.lo == std::trunc(b.lo) && fabs(b.lo) <= 0x1p62) {
+        long long n = (long long)b.lo;
+        if (n == 0) return Interval(1);
+        Interval p;
+        long long m = n < 0 ? -n : n;
+        if (m % 2 == 1) {
+            p = Interval(powOdd(a.lo, m, false), powOdd(a.hi, m, true));
+        } else {
+            Interval magnitude = fabs(a);
+            p = Interval(powMagnitude(magnitude.lo, m, false), powMagnitude(magnitude.hi, m, true));
+        }
+        return n < 0 ? Interval(1) / p : p;
+    }
+
+    // real exponent: only bases >= 0 are in the domain, and x^y is monotone in
+    // each argument there, so the extremes are at the corners
+    Interval base = intersect(a, Interval(0, kInf));
+    if (base.isEmpty()) return base;
+    double corners[4] = {std::pow(base.lo, b.lo), std::pow(base.lo, b.hi),
+                         std::pow(base.hi, b.lo), std::pow(base.hi, b.hi)};
+    double lo = kInf, hi = -kInf;
+    for (double c : corners) {
+        if (std::isnan(c)) return Interval(0, kInf);
+        lo = min(lo, c);
+        hi = max(hi, c);
+    }
+    return Interval(max(0.0, down2(lo)), up2(hi));
+}
+
+Interval compareLess(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    if (a.hi < b.lo) return Interval(1);
+    if (a.lo >= b.hi) return Interval(0);
+    return Interval(0, 1);
+}
+
+Interval compareLessEqual(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    if (a.hi <= b.lo) return Interval(1);
+    if (a.lo > b.hi) return Interval(0);
+    return Interval(0, 1);
+}
+
+Interval compareEqual(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    if (a.lo == a.hi && a == b) return Interval(1);
+    if (a.hi < b.lo || b.hi < a.lo) return Interval(0);
+    return Interval(0, 1);
+}
+
+Interval select(const Interval& condition, const Interval& a, const Interval& b) {
+    if (condition.isEmpty()) return condition;
+    if (!condition.contains(0.0)) return a;
+    if (condition == Interval(0)) return b;
+    return hull(a, b);
+}
+
+Interval minimum(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    return Interval(min(a.lo, b.lo), min(a.hi, b.hi));
+}
+
+Interval maximum(const Interval& a, const Interval& b) {
+    if (bothEmpty(a, b)) return Interval::empty();
+    return Interval(max(a.lo, b.lo), max(a.hi, b.hi));
+}
+
+Dual<Interval> fabs(const Dual<Interval>& a) {
+    if (a.v.lo >= 0) return a;
+    if (a.v.hi <= 0) return -a;
+    return Dual<Interval>(fabs(a.v), hull(a.d, -a.d));
+}
+
+Interval ScalarTraits<Interval>::parse(const string& text) {
+    double v = strtod(text.c_str(), nullptr);
+    if (exactDecimal(text)) return Interval(v);
+    return Interval(down(v), up(v));
+}
+
+string ScalarTraits<Interval>::format(const Interval& v, int digits) {
+    return "[" + ScalarTraits<double>::format(v.lo, digits) + ", " +
+           ScalarTraits<double>::format(v.hi, digits) + "]";
+}
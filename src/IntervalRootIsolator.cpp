@@ -0,0 +1,177 @@
+#include "IntervalRootIsolator.h"
+#include "ExpressionCache.h"
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Off-centre split, so a root at a "round" point rarely lands on a box edge
+const double kSplit = 0.49609375;
+
+double tolerance(const Interval& x, double xtol) {
+    return xtol * max(1.0, max(fabs(x.lo), fabs(x.hi)));
+}
+
+// One interval Newton step on X, given an enclosure of f' over X that excludes 0
+Interval newtonStep(const EquationParser& parser, const Interval& x, const Interval& slope) {
+    double m = x.mid();
+    Interval fm = parser.evaluateInterval(Interval(m));
+    if (fm.isEmpty()) return x;
+    return Interval(m) - fm / slope;
+}
+
+// Whether X provably holds exactly one root: N(X) inside X with f' away from 0
+bool certify(const EquationParser& parser, const Interval& x, Interval& contracted) {
+    Interval slope;
+    Interval fx = parser.evaluateIntervalDerivative(x, slope);
+    if (fx.isEmpty() || !fx.contains(0.0) || slope.isEmpty() || slope.contains(0.0)) return false;
+    Interval n = newtonStep(parser, x, slope);
+    if (!x.containsInInterior(n)) return false;
+    contracted = n;
+    return true;
+}
+
+// Newton steps on a box known to hold one root, until they stop shrinking it
+Interval contract(const EquationParser& parser, Interval x) {
+    for (int k = 0; k < 64; ++k) {
+        Interval slope;
+        parser.evaluateIntervalDerivative(x, slope);
+        if (slope.isEmpty() || slope.contains(0.0)) break;
+        Interval next = intersect(x, newtonStep(parser, x, slope));
+        if (next.isEmpty() || !(next.width() < x.width())) break;
+        x = next;
+    }
+    return x;
+}
+
+}
+
+IsolationResult isolateRoots(const EquationParser& parser, double a, double b,
+                             const IsolationOptions& options) {
+    if (!(b > a))
+        throw invalid_argument("Upper bound must be greater than lower bound");
+    if (!isfinite(a) || !isfinite(b))
+        throw invalid_argument("Bounds must be finite");
+    NUMERICAL_TIMED("solver.isolate_roots");
+
+    bool newton = options.newton && parser.isSmooth();
+    IsolationResult result;
+    vector<Interval> work(1, Interval(a, b)), undecided;
+
+    while (!work.empty()) {
+        Interval x = work.back();
+        work.pop_back();
+        if (result.boxes >= options.maxBoxes) {
+            undecided.push_back(x);
+            continue;
+        }
+        ++result.boxes;
+
+        Interval slope;
+        Interval fx = newton ? parser.evaluateIntervalDerivative(x, slope) : parser.evaluateInterval(x);
+        if (fx.isEmpty() || !fx.contains(0.0)) {
+            result.excludedWidth += x.width();
+            continue;
+        }
+
+        if (newton && !slope.isEmpty() && !slope.contains(0.0)) {
+            Interval n = newtonStep(parser, x, slope);
+            if (x.containsInInterior(n)) {
+                Interval root = contract(parser, n);
+                result.enclosures.push_back({root.lo, root.hi, true});
+                result.excludedWidth += x.width() - root.width();
+                continue;
+            }
+            Interval kept = intersect(x, n);
+            if (kept.isEmpty()) {
+                result.excludedWidth += x.width();
+                continue;
+            }
+            if (kept.width() < 0.5 * x.width()) {
+                result.excludedWidth += x.width() - kept.width();
+                work.push_back(kept);
+                continue;
+            }
+            x = kept;
+        }
+
+        if (x.width() <= tolerance(x, options.xtol)) {
+            undecided.push_back(x);
+            continue;
+        }
+        double split = x.lo + kSplit * (x.hi - x.lo);
+        work.push_back(Interval(split, x.hi));
+        work.push_back(Interval(x.lo, split));
+    }
+
+    // neighbouring undecided boxes form one cluster; a root sitting on the
+    // edge between two boxes can still be certified on their union
+    sort(undecided.begin(), undecided.end(), [](const Interval& p, const Interval& q) { return p.lo < q.lo; });
+    vector<Interval> clusters;
+    for (const Interval& x : undecided) {
+        if (!clusters.empty() && x.lo <= clusters.back().hi) clusters.back().hi = max(clusters.back().hi, x.hi);
+        else clusters.push_back(x);
+    }
+    for (const Interval& c : clusters) {
+        Interval root;
+        if (newton && certify(parser, c, root)) {
+            root = contract(parser, root);
+            result.enclosures.push_back({root.lo, root.hi, true});
+        } else {
+            result.enclosures.push_back({c.lo, c.hi, false});
+        }
+    }
+
+    sort(result.enclosures.begin(), result.enclosures.end(),
+         [](const RootEnclosure& p, const RootEnclosure& q) { return p.lo < q.lo; });
+    for (const auto& e : result.enclosures)
+        if (e.unique) ++result.certifiedRoots;
+    result.complete = result.certifiedRoots == int(result.enclosures.size());
+    NUMERICAL_COUNT("solver.isolate_roots.boxes", result.boxes);
+    return result;
+}
+
+IsolationResult isolateRoots(const string& expr, double a, double b, const IsolationOptions& options) {
+    return isolateRoots(*compileExpression(expr), a, b, options);
+}
+
+Interval rangeEnclosure(const EquationParser& parser, double a, double b, int pieces) {
+    if (!(b > a))
+        throw invalid_argument("Upper bound must be greater than lower bound");
+    if (pieces < 1)
+        throw invalid_argument("Need at least one piece");
+
+    Interval range = Interval::empty();
+    double left = a;
+    for (int i = 1; i <= pieces; ++i) {
+        double right = (i == pieces) ? b : a + (b - a) * i / pieces;
+        range = hull(range, parser.evaluateInterval(Interval(left, right)));
+        left = right;
+    }
+    return range;
+}
+
+Interval integralEnclosure(const EquationParser& parser, double a, double b, int pieces) {
+    if (!(b > a))
+        throw invalid_argument("Upper bound must be greater than lower bound");
+    if (pieces < 1)
+        throw invalid_argument("Need at least one piece");
+
+    // sum of width * (enclosure of f) over the pieces
+    Interval total(0);
+    double left = a;
+    for (int i = 1; i <= pieces; ++i) {
+        double right = (i == pieces) ? b : a + (b - a) * i / pieces;
+        Interval f = parser.evaluateInterval(Interval(left, right));
+        if (f.isEmpty())
+            throw runtime_error("Integrand is undefined on part of the interval");
+        total += f * (Interval(right) - Interval(left));
+        left = right;
+    }
+    return total;
+}
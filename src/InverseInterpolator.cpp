@@ -0,0 +1,178 @@
+// InverseInterpolator.cpp
+#include "InverseInterpolator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+InverseInterpolator::InverseInterpolator(ColumnView xData, ColumnView yData) {
+    if (xData.size() != yData.size())
+        throw std::invalid_argument("x and y must have the same number of points");
+    if (xData.size() < 2)
+        throw std::invalid_argument("Need at least two points");
+
+    // sort the nodes by x so the runs follow the curve
+    std::vector<size_t> order(xData.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](size_t i, size_t j) { return xData[i] < xData[j]; });
+
+    x.reserve(order.size());
+    y.reserve(order.size());
+    for (size_t i : order) {
+        if (!x.empty() && !(xData[i] > x.back()))
+            throw std::invalid_argument("x values must be distinct");
+        x.push_back(xData[i]);
+        y.push_back(yData[i]);
+    }
+
+    computeSlopes();
+    buildRuns();
+}
+
+// Fritsch-Carlson slopes: zero at local extrema, harmonic mean elsewhere,
+// so the cubic never overshoots the data inside a monotone run
+void InverseInterpolator::computeSlopes() {
+    int n = int(x.size());
+    d.assign(n, 0.0);
+
+    std::vector<double> h(n - 1), delta(n - 1);
+    for (int i = 0; i < n - 1; ++i) {
+        h[i] = x[i + 1] - x[i];
+        delta[i] = (y[i + 1] - y[i]) / h[i];
+    }
+
+    if (n == 2) {
+        d[0] = d[1] = delta[0];
+        return;
+    }
+
+    for (int i = 1; i < n - 1; ++i) {
+        if (delta[i - 1] * delta[i] <= 0) continue;
+        double w1 = 2 * h[i] + h[i - 1];
+        double w2 = h[i] + 2 * h[i - 1];
+        d[i] = (w1 + w2) / (w1 / delta[i - 1] + w2 / delta[i]);
+    }
+
+    // one-sided three-point slopes at the ends, clipped to stay shape preserving
+    auto endSlope = [](double h0, double h1, double del0, double del1) {
+        double s = ((2 * h0 + h1) * del0 - h0 * del1) / (h0 + h1);
+        if (s * del0 <= 0) return 0.0;
+        if (del0 * del1 < 0 && std::fabs(s) > std::fabs(3 * del0)) return 3 * del0;
+        return s;
+    };
+    d[0] = endSlope(h[0], h[1], delta[0], delta[1]);
+    d[n - 1] = endSlope(h[n - 2], h[n - 3], delta[n - 2], delta[n - 3]);
+}
+
+// Group consecutive segments with the same direction of y
+void InverseInterpolator::buildRuns() {
+    int n = int(x.size());
+    auto direction = [&](int k) {
+        return (y[k + 1] > y[k]) - (y[k + 1] < y[k]);
+    };
+
+    int start = 0;
+    for (int k = 1; k <= n - 1; ++k) {
+        if (k < n - 1 && direction(k) == direction(start)) continue;
+
+        Run run;
+        run.first = start;
+        run.last = k;
+        run.increasing = direction(start) >= 0;
+        run.yMin = std::min(y[start], y[k]);
+        run.yMax = std::max(y[start], y[k]);
+        runs.push_back(run);
+        start = k;
+    }
+}
+
+// Binary search for the segment [k, k+1] of a run whose y-range holds yValue
+int InverseInterpolator::locateSegment(const Run& run, double yValue) const {
+    auto begin = y.begin() + run.first;
+    auto end = y.begin() + run.last + 1;
+    auto pos = run.increasing ? std::upper_bound(begin, end, yValue)
+                              : std::upper_bound(begin, end, yValue, std::greater<double>());
+    int k = int(pos - y.begin()) - 1;
+    return std::min(std::max(k, run.first), run.last - 1);
+}
+
+// Cubic Hermite on segment k at local coordinate t in [0, 1]
+double InverseInterpolator::hermite(int k, double t, double* derivative) const {
+    double h = x[k + 1] - x[k];
+    double t2 = t * t, t3 = t2 * t;
+
+    double value = (2 * t3 - 3 * t2 + 1) * y[k] + (t3 - 2 * t2 + t) * h * d[k]
+                 + (-2 * t3 + 3 * t2) * y[k + 1] + (t3 - t2) * h * d[k + 1];
+
+    if (derivative) {
+        *derivative = (6 * t2 - 6 * t) * y[k] + (3 * t2 - 4 * t + 1) * h * d[k]
+                    + (-6 * t2 + 6 * t) * y[k + 1] + (3 * t2 - 2 * t) * h * d[k + 1];
+    }
+    return value;
+}
+
+// Safeguarded Newton on the (monotone) segment cubic
+double InverseInterpolator::invertSegment(int k, double yValue) const {
+    double y0 = y[k], y1 = y[k + 1];
+    if (yValue == y0) return x[k];
+    if (yValue == y1) return x[k + 1];
+
+    double sign = (y1 > y0) ? 1.0 : -1.0;
+    double lo = 0.0, hi = 1.0;
+    double t = (yValue - y0) / (y1 - y0);
+    double tol = 4 * std::numeric_limits<double>::epsilon() * std::max(1.0, std::fabs(yValue));
+
+    for (int iter = 0; iter < 100 && hi - lo > std::numeric_limits<double>::epsilon(); ++iter) {
+        double slope;
+        double g = hermite(k, t, &slope) - yValue;
+        if (std::fabs(g) <= tol) break;
+
+        if (sign * g < 0) lo = t;
+        else hi = t;
+
+        double next = (slope != 0) ? t - g / slope : lo - 1;
+        t = (next > lo && next < hi) ? next : 0.5 * (lo + hi);
+    }
+
+    return x[k] + t * (x[k + 1] - x[k]);
+}
+
+std::vector<double> InverseInterpolator::solve(double yValue) const {
+    std::vector<double> roots;
+    if (std::isnan(yValue)) return roots;
+
+    for (const Run& run : runs) {
+        if (yValue < run.yMin || yValue > run.yMax) continue;
+
+        if (run.yMin == run.yMax) {
+            // plateau: every x in it maps to yValue, report its end points
+            roots.push_back(x[run.first]);
+            roots.push_back(x[run.last]);
+            continue;
+        }
+        roots.push_back(invertSegment(locateSegment(run, yValue), yValue));
+    }
+
+    // a node shared by two runs (a turning point) is found twice
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+    return roots;
+}
+
+std::vector<std::vector<double>> InverseInterpolator::solve(const std::vector<double>& yValues) const {
+    std::vector<std::vector<double>> results;
+    results.reserve(yValues.size());
+    for (double yValue : yValues) results.push_back(solve(yValue));
+    return results;
+}
+
+double InverseInterpolator::evaluate(double xValue) const {
+    auto pos = std::upper_bound(x.begin(), x.end(), xValue);
+    int k = int(pos - x.begin()) - 1;
+    k = std::min(std::max(k, 0), int(x.size()) - 2);
+    return hermite(k, (xValue - x[k]) / (x[k + 1] - x[k]), nullptr);
+}
@@ -1,48 +1,48 @@
 // LagrangeInterpolator.cpp
 #include "LagrangeInterpolator.h"
+#include "PolynomialRoots.h"
+#include "ExtendedPrecision.h"
+#include <stdexcept>
 
 LagrangeInterpolator::LagrangeInterpolator(const std::vector<double>& xData, const std::vector<double>& yData)
     : x(xData), y(yData) {}
 
-double LagrangeInterpolator::interpolateY(double xValue) const {
-    int n = x.size();
-    double result = 0.0;
-
-    for (int i = 0; i < n; ++i) {
-        double numerator = 1.0;
-        double denominator = 1.0;
+LagrangeInterpolator::LagrangeInterpolator(ColumnView xData, ColumnView yData)
+    : x(xData), y(yData) {}
 
-        for (int j = 0; j < n; ++j) {
-            if (i != j) {
-                numerator *= (xValue - x[j]);
-                denominator *= (x[i] - x[j]);
-            }
-        }
+double LagrangeInterpolator::interpolateY(double xValue) const {
+    return lagrangeValue(x.data(), y.data(), x.size(), xValue);
+}
 
-        result += y[i] * (numerator / denominator);
-    }
+std::vector<double> LagrangeInterpolator::coefficients() const {
+    // same polynomial in Newton form
+    std::vector<double> c = y.toVector();
+    dividedDifferences(x, c);
+    return newtonToMonomial(x.toVector(), c);
+}
 
-    return result;
+// Forward interpolation never needs the monotone segments, so they are only
+// built here; threads racing on the first query may each build them, and the
+// first one stored is kept (and never replaced)
+const InverseInterpolator& LagrangeInterpolator::inverted() const {
+    std::shared_ptr<const InverseInterpolator> built = std::atomic_load(&inverse);
+    if (built) return *built;
+    std::shared_ptr<const InverseInterpolator> fresh = std::make_shared<const InverseInterpolator>(x, y);
+    if (!std::atomic_compare_exchange_strong(&inverse, &built, fresh)) return *built;
+    return *fresh;
 }
 
 double LagrangeInterpolator::interpolateX(double yValue) const {
-    // Swap x and y, and interpolate normally
-    int n = y.size();
-    double result = 0.0;
-
-    for (int i = 0; i < n; ++i) {
-        double numerator = 1.0;
-        double denominator = 1.0;
-
-        for (int j = 0; j < n; ++j) {
-            if (i != j) {
-                numerator *= (yValue - y[j]);
-                denominator *= (y[i] - y[j]);
-            }
-        }
+    std::vector<double> roots = inverted().solve(yValue);
+    if (roots.empty())
+        throw std::domain_error("y value is outside the range of the data");
+    return roots.front();
+}
 
-        result += x[i] * (numerator / denominator);
-    }
+std::vector<double> LagrangeInterpolator::interpolateXAll(double yValue) const {
+    return inverted().solve(yValue);
+}
 
-    return result;
+std::vector<std::vector<double>> LagrangeInterpolator::interpolateX(const std::vector<double>& yValues) const {
+    return inverted().solve(yValues);
 }
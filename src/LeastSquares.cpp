@@ -0,0 +1,119 @@
+#include "LeastSquares.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+QRLeastSquares::QRLeastSquares(int columns)
+ : n(columns), count(0),
+   R(columns, columns),
+   qtb(columns, 0.0),
+   residualSq(0.0)
+{
+    if (columns <= 0)
+        throw std::invalid_argument("Need at least one column");
+}
+
+// Column j of the stacked matrix [R; A] only has nonzeros at R(j,j) and in
+// the new block, so each reflector touches one row of R plus the block.
+void QRLeastSquares::addRows(DenseMatrix& At, double* b, int rows) {
+    if (rows <= 0) return;
+    if (At.rows() != n || At.cols() < rows)
+        throw std::invalid_argument("Row block does not match the factorization");
+
+    for (int j = 0; j < n; ++j) {
+        double* aj = At.row(j);
+
+        double sigma = 0;
+        for (int i = 0; i < rows; ++i) sigma += aj[i] * aj[i];
+        if (sigma == 0) continue;
+
+        double r = R(j, j);
+        double norm = std::sqrt(r * r + sigma);
+        double beta = (r >= 0) ? -norm : norm;
+        double tau = (beta - r) / beta;
+        double scale = 1.0 / (r - beta);
+        for (int i = 0; i < rows; ++i) aj[i] *= scale;   // v = [1; aj]
+        R(j, j) = beta;
+
+        // apply H = I - tau v v^T to the remaining columns and to b
+        for (int k = j + 1; k < n; ++k) {
+            double* ak = At.row(k);
+            double& rjk = R(j, k);
+            double s = rjk;
+            for (int i = 0; i < rows; ++i) s += aj[i] * ak[i];
+            s *= tau;
+            rjk -= s;
+            for (int i = 0; i < rows; ++i) ak[i] -= s * aj[i];
+        }
+
+        double s = qtb[j];
+        for (int i = 0; i < rows; ++i) s += aj[i] * b[i];
+        s *= tau;
+        qtb[j] -= s;
+        for (int i = 0; i < rows; ++i) b[i] -= s * aj[i];
+    }
+
+    // what is left of b is orthogonal to the column space
+    for (int i = 0; i < rows; ++i) residualSq += b[i] * b[i];
+    count += rows;
+}
+
+// [R1; R2] has the same least-squares solution as the rows behind both
+void QRLeastSquares::merge(const QRLeastSquares& other) {
+    if (other.n != n)
+        throw std::invalid_argument("Cannot merge factorizations of different widths");
+
+    DenseMatrix At = other.R.transposed();
+    std::vector<double> b(other.qtb);
+    addRows(At, b.data(), n);
+    count += other.count - n;
+    residualSq += other.residualSq;
+}
+
+std::vector<double> QRLeastSquares::solve() const {
+    std::vector<double> c(n);
+    for (int i = n - 1; i >= 0; --i) {
+        double rii = R(i, i);
+        if (rii == 0)
+            throw std::runtime_error("Least-squares system is rank deficient");
+        double sum = qtb[i];
+        for (int j = i + 1; j < n; ++j)
+            sum -= R(i, j) * c[j];
+        c[i] = sum / rii;
+    }
+    return c;
+}
+
+double QRLeastSquares::residualNorm() const {
+    return std::sqrt(residualSq);
+}
+
+double QRLeastSquares::conditionEstimate() const {
+    // ||R||_1 * ||R^-1||_1, with R^-1 formed column by column (n is small)
+    double normR = 0, normInv = 0;
+    std::vector<double> col(n);
+
+    for (int k = 0; k < n; ++k) {
+        double sum = 0;
+        for (int i = 0; i <= k; ++i) sum += std::fabs(R(i, k));
+        normR = std::max(normR, sum);
+    }
+
+    for (int k = 0; k < n; ++k) {
+        // solve R col = e_k
+        std::fill(col.begin(), col.end(), 0.0);
+        double sum = 0;
+        for (int i = k; i >= 0; --i) {
+            double rii = R(i, i);
+            if (rii == 0) return INFINITY;
+            double v = (i == k) ? 1.0 : 0.0;
+            for (int j = i + 1; j <= k; ++j)
+                v -= R(i, j) * col[j];
+            col[i] = v / rii;
+            sum += std::fabs(col[i]);
+        }
+        normInv = std::max(normInv, sum);
+    }
+
+    return normR * normInv;
+}
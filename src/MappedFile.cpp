@@ -0,0 +1,80 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string& path)
+    : address(nullptr), length(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+{
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        throw runtime_error("Cannot open file: " + path);
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        throw runtime_error("Cannot read size of file: " + path);
+    }
+    length = size_t(fileSize.QuadPart);
+    if (length == 0) return;
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle) address = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!address) {
+        if (mappingHandle) CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        throw runtime_error("Cannot map file: " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (address) UnmapViewOfFile(address);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const string& path) : address(nullptr), length(0), fd(-1) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw runtime_error("Cannot open file: " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw runtime_error("Cannot read size of file: " + path);
+    }
+    length = size_t(info.st_size);
+    if (length == 0) return;
+
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        throw runtime_error("Cannot map file: " + path);
+    }
+    address = mapped;
+    madvise(address, length, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+    if (address) munmap(address, length);
+    if (fd >= 0) close(fd);
+}
+
+#endif
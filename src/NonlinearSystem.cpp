@@ -0,0 +1,276 @@
+#include "NonlinearSystem.h"
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+double maxNorm(const vector<double>& v) {
+    double m = 0;
+    for (double e : v) m = max(m, fabs(e));
+    return m;
+}
+
+double halfSquaredNorm(const vector<double>& v) {
+    double s = 0;
+    for (double e : v) s += e * e;
+    return 0.5 * s;
+}
+
+// "lhs = rhs" becomes "(lhs)-(rhs)"; ==, <=, >= and != are comparisons
+string residualForm(const string& equation) {
+    size_t eq = string::npos;
+    for (size_t i = 0; i < equation.size(); ++i) {
+        if (equation[i] != '=') continue;
+        bool comparison = (i + 1 < equation.size() && equation[i + 1] == '=') ||
+                          (i > 0 && string("=<>!").find(equation[i - 1]) != string::npos);
+        if (comparison) continue;
+        if (eq != string::npos)
+            throw invalid_argument("Equation has more than one '=': " + equation);
+        eq = i;
+    }
+    if (eq == string::npos) return equation;
+    return "(" + equation.substr(0, eq) + ")-(" + equation.substr(eq + 1) + ")";
+}
+
+}
+
+NonlinearSystem::NonlinearSystem(const vector<string>& eqs, const vector<string>& unknowns,
+                                 const map<string, double>& constants)
+    : n(int(unknowns.size())), names(unknowns) {
+    if (n == 0) throw invalid_argument("Need at least one unknown");
+    if (eqs.size() != unknowns.size())
+        throw invalid_argument("Need as many equations as unknowns");
+
+    // x and y keep their own slots in the parser; every other unknown, and
+    // every constant, is a named parameter
+    vector<string> params;
+    slot.assign(n, -1);
+    for (int j = 0; j < n; ++j) {
+        if (count(unknowns.begin(), unknowns.begin() + j, unknowns[j]))
+            throw invalid_argument("Unknown '" + unknowns[j] + "' listed twice");
+        if (unknowns[j] == "x") slot[j] = 0;
+        else if (unknowns[j] == "y") slot[j] = 1;
+        else {
+            slot[j] = 2 + int(params.size());
+            params.push_back(unknowns[j]);
+        }
+    }
+    size_t unknownParams = params.size();
+    for (const auto& c : constants) {
+        if (find(unknowns.begin(), unknowns.end(), c.first) != unknowns.end())
+            throw invalid_argument("'" + c.first + "' is both an unknown and a constant");
+        params.push_back(c.first);
+    }
+
+    parameterValues.assign(params.size(), 0.0);
+    size_t k = unknownParams;
+    for (const auto& c : constants) parameterValues[k++] = c.second;
+
+    for (int i = 0; i < n; ++i)
+        equations.push_back(compileExpression(residualForm(eqs[i]), true, params));
+}
+
+NonlinearSystem::NonlinearSystem(int size, Function F, Jacobian J)
+    : n(size), callback(move(F)), callbackJacobian(move(J)) {
+    if (n <= 0) throw invalid_argument("Need at least one unknown");
+    if (!callback) throw invalid_argument("Need a residual function");
+    for (int j = 0; j < n; ++j) names.push_back("v" + to_string(j));
+}
+
+void NonlinearSystem::load(const vector<double>& v, double& x, double& y, vector<double>& params) const {
+    x = y = 0;
+    params = parameterValues;
+    for (int j = 0; j < n; ++j) {
+        if (slot[j] == 0) x = v[j];
+        else if (slot[j] == 1) y = v[j];
+        else params[slot[j] - 2] = v[j];
+    }
+}
+
+void NonlinearSystem::evaluate(const vector<double>& v, vector<double>& F) const {
+    if (int(v.size()) != n) throw invalid_argument("Need one value per unknown");
+    F.resize(n);
+    if (callback) {
+        callback(v, F);
+        if (int(F.size()) != n) throw runtime_error("Residual function returned the wrong size");
+        return;
+    }
+
+    double x, y;
+    vector<double> params;
+    load(v, x, y, params);
+    for (int i = 0; i < n; ++i) F[i] = equations[i]->evaluate(x, y, params.data());
+}
+
+void NonlinearSystem::jacobian(const vector<double>& v, DenseMatrix& J) const {
+    if (int(v.size()) != n) throw invalid_argument("Need one value per unknown");
+    J.resize(n, n);
+
+    if (callback) {
+        if (callbackJacobian) {
+            callbackJacobian(v, J);
+            return;
+        }
+        // forward differences, one column per unknown
+        vector<double> F0, F1, w(v);
+        evaluate(v, F0);
+        for (int j = 0; j < n; ++j) {
+            double h = sqrt(numeric_limits<double>::epsilon()) * max(1.0, fabs(v[j]));
+            w[j] = v[j] + h;
+            h = w[j] - v[j];   // the step actually taken
+            evaluate(w, F1);
+            for (int i = 0; i < n; ++i) J(i, j) = (F1[i] - F0[i]) / h;
+            w[j] = v[j];
+        }
+        return;
+    }
+
+    double x, y;
+    vector<double> params;
+    load(v, x, y, params);
+    vector<double> gradient(params.size() + 2);
+    for (int i = 0; i < n; ++i) {
+        equations[i]->evaluateGradient(x, y, params.data(), gradient.data());
+        for (int j = 0; j < n; ++j) J(i, j) = gradient[slot[j]];
+    }
+}
+
+// Damped Newton / Broyden. Each step solves J p = -F by LU and backtracks
+// along p until 0.5 |F|^2 decreases enough (Armijo). Broyden keeps J up to
+// date with the rank-1 update J += (dF - J s) s^T / s^T s and only goes back
+// to the exact Jacobian when its direction stops making progress.
+SystemResult NonlinearSystem::solve(const vector<double>& guess, const SystemOptions& options) const {
+    if (int(guess.size()) != n) throw invalid_argument("Need one starting value per unknown");
+    NUMERICAL_SOLVER(telemetry, "solver.nonlinear_system");
+
+    SystemResult result;
+    result.iterations = 0;
+    result.functionEvaluations = 0;
+    result.jacobianEvaluations = 0;
+    result.converged = false;
+
+    vector<double> v(guess), F, trial(n), Ft, p(n), Jp;
+    evaluate(v, F);
+    result.functionEvaluations = 1;
+
+    DenseMatrix J;
+    bool fresh = false;   // J is the exact Jacobian at v
+    const double armijo = 1e-4;
+
+    while (result.iterations < options.maxIterations) {
+        if (maxNorm(F) <= options.ftol) { result.converged = true; break; }
+
+        if (options.method == SystemMethod::Newton || result.jacobianEvaluations == 0) {
+            jacobian(v, J);
+            ++result.jacobianEvaluations;
+            fresh = true;
+        }
+
+        for (int i = 0; i < n; ++i) p[i] = -F[i];
+        bool solved = true;
+        try {
+            LUDecomposition lu(J);
+            lu.solveInPlace(p.data());
+        } catch (const runtime_error&) {
+            solved = false;
+        }
+
+        // slope of 0.5 |F|^2 along p is F^T J p
+        double slope = 0;
+        if (solved) {
+            Jp = J.multiply(p);
+            for (int i = 0; i < n; ++i) slope += F[i] * Jp[i];
+        }
+        if (!solved || !(slope < 0)) {
+            if (!fresh) {   // stale Broyden matrix: retry with the exact one
+                jacobian(v, J);
+                ++result.jacobianEvaluations;
+                fresh = true;
+                continue;
+            }
+            // singular Jacobian: steepest descent on 0.5 |F|^2
+            slope = 0;
+            for (int j = 0; j < n; ++j) {
+                double g = 0;
+                for (int i = 0; i < n; ++i) g += J(i, j) * F[i];
+                p[j] = -g;
+                slope -= g * g;
+            }
+            if (slope == 0) break;   // stationary point of |F| that is not a root
+        }
+
+        if (maxNorm(p) <= options.xtol * (1 + maxNorm(v))) {
+            for (int j = 0; j < n; ++j) v[j] += p[j];
+            evaluate(v, F);
+            ++result.functionEvaluations;
+            ++result.iterations;
+            result.converged = true;
+            break;
+        }
+
+        double phi0 = halfSquaredNorm(F);
+        double t = 1;
+        bool accepted = false;
+        while (t > 1e-10) {
+            for (int j = 0; j < n; ++j) trial[j] = v[j] + t * p[j];
+            double phi = numeric_limits<double>::infinity();
+            try {
+                evaluate(trial, Ft);
+                phi = halfSquaredNorm(Ft);
+            } catch (const runtime_error&) {
+                // outside the domain of some equation: treat as a failed trial
+            }
+            ++result.functionEvaluations;
+
+            if (isfinite(phi) && (!options.lineSearch || phi <= phi0 + armijo * t * slope)) {
+                accepted = true;
+                break;
+            }
+
+            // minimiser of the quadratic through phi0, slope and phi, kept in [0.1t, 0.5t]
+            double next = 0.1 * t;
+            if (isfinite(phi)) next = -slope * t * t / (2 * (phi - phi0 - slope * t));
+            t = min(max(next, 0.1 * t), 0.5 * t);
+        }
+
+        if (!accepted) {
+            if (!fresh) {
+                jacobian(v, J);
+                ++result.jacobianEvaluations;
+                fresh = true;
+                continue;
+            }
+            break;   // no decrease even along the exact Newton direction
+        }
+
+        if (options.method == SystemMethod::Broyden) {
+            // J += (dF - J s) s^T / (s^T s), with s = t p and J s = t J p
+            double ss = 0;
+            for (int j = 0; j < n; ++j) ss += t * p[j] * t * p[j];
+            Jp = J.multiply(p);
+            for (int i = 0; i < n; ++i) {
+                double r = (Ft[i] - F[i] - t * Jp[i]) / ss;
+                double* row = J.row(i);
+                for (int j = 0; j < n; ++j) row[j] += r * t * p[j];
+            }
+            fresh = false;
+        }
+
+        v.swap(trial);
+        F.swap(Ft);
+        ++result.iterations;
+        NUMERICAL_CONVERGENCE(telemetry, result.iterations, v[0], maxNorm(F), t * maxNorm(p));
+    }
+
+    result.solution = v;
+    result.residual = F;
+    result.residualNorm = maxNorm(F);
+    if (result.residualNorm <= options.ftol) result.converged = true;
+    return result;
+}
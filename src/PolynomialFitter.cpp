@@ -1,78 +1,156 @@
 #include "PolynomialFitter.h"
+#include "StreamingPolynomialFitter.h"
+#include "PolynomialRoots.h"
+#include "ResultCache.h"
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 
-// constructor: copy data & allocate matrix
+// constructors: copy or view the data & choose the x scaling
 PolynomialFitter::PolynomialFitter(const std::vector<double>& xv,
                                    const std::vector<double>& yv,
-                                   int degree)
+                                   int degree,
+                                   bool scaleX)
+ : PolynomialFitter(ColumnData(xv), ColumnData(yv), degree, scaleX) {}
+
+PolynomialFitter::PolynomialFitter(ColumnView xv, ColumnView yv, int degree, bool scaleX)
+ : PolynomialFitter(ColumnData(xv), ColumnData(yv), degree, scaleX) {}
+
+PolynomialFitter::PolynomialFitter(ColumnData xv, ColumnData yv, int degree, bool scaleX)
  : N(int(xv.size())), n(degree),
    x(xv), y(yv),
-   a(degree + 1),
-   B(degree + 1, std::vector<double>(degree + 2))
+   a(degree + 1), b(degree + 1),
+   center(0.0), halfWidth(1.0),
+   residual(0.0), condition(0.0)
 {
     if (N == 0 || degree < 0 || N <= degree)
         throw std::invalid_argument("Need more points than degree");
+    if (yv.size() != xv.size())
+        throw std::invalid_argument("x and y must have the same number of points");
+    computeScaling(scaleX);
+}
+
+void PolynomialFitter::computeScaling(bool scaleX) {
+    if (!scaleX) return;
+    auto range = std::minmax_element(x.begin(), x.end());
+    center = 0.5 * (*range.first + *range.second);
+    halfWidth = 0.5 * (*range.second - *range.first);
+    if (halfWidth == 0) halfWidth = 1.0;
 }
 
 void PolynomialFitter::fit() {
-    buildNormalMatrix();
-    gaussianElimination();
-    backSubstitution();
+    // with a result cache enabled, the same data, degree, scaling and weights
+    // fitted before (by any process) are not fitted again
+    std::shared_ptr<ResultCache> cache = ResultCache::global();
+    ResultKey key("fit.polynomial");
+    if (cache) {
+        key.add(x.data(), x.size()).add(y.data(), y.size()).add(double(n)).add(center).add(halfWidth);
+        key.add(w.data(), w.size());
+        std::vector<double> cached;
+        if (cache->lookup(key, cached) && int(cached.size()) == n + 5) {
+            center = cached[0];
+            halfWidth = cached[1];
+            residual = cached[2];
+            condition = cached[3];
+            b.assign(cached.begin() + 4, cached.end());
+            a = StreamingPolynomialFitter::toMonomial(b, center, halfWidth);
+            if (!w.empty()) finalW = w;
+            return;
+        }
+    }
+
+    if (!w.empty()) {
+        WeightedLeastSquares solver(designMatrix(), y.toVector());
+        store(solver, solver.solve(w));
+    } else {
+        StreamingPolynomialFitter stream(n, center - halfWidth, center + halfWidth);
+        stream.add(x.data(), y.data(), x.size());
+
+        center = stream.shift();
+        halfWidth = stream.scale();
+        b = stream.scaledCoefficients();
+        a = StreamingPolynomialFitter::toMonomial(b, center, halfWidth);
+        residual = stream.residualNorm();
+        condition = stream.conditionEstimate();
+    }
+
+    if (cache) {
+        std::vector<double> values = {center, halfWidth, residual, condition};
+        values.insert(values.end(), b.begin(), b.end());
+        cache->store(key, values);
+    }
+}
+
+void PolynomialFitter::setWeights(const std::vector<double>& weights) {
+    if (int(weights.size()) != N)
+        throw std::invalid_argument("Need one weight per point");
+    w = weights;
+}
+
+void PolynomialFitter::fitRobust(RobustLoss loss, double tuning, int maxIterations) {
+    WeightedLeastSquares solver(designMatrix(), y.toVector());
+    store(solver, solver.solveRobust(loss, tuning, w, maxIterations));
 }
 
 const std::vector<double>&
-PolynomialFitter::coefficients() const {
-    return a;
+PolynomialFitter::robustWeights() const {
+    return finalW;
 }
 
-void PolynomialFitter::buildNormalMatrix() {
-    // compute all sums Σ x^k for k = 0..2n
-    std::vector<double> X(2*n + 1, 0.0);
-    for (int k = 0; k < 2*n + 1; ++k)
+DenseMatrix PolynomialFitter::designMatrix() const {
+    DenseMatrix Vt(n + 1, N);
+    for (int i = 0; i < N; ++i) Vt(0, i) = 1.0;
+    for (int k = 1; k <= n; ++k) {
+        const double* prev = Vt.row(k - 1);
+        double* powers = Vt.row(k);
         for (int i = 0; i < N; ++i)
-            X[k] += std::pow(x[i], k);
-
-    // fill normal‐eqns coefficients
-    for (int i = 0; i <= n; ++i)
-        for (int j = 0; j <= n; ++j)
-            B[i][j] = X[i + j];
-
-    // compute RHS sums Σ x^k * y for k = 0..n
-    for (int i = 0; i <= n; ++i) {
-        double sum = 0;
-        for (int j = 0; j < N; ++j)
-            sum += std::pow(x[j], i) * y[j];
-        B[i][n+1] = sum;
+            powers[i] = prev[i] * ((x[i] - center) / halfWidth);
     }
+    return Vt;
 }
 
-void PolynomialFitter::gaussianElimination() {
-    int m = n + 1;
-    // pivot and eliminate below
-    for (int i = 0; i < m; ++i) {
-        // pivot: find row with max abs in column i and swap
-        int maxr = i;
-        for (int k = i+1; k < m; ++k)
-            if (std::fabs(B[k][i]) > std::fabs(B[maxr][i]))
-                maxr = k;
-        std::swap(B[i], B[maxr]);
-
-        // eliminate rows below
-        for (int k = i+1; k < m; ++k) {
-            double t = B[k][i] / B[i][i];
-            for (int j = i; j <= m; ++j)
-                B[k][j] -= t * B[i][j];
-        }
-    }
+void PolynomialFitter::store(const WeightedLeastSquares& solver, const std::vector<double>& coeffs) {
+    b = coeffs;
+    a = StreamingPolynomialFitter::toMonomial(b, center, halfWidth);
+    residual = solver.residualNorm();
+    condition = solver.conditionEstimate();
+    finalW = solver.weights();
 }
 
-void PolynomialFitter::backSubstitution() {
-    int m = n + 1;
-    for (int i = m - 1; i >= 0; --i) {
-        a[i] = B[i][m];
-        for (int j = i+1; j < m; ++j)
-            a[i] -= B[i][j] * a[j];
-        a[i] /= B[i][i];
-    }
+const std::vector<double>&
+PolynomialFitter::coefficients() const {
+    return a;
+}
+
+const std::vector<double>&
+PolynomialFitter::scaledCoefficients() const {
+    return b;
+}
+
+double PolynomialFitter::evaluate(double xValue) const {
+    double t = (xValue - center) / halfWidth;
+    double result = 0;
+    for (int k = n; k >= 0; --k)
+        result = result * t + b[k];
+    return result;
+}
+
+double PolynomialFitter::residualNorm() const {
+    return residual;
+}
+
+double PolynomialFitter::conditionEstimate() const {
+    return condition;
+}
+
+std::vector<double> PolynomialFitter::roots() const {
+    std::vector<double> r = realPolynomialRoots(b);
+    for (double& t : r) t = center + halfWidth * t;
+    return r;
+}
+
+std::vector<double> PolynomialFitter::extrema() const {
+    std::vector<double> r = polynomialExtrema(b);
+    for (double& t : r) t = center + halfWidth * t;
+    return r;
 }
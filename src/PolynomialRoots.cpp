@@ -0,0 +1,177 @@
+#include "PolynomialRoots.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+typedef complex<double> cplx;
+
+const double kEps = numeric_limits<double>::epsilon();
+
+// Complex products written out: std::complex operator* and / go through
+// the slow Annex G (inf/nan aware) library routines unless -ffast-math is set.
+inline cplx mul(cplx u, cplx v) {
+    return cplx(u.real() * v.real() - u.imag() * v.imag(), u.real() * v.imag() + u.imag() * v.real());
+}
+inline cplx div(cplx u, cplx v) {
+    double s = 1.0 / (v.real() * v.real() + v.imag() * v.imag());
+    return cplx((u.real() * v.real() + u.imag() * v.imag()) * s, (u.imag() * v.real() - u.real() * v.imag()) * s);
+}
+
+// p(z) / p'(z) by Horner. For |z| > 1 the reversed polynomial in 1/z is used
+// instead, so large roots of high-degree polynomials do not overflow.
+// *residual receives |p(z)| (|p(z)| / |z|^n in the reversed case).
+cplx newtonCorrection(const vector<double>& a, cplx z, double* residual) {
+    int n = int(a.size()) - 1;
+    if (abs(z) <= 1) {
+        cplx p = a[n], dp = 0;
+        for (int k = n - 1; k >= 0; --k) {
+            dp = mul(dp, z) + p;
+            p = mul(p, z) + a[k];
+        }
+        if (residual) *residual = abs(p);
+        return div(p, dp);
+    }
+
+    // p(z) = z^n q(y), y = 1/z, q(y) = sum a[n-k] y^k
+    cplx y = div(1.0, z), q = a[0], dq = 0;
+    for (int k = 1; k <= n; ++k) {
+        dq = mul(dq, y) + q;
+        q = mul(q, y) + a[k];
+    }
+    if (residual) *residual = abs(q);
+    return div(z, double(n) - mul(y, div(dq, q)));
+}
+
+// Rounding-error bound for Horner at z, relative stopping test for polishing
+double hornerBound(const vector<double>& a, cplx z) {
+    double r = abs(z), bound = 0, power = 1;
+    if (r <= 1) {
+        for (double c : a) { bound += fabs(c) * power; power *= r; }
+    } else {
+        // matches the reversed evaluation used for |z| > 1
+        double inv = 1 / r;
+        for (int k = int(a.size()) - 1; k >= 0; --k) { bound += fabs(a[k]) * power; power *= inv; }
+    }
+    return 4 * kEps * bound * a.size();
+}
+
+}
+
+vector<cplx> polynomialRoots(const vector<double>& coeffs, int maxIterations) {
+    vector<double> a(coeffs);
+    while (!a.empty() && a.back() == 0) a.pop_back();
+    if (a.empty())
+        throw invalid_argument("The zero polynomial has no isolated roots");
+
+    // zero roots come out exactly
+    vector<cplx> roots;
+    size_t zeros = 0;
+    while (zeros < a.size() - 1 && a[zeros] == 0) ++zeros;
+    roots.assign(zeros, cplx(0, 0));
+    a.erase(a.begin(), a.begin() + zeros);
+
+    int n = int(a.size()) - 1;
+    if (n == 0) return roots;
+    if (n == 1) {
+        roots.push_back(-a[0] / a[1]);
+        return roots;
+    }
+
+    // start on a circle whose radius is the geometric mean of the root moduli,
+    // rotated off the real axis so conjugate pairs can separate
+    double radius = pow(fabs(a[0] / a[n]), 1.0 / n);
+    vector<cplx> z(n);
+    const double pi = acos(-1.0);
+    for (int k = 0; k < n; ++k)
+        z[k] = polar(radius, 2 * pi * k / n + 0.4);
+
+    // Aberth-Ehrlich, Gauss-Seidel style (updated roots are used immediately)
+    vector<char> done(n, 0);
+    vector<double> lastStep(n, numeric_limits<double>::infinity());
+    int remaining = n;
+    for (int iter = 0; iter < maxIterations && remaining > 0; ++iter) {
+        for (int i = 0; i < n; ++i) {
+            if (done[i]) continue;
+
+            double residual;
+            cplx ratio = newtonCorrection(a, z[i], &residual);
+            if (residual == 0) {
+                done[i] = 1;
+                --remaining;
+                continue;
+            }
+
+            cplx sum = 0;
+            for (int j = 0; j < n; ++j)
+                if (j != i) sum += div(1.0, z[i] - z[j]);
+            cplx w = div(ratio, 1.0 - mul(ratio, sum));
+            z[i] -= w;
+
+            // converged, or stuck at the rounding floor of p (steps stopped shrinking)
+            double size = abs(w);
+            bool stalled = size >= lastStep[i] && residual <= hornerBound(a, z[i]);
+            lastStep[i] = size;
+            if (size <= 2 * kEps * abs(z[i]) || stalled || !isfinite(size)) {
+                done[i] = 1;
+                --remaining;
+            }
+        }
+    }
+
+    // Newton polishing; keep a step only while it reduces |p|.
+    // Multiple and ill-conditioned real roots stall slightly off the real axis;
+    // such a root is snapped onto it when p is no larger there.
+    for (cplx& root : z) {
+        if (root.imag() != 0 && fabs(root.imag()) <= 1e-4 * max(1.0, abs(root))) {
+            double offAxis, onAxis;
+            cplx projected(root.real(), 0.0);
+            newtonCorrection(a, root, &offAxis);
+            newtonCorrection(a, projected, &onAxis);
+            if (onAxis <= max(offAxis, hornerBound(a, projected))) root = projected;
+        }
+        for (int step = 0; step < 5; ++step) {
+            double before, after;
+            cplx correction = newtonCorrection(a, root, &before);
+            if (before <= hornerBound(a, root) || !isfinite(abs(correction))) break;
+            cplx candidate = root - correction;
+            newtonCorrection(a, candidate, &after);
+            if (!(after < before)) break;
+            root = candidate;
+        }
+    }
+
+    roots.insert(roots.end(), z.begin(), z.end());
+    sort(roots.begin(), roots.end(), [](const cplx& l, const cplx& r) {
+        return l.real() < r.real() || (l.real() == r.real() && l.imag() < r.imag());
+    });
+    return roots;
+}
+
+vector<double> realPolynomialRoots(const vector<double>& a, double imagTol) {
+    vector<double> real;
+    for (const cplx& root : polynomialRoots(a))
+        if (fabs(root.imag()) <= imagTol * max(1.0, abs(root)))
+            real.push_back(root.real());
+    sort(real.begin(), real.end());
+    return real;
+}
+
+vector<double> polynomialExtrema(const vector<double>& a, double imagTol) {
+    vector<double> d = polynomialDerivative(a);
+    bool constant = all_of(d.begin(), d.end(), [](double c) { return c == 0; });
+    if (constant) return vector<double>();
+    return realPolynomialRoots(d, imagTol);
+}
+
+vector<double> polynomialDerivative(const vector<double>& a) {
+    if (a.size() <= 1) return vector<double>(1, 0.0);
+    vector<double> d(a.size() - 1);
+    for (size_t k = 1; k < a.size(); ++k) d[k - 1] = k * a[k];
+    return d;
+}
@@ -0,0 +1,455 @@
+#include "ResultCache.h"
+#include "ExpressionCache.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+
+uint64_t rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+// MurmurHash3 finalizer: every input bit reaches every output bit
+uint64_t fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+uint64_t bitsOf(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+// File layout: a header, then records of a RecordHeader and `count` doubles
+struct FileHeader {
+    char magic[8];
+    uint32_t format;
+    uint32_t version;
+    char reserved[48];
+};
+const char kMagic[8] = {'N', 'U', 'M', 'R', 'E', 'S', 'L', 'T'};
+const uint32_t kFormat = 1;
+
+struct RecordHeader {
+    uint64_t high, low;
+    uint64_t stamp;     // last use; rewritten in place on every hit
+    uint32_t count;
+    uint32_t check;     // over key, count and values, not the stamp
+};
+static_assert(sizeof(FileHeader) == 64 && sizeof(RecordHeader) == 32, "Unexpected padding in the file layout");
+
+const size_t kMinCapacity = 4096;
+
+uint32_t checksum(uint64_t high, uint64_t low, uint32_t count, const unsigned char* values) {
+    uint64_t h = fmix(high ^ rotl(low, 32) ^ count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t bits;
+        memcpy(&bits, values + 8 * size_t(i), sizeof bits);
+        h = rotl(h ^ (bits * kPrime2), 31) * kPrime1;
+    }
+    return uint32_t(fmix(h));
+}
+
+string headerBytes() {
+    FileHeader header = {};
+    memcpy(header.magic, kMagic, sizeof kMagic);
+    header.format = kFormat;
+    header.version = kResultCacheVersion;
+    return string(reinterpret_cast<const char*>(&header), sizeof header);
+}
+
+}
+
+ResultKey::ResultKey(const char* method)
+    : h1(0x243F6A8885A308D3ULL), h2(0x13198A2E03707344ULL), length(0) {
+    mix(kResultCacheVersion);
+    add(string(method));
+}
+
+void ResultKey::mix(uint64_t word) {
+    h1 = rotl(h1 ^ (word * kPrime2), 31) * kPrime1;
+    h2 = rotl(h2 ^ (word * kPrime1), 27) * kPrime2 + 0x52DCE729;
+    ++length;
+}
+
+ResultKey& ResultKey::add(double value) {
+    mix(bitsOf(value));
+    return *this;
+}
+
+// Long arrays go through four independent xxHash64-style lanes, so the
+// multiplies overlap, and the lanes are then mixed into the key
+ResultKey& ResultKey::add(const double* values, size_t count) {
+    mix(count);
+    uint64_t lane[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        for (int k = 0; k < 4; ++k) lane[k] = rotl(lane[k] + bitsOf(values[i + k]) * kPrime2, 31) * kPrime1;
+    for (int k = 0; k < 4; ++k) mix(lane[k]);
+    for (; i < count; ++i) mix(bitsOf(values[i]));
+    return *this;
+}
+
+ResultKey& ResultKey::add(const string& text) {
+    mix(text.size());
+    for (size_t i = 0; i < text.size(); i += 8) {
+        uint64_t word = 0;
+        memcpy(&word, text.data() + i, min<size_t>(8, text.size() - i));
+        mix(word);
+    }
+    return *this;
+}
+
+ResultKey& ResultKey::addExpression(const string& expression) {
+    return add(ExpressionCache::normalize(expression));
+}
+
+uint64_t ResultKey::high() const { return fmix(h1 + h2 + length); }
+uint64_t ResultKey::low() const { return fmix(h2 ^ rotl(h1, 17)); }
+
+// ---- process-wide instance ----
+
+namespace {
+
+struct GlobalCache {
+    mutex lock;
+    shared_ptr<ResultCache> cache;
+    bool loaded = false;
+
+    // At exit: how well the cache served this process
+    ~GlobalCache() {
+        if (!cache) return;
+        const char* summary = getenv("NUMERICAL_RESULT_CACHE_SUMMARY");
+        if (summary && string(summary) == "0") return;
+        ResultCacheStats s = cache->stats();
+        if (s.hits + s.misses == 0) return;
+        cerr << "result cache " << cache->path() << ": " << s.hits << " hits, " << s.misses << " misses ("
+             << int(100 * s.hitRate() + 0.5) << "% hit rate), " << s.stores << " stored, " << s.evictions
+             << " evicted, " << s.entries << " entries in " << s.bytes << " bytes\n";
+    }
+};
+
+GlobalCache& globalCache() {
+    static GlobalCache instance;
+    return instance;
+}
+
+}
+
+shared_ptr<ResultCache> ResultCache::global() {
+    GlobalCache& g = globalCache();
+    lock_guard<mutex> guard(g.lock);
+    if (!g.loaded) {
+        g.loaded = true;
+        const char* path = getenv("NUMERICAL_RESULT_CACHE");
+        if (path && *path) {
+            try {
+                g.cache = make_shared<ResultCache>(path);
+            } catch (const exception& e) {
+                cerr << "Result cache disabled: " << e.what() << "\n";
+            }
+        }
+    }
+    return g.cache;
+}
+
+shared_ptr<ResultCache> ResultCache::globalForExpressions() {
+    if (EquationParser::functionGeneration() != 0) return nullptr;
+    return global();
+}
+
+void ResultCache::setGlobal(shared_ptr<ResultCache> cache) {
+    GlobalCache& g = globalCache();
+    lock_guard<mutex> guard(g.lock);
+    g.loaded = true;
+    g.cache = move(cache);
+}
+
+ResultCacheStats ResultCache::stats() const {
+    lock_guard<mutex> guard(access);
+    ResultCacheStats s;
+    s.hits = hits;
+    s.misses = misses;
+    s.stores = stores;
+    s.evictions = evictions;
+    s.entries = index.size();
+    s.bytes = scanned;
+    s.capacity = limit;
+    return s;
+}
+
+#ifdef _WIN32
+
+ResultCache::ResultCache(const string& path, size_t capacity)
+    : file(path), limit(capacity), fd(-1), inode(0), mapping(nullptr), mappedLength(0), scanned(0), clock(0),
+      hits(0), misses(0), stores(0), evictions(0) {
+    throw runtime_error("The result cache is not supported on this platform");
+}
+
+ResultCache::~ResultCache() {}
+bool ResultCache::lookup(const ResultKey&, vector<double>&) { return false; }
+void ResultCache::store(const ResultKey&, const vector<double>&) {}
+void ResultCache::clear() {}
+
+#else
+
+namespace {
+
+// Writes header + records to a temporary file and renames it over `path`,
+// so other processes see either the old file or the whole new one
+void replaceFile(const string& path, const string& records) {
+    string temporary = path + ".tmp." + to_string(getpid());
+    int out = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) throw runtime_error("Cannot write result cache: " + temporary);
+    string data = headerBytes() + records;
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(out, data.data() + written, data.size() - written);
+        if (n <= 0) break;
+        written += size_t(n);
+    }
+    ::close(out);
+    if (written != data.size() || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        throw runtime_error("Cannot write result cache: " + path);
+    }
+}
+
+}
+
+ResultCache::ResultCache(const string& path, size_t capacity)
+    : file(path), limit(capacity), fd(-1), inode(0), mapping(nullptr), mappedLength(0), scanned(0), clock(0),
+      hits(0), misses(0), stores(0), evictions(0) {
+    if (capacity < kMinCapacity) throw invalid_argument("Result cache capacity must be at least 4096 bytes");
+    open();
+}
+
+ResultCache::~ResultCache() { close(); }
+
+void ResultCache::open() {
+    fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) throw runtime_error("Cannot open result cache: " + file);
+
+    // a new file gets its header under the lock, so two processes creating
+    // it at once write one header between them
+    struct stat info;
+    flock(fd, LOCK_EX);
+    bool ok = fstat(fd, &info) == 0;
+    if (ok && info.st_size == 0) {
+        string header = headerBytes();
+        ok = write(fd, header.data(), header.size()) == ssize_t(header.size()) && fstat(fd, &info) == 0;
+    }
+    flock(fd, LOCK_UN);
+    if (!ok) {
+        close();
+        throw runtime_error("Cannot initialize result cache: " + file);
+    }
+    inode = uint64_t(info.st_ino);
+
+    void* mapped = mmap(nullptr, limit, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        throw runtime_error("Cannot map result cache: " + file);
+    }
+    mapping = static_cast<unsigned char*>(mapped);
+    mappedLength = limit;
+
+    // another layout or an older solver version: start over
+    FileHeader header;
+    bool current = size_t(info.st_size) >= sizeof header;
+    if (current) {
+        memcpy(&header, mapping, sizeof header);
+        current = memcmp(header.magic, kMagic, sizeof kMagic) == 0 && header.format == kFormat &&
+                  header.version == kResultCacheVersion;
+    }
+    if (!current) {
+        close();
+        replaceFile(file, "");
+        open();
+        return;
+    }
+
+    scanned = sizeof(FileHeader);
+    scan();
+}
+
+void ResultCache::close() {
+    if (mapping) munmap(mapping, mappedLength);
+    if (fd >= 0) ::close(fd);
+    mapping = nullptr;
+    fd = -1;
+    mappedLength = scanned = 0;
+    index.clear();
+}
+
+// Indexes the records appended since the last scan, by any process; stops at
+// a record that is not complete yet and picks it up next time
+void ResultCache::scan() {
+    struct stat info;
+    if (fstat(fd, &info) != 0) return;
+    size_t end = min(size_t(info.st_size), mappedLength);
+    while (scanned + sizeof(RecordHeader) <= end) {
+        RecordHeader record;
+        memcpy(&record, mapping + scanned, sizeof record);
+        size_t available = (end - scanned - sizeof record) / sizeof(double);
+        if (record.count > available) break;
+        const unsigned char* values = mapping + scanned + sizeof record;
+        if (checksum(record.high, record.low, record.count, values) != record.check) break;
+        index[Key{record.high, record.low}] = scanned;
+        clock = max(clock, record.stamp);
+        scanned += sizeof record + sizeof(double) * record.count;
+    }
+}
+
+// After another process compacted the file, follow it to the new one
+bool ResultCache::reopenIfReplaced() {
+    struct stat info;
+    if (stat(file.c_str(), &info) == 0 && uint64_t(info.st_ino) == inode) return false;
+    close();
+    open();
+    return true;
+}
+
+bool ResultCache::lookup(const ResultKey& key, vector<double>& values) {
+    Key k{key.high(), key.low()};
+    lock_guard<mutex> guard(access);
+    auto it = index.find(k);
+    if (it == index.end()) {
+        reopenIfReplaced();
+        scan();
+        it = index.find(k);
+        if (it == index.end()) {
+            ++misses;
+            return false;
+        }
+    }
+
+    unsigned char* at = mapping + it->second;
+    RecordHeader record;
+    memcpy(&record, at, sizeof record);
+    values.resize(record.count);
+    memcpy(values.data(), at + sizeof record, sizeof(double) * record.count);
+    uint64_t stamp = ++clock;
+    memcpy(at + offsetof(RecordHeader, stamp), &stamp, sizeof stamp);
+    ++hits;
+    return true;
+}
+
+// Appending is serialized across processes by an exclusive lock on the
+// file; readers never take it
+void ResultCache::lockFile() {
+    while (true) {
+        flock(fd, LOCK_EX);
+        if (!reopenIfReplaced()) return;   // compacted while we waited: lock the new file
+    }
+}
+
+void ResultCache::store(const ResultKey& key, const vector<double>& values) {
+    Key k{key.high(), key.low()};
+    size_t bytes = sizeof(RecordHeader) + sizeof(double) * values.size();
+    if (bytes > limit / 4) return;   // not worth a quarter of the cache
+
+    lock_guard<mutex> guard(access);
+    lockFile();
+    scan();
+    if (index.count(k)) {   // another thread or process was first
+        flock(fd, LOCK_UN);
+        return;
+    }
+
+    // with the lock held no write is in progress, so bytes past the last
+    // whole record are left over from a crash and compaction drops them
+    struct stat info;
+    bool torn = fstat(fd, &info) == 0 && size_t(info.st_size) != scanned;
+    if (torn || scanned + bytes > limit) {
+        compact(bytes);
+        lockFile();
+        scan();
+        if (scanned + bytes > limit) {
+            flock(fd, LOCK_UN);
+            return;
+        }
+    }
+
+    RecordHeader record = {};
+    record.high = k.high;
+    record.low = k.low;
+    record.stamp = ++clock;
+    record.count = uint32_t(values.size());
+    record.check = checksum(k.high, k.low, record.count, reinterpret_cast<const unsigned char*>(values.data()));
+    string data(reinterpret_cast<const char*>(&record), sizeof record);
+    data.append(reinterpret_cast<const char*>(values.data()), sizeof(double) * values.size());
+
+    // one write on an O_APPEND descriptor: the record lands whole at the end
+    if (write(fd, data.data(), data.size()) == ssize_t(data.size())) ++stores;
+    scan();
+    flock(fd, LOCK_UN);
+}
+
+// Keeps the most recently used records filling half the capacity (less the
+// record about to be added) in a fresh file. Called with the file locked;
+// the lock goes with the old file.
+void ResultCache::compact(size_t incoming) {
+    vector<pair<uint64_t, size_t>> live;   // stamp, offset
+    live.reserve(index.size());
+    for (const auto& entry : index) {
+        RecordHeader record;
+        memcpy(&record, mapping + entry.second, sizeof record);
+        live.emplace_back(record.stamp, entry.second);
+    }
+    sort(live.begin(), live.end(), [](const pair<uint64_t, size_t>& l, const pair<uint64_t, size_t>& r) {
+        return l.first > r.first;
+    });
+
+    size_t budget = limit / 2 > incoming + sizeof(FileHeader) ? limit / 2 - incoming - sizeof(FileHeader) : 0;
+    string records;
+    size_t kept = 0;
+    for (const auto& entry : live) {
+        RecordHeader record;
+        memcpy(&record, mapping + entry.second, sizeof record);
+        size_t size = sizeof record + sizeof(double) * record.count;
+        if (records.size() + size > budget) break;
+        records.append(reinterpret_cast<const char*>(mapping + entry.second), size);
+        ++kept;
+    }
+
+    try {
+        replaceFile(file, records);
+    } catch (const exception&) {
+        return;   // keep appending to the old file
+    }
+    evictions += (long long)(live.size() - kept);
+    close();   // releases the lock with the descriptor
+    open();
+}
+
+void ResultCache::clear() {
+    lock_guard<mutex> guard(access);
+    lockFile();
+    replaceFile(file, "");
+    close();
+    open();
+    hits = misses = stores = evictions = 0;
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "RootScanner.h"
+#include "BracketedSolvers.h"
+#include "ExpressionCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+struct Bracket {
+    double a, b;
+};
+
+double derivativeAt(const EquationParser& parser, double x) {
+    double d;
+    parser.evaluateDerivative(x, d);
+    return d;
+}
+
+}
+
+vector<double> findAllRoots(const EquationParser& parser, double a, double b,
+                            const RootScanOptions& options) {
+    if (!(b > a))
+        throw invalid_argument("Upper bound must be greater than lower bound");
+    if (options.samples < 1)
+        throw invalid_argument("Need at least one sample cell");
+
+    // 1. sample f and f' on the grid in one batched pass
+    int n = options.samples;
+    vector<double> xs(n + 1), fs(n + 1), ds(n + 1);
+    for (int i = 0; i <= n; ++i) xs[i] = a + (b - a) * i / n;
+    xs[n] = b;
+    parser.evaluateDerivativeBatch(xs.data(), fs.data(), ds.data(), xs.size());
+
+    double scale = 1.0;
+    for (double f : fs)
+        if (isfinite(f)) scale = max(scale, fabs(f));
+    double tangentTol = options.tangentTol * scale;
+
+    // 2. classify every cell
+    vector<double> roots;
+    vector<Bracket> brackets;
+    RootOptions extremumOptions;
+    extremumOptions.xtol = options.xtol;
+
+    for (int i = 0; i <= n; ++i)
+        if (fs[i] == 0) roots.push_back(xs[i]);
+
+    for (int i = 0; i < n; ++i) {
+        double fa = fs[i], fb = fs[i + 1];
+        if (!isfinite(fa) || !isfinite(fb) || fa == 0 || fb == 0) continue;
+
+        if ((fa > 0) != (fb > 0)) {
+            brackets.push_back({xs[i], xs[i + 1]});
+            continue;
+        }
+
+        // no sign change: look for a near-tangent extremum inside the cell
+        if (!isfinite(ds[i]) || !isfinite(ds[i + 1]) || (ds[i] > 0) == (ds[i + 1] > 0)) continue;
+        if (ds[i] == 0 || ds[i + 1] == 0) continue;
+
+        RootResult extremum;
+        try {
+            extremum = brentRoot([&](double x) { return derivativeAt(parser, x); },
+                                 xs[i], xs[i + 1], extremumOptions);
+        } catch (const exception&) {
+            continue;
+        }
+        double c = extremum.root, fc;
+        try {
+            fc = parser.evaluate(c);
+        } catch (const exception&) {
+            continue;
+        }
+
+        if (fabs(fc) <= tangentTol) roots.push_back(c);             // touching root
+        else if ((fc > 0) != (fa > 0)) {                            // dips across zero twice
+            brackets.push_back({xs[i], c});
+            brackets.push_back({c, xs[i + 1]});
+        }
+    }
+
+    // 3. solve the brackets in parallel. A bracket is dropped (NaN) when f is
+    // undefined somewhere inside it, or when |f| at the converged point is
+    // larger than at both bracket ends: the sign change was a pole, not a root.
+    vector<double> solved(brackets.size());
+    int threads = options.threads > 0 ? options.threads : int(thread::hardware_concurrency());
+    threads = max(1, min<int>(threads, int(brackets.size())));
+
+    RootOptions solveOptions;
+    solveOptions.xtol = options.xtol;
+    atomic<size_t> next(0);
+    exception_ptr failure;
+    mutex failureLock;
+    auto worker = [&] {
+        try {
+            for (size_t k = next++; k < brackets.size(); k = next++) {
+                auto f = [&](double x) { return parser.evaluate(x); };
+                solved[k] = NAN;
+                RootResult result;
+                try {
+                    result = brentRoot(f, brackets[k].a, brackets[k].b, solveOptions);
+                } catch (const exception&) {
+                    continue;
+                }
+                double ends = max(fabs(f(brackets[k].a)), fabs(f(brackets[k].b)));
+                if (fabs(result.value) <= ends) solved[k] = result.root;
+            }
+        } catch (...) {
+            lock_guard<mutex> guard(failureLock);
+            if (!failure) failure = current_exception();
+            next = brackets.size();
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (failure) rethrow_exception(failure);
+
+    // 4. sorted, distinct
+    for (double r : solved)
+        if (!isnan(r)) roots.push_back(r);
+    sort(roots.begin(), roots.end());
+    double mergeTol = max(options.xtol, 1e-14 * max(fabs(a), fabs(b)));
+    vector<double> distinct;
+    for (double r : roots)
+        if (distinct.empty() || r - distinct.back() > mergeTol) distinct.push_back(r);
+    return distinct;
+}
+
+vector<double> findAllRoots(const string& expr, double a, double b, const RootScanOptions& options) {
+    return findAllRoots(*compileExpression(expr), a, b, options);
+}
@@ -0,0 +1,160 @@
+#include "SavitzkyGolay.h"
+#include "LeastSquares.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// Outputs per block of the interior pass; the block of outputs stays in L1
+// while every tap is added into it
+const std::size_t kBlock = 2048;
+// Below this many samples per thread the interior runs on one thread
+const std::size_t kMinPerThread = 1 << 16;
+
+// o[i] += sum of c[p] (s[i + k + p] + Sign s[i - k - p]) over p < Pairs;
+// the first pass of a block writes o[i] = centre s[i] + ... instead
+template <int Sign, int Pairs, bool First>
+void addTaps(double* o, const double* s, std::size_t len, const double* c, int k, double centre) {
+    for (std::size_t i = 0; i < len; ++i) {
+        double sum = First ? centre * s[i] : o[i];
+        for (int p = 0; p < Pairs; ++p) sum += c[p] * (s[i + k + p] + Sign * s[i - k - p]);
+        o[i] = sum;
+    }
+}
+
+template <int Sign, bool First>
+void addTapGroup(double* o, const double* s, std::size_t len, const double* c, int k, int pairs, double centre) {
+    switch (pairs) {
+    case 4: addTaps<Sign, 4, First>(o, s, len, c, k, centre); break;
+    case 3: addTaps<Sign, 3, First>(o, s, len, c, k, centre); break;
+    case 2: addTaps<Sign, 2, First>(o, s, len, c, k, centre); break;
+    case 1: addTaps<Sign, 1, First>(o, s, len, c, k, centre); break;
+    default: addTaps<Sign, 0, First>(o, s, len, c, k, centre); break;
+    }
+}
+
+// Every tap pair of the centre weights c[m..2m] into o, four pairs per pass
+// over the block, pairing the taps at +k and -k (one multiply per pair)
+template <int Sign>
+void filterBlock(double* o, const double* s, std::size_t len, const double* c, int m) {
+    addTapGroup<Sign, true>(o, s, len, c + 1, 1, std::min(m, 4), c[0]);
+    for (int k = 5; k <= m; k += 4)
+        addTapGroup<Sign, false>(o, s, len, c + k, k, std::min(m - k + 1, 4), 0.0);
+}
+}
+
+SavitzkyGolayFilter::SavitzkyGolayFilter(int halfWindow, int degree, int derivative, double spacing)
+ : m(halfWindow), n(degree), d(derivative)
+{
+    if (halfWindow < 0)
+        throw std::invalid_argument("Half window must be non-negative");
+    if (degree < 0 || degree > 2 * halfWindow)
+        throw std::invalid_argument("Degree must be between 0 and the window size - 1");
+    if (derivative < 0 || derivative > degree)
+        throw std::invalid_argument("Derivative order must be between 0 and the degree");
+    if (!(spacing > 0))
+        throw std::invalid_argument("Sample spacing must be positive");
+
+    int w = 2 * m + 1, cols = n + 1;
+    double halfWidth = std::max(m, 1);   // window positions mapped onto t in [-1, 1]
+
+    // Column j of the pseudo-inverse is the fit of the unit sample e_j: the
+    // coefficients of any window are P y
+    DenseMatrix Vt(cols, w);
+    for (int j = 0; j < w; ++j) {
+        double t = (j - m) / halfWidth, power = 1;
+        for (int k = 0; k < cols; ++k, power *= t) Vt(k, j) = power;
+    }
+    std::vector<std::vector<double>> P(cols, std::vector<double>(w));
+    std::vector<double> unit(w);
+    for (int j = 0; j < w; ++j) {
+        QRLeastSquares qr(cols);
+        DenseMatrix block = Vt;
+        std::fill(unit.begin(), unit.end(), 0.0);
+        unit[j] = 1.0;
+        qr.addRows(block, unit.data(), w);
+        std::vector<double> c = qr.solve();
+        for (int k = 0; k < cols; ++k) P[k][j] = c[k];
+    }
+
+    // d-th derivative of t^k at each position, with dt/dx = 1 / (halfWidth spacing)
+    double chain = std::pow(halfWidth * spacing, -d);
+    table.assign(w, std::vector<double>(w, 0.0));
+    for (int r = 0; r < w; ++r) {
+        double t = (r - m) / halfWidth;
+        for (int k = d; k < cols; ++k) {
+            double factor = chain;
+            for (int i = 0; i < d; ++i) factor *= k - i;
+            factor *= std::pow(t, k - d);
+            for (int j = 0; j < w; ++j) table[r][j] += factor * P[k][j];
+        }
+    }
+
+    // the centre weights are symmetric for even derivatives and
+    // antisymmetric for odd ones; make them exactly so
+    std::vector<double>& c = table[m];
+    double sign = (d % 2 == 0) ? 1.0 : -1.0;
+    for (int k = 1; k <= m; ++k) {
+        double v = 0.5 * (c[m + k] + sign * c[m - k]);
+        c[m + k] = v;
+        c[m - k] = sign * v;
+    }
+    if (sign < 0) c[m] = 0.0;
+}
+
+void SavitzkyGolayFilter::applyInterior(const double* signal, double* out,
+                                        std::size_t begin, std::size_t end) const {
+    const std::vector<double>& c = table[m];
+    bool symmetric = d % 2 == 0;
+
+    for (std::size_t i0 = begin; i0 < end; i0 += kBlock) {
+        std::size_t len = std::min(kBlock, end - i0);
+        if (symmetric) filterBlock<1>(out + i0, signal + i0, len, &c[m], m);
+        else filterBlock<-1>(out + i0, signal + i0, len, &c[m], m);
+    }
+}
+
+void SavitzkyGolayFilter::apply(const double* signal, double* out, std::size_t count, int threads) const {
+    std::size_t w = std::size_t(window());
+    if (count < w)
+        throw std::invalid_argument("Signal is shorter than the filter window");
+
+    // edges: the first and last whole window, evaluated off centre
+    const double* last = signal + (count - w);
+    for (int r = 0; r < m; ++r) {
+        double head = 0, tail = 0;
+        const std::vector<double>& front = table[r];
+        const std::vector<double>& back = table[m + 1 + r];
+        for (std::size_t j = 0; j < w; ++j) {
+            head += front[j] * signal[j];
+            tail += back[j] * last[j];
+        }
+        out[r] = head;
+        out[count - m + r] = tail;
+    }
+
+    std::size_t begin = std::size_t(m), end = count - std::size_t(m);
+    if (threads <= 0) threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::min<std::size_t>(std::size_t(threads), std::max<std::size_t>(1, (end - begin) / kMinPerThread)));
+    if (threads <= 1) {
+        applyInterior(signal, out, begin, end);
+        return;
+    }
+
+    // each thread takes a run of whole blocks
+    std::size_t chunk = ((end - begin) / threads + kBlock - 1) / kBlock * kBlock;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        std::size_t from = std::min(end, begin + t * chunk);
+        std::size_t to = (t == threads - 1) ? end : std::min(end, from + chunk);
+        workers.emplace_back([=] { applyInterior(signal, out, from, to); });
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+std::vector<double> SavitzkyGolayFilter::apply(ColumnView signal, int threads) const {
+    std::vector<double> out(signal.size());
+    apply(signal.data(), out.data(), signal.size(), threads);
+    return out;
+}
@@ -0,0 +1,472 @@
+#include "SolverServer.h"
+#include "BracketedSolvers.h"
+#include "DividedDifferenceInterpolator.h"
+#include "DoubleExponential.h"
+#include "EulerMethods.h"
+#include "ExpressionCache.h"
+#include "Instrumentation.h"
+#include "LagrangeInterpolator.h"
+#include "PolynomialFitter.h"
+#include "ResultCache.h"
+
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+struct Field {
+    string text;
+    bool quoted;
+};
+
+// Blank-separated fields; "..." keeps blanks inside one field
+vector<Field> splitFields(const string& line) {
+    vector<Field> fields;
+    size_t i = 0;
+    while (true) {
+        while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+        if (i == line.size()) return fields;
+        Field field = {string(), line[i] == '"'};
+        if (field.quoted) {
+            size_t close = line.find('"', i + 1);
+            if (close == string::npos) throw invalid_argument("Unterminated quote");
+            field.text = line.substr(i + 1, close - i - 1);
+            i = close + 1;
+        } else {
+            while (i < line.size() && !isspace((unsigned char)line[i])) field.text += line[i++];
+        }
+        fields.push_back(field);
+    }
+}
+
+double toNumber(const string& text) {
+    char* end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0') throw invalid_argument("Not a number: " + text);
+    return value;
+}
+
+vector<double> toList(const string& text) {
+    vector<double> values;
+    size_t start = 0;
+    while (true) {
+        size_t comma = text.find(',', start);
+        values.push_back(toNumber(text.substr(start, comma == string::npos ? string::npos : comma - start)));
+        if (comma == string::npos) return values;
+        start = comma + 1;
+    }
+}
+
+string number(double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof buffer, "%.17g", value);
+    return buffer;
+}
+
+// Setting names; any other field is positional, so an expression such as
+// x==1 is never mistaken for one
+const char* const kSettings[] = {"method", "xtol", "tol"};
+
+bool isSetting(const string& key) {
+    for (const char* name : kSettings)
+        if (key == name) return true;
+    return false;
+}
+
+// Positional fields and key=value settings of one request
+struct Request {
+    vector<string> args;
+    map<string, string> settings;
+
+    explicit Request(const vector<Field>& fields) {
+        for (size_t i = 1; i < fields.size(); ++i) {
+            const string& text = fields[i].text;
+            size_t eq = text.find('=');
+            if (!fields[i].quoted && eq != string::npos && isSetting(text.substr(0, eq)))
+                settings[text.substr(0, eq)] = text.substr(eq + 1);
+            else
+                args.push_back(text);
+        }
+    }
+
+    void expect(size_t count, const char* usage) const {
+        if (args.size() != count) throw invalid_argument(string("Usage: ") + usage);
+    }
+
+    string setting(const string& key, const string& fallback) const {
+        auto it = settings.find(key);
+        return it == settings.end() ? fallback : it->second;
+    }
+};
+
+string solveRoot(const Request& r) {
+    r.expect(3, "root <expr> <a> <b> [method=brent|itp|bisection] [xtol=...]");
+    RootOptions options;
+    options.xtol = toNumber(r.setting("xtol", "1e-12"));
+    string method = r.setting("method", "brent");
+    const string& f = r.args[0];
+    double a = toNumber(r.args[1]), b = toNumber(r.args[2]);
+
+    RootResult result;
+    if (method == "brent") result = brentRoot(f, a, b, options);
+    else if (method == "itp") result = itpRoot(f, a, b, options);
+    else if (method == "bisection") result = bisectionRoot(f, a, b, options);
+    else throw invalid_argument("Unknown root method: " + method);
+    return "ok " + number(result.root) + " " + number(result.value) + " " + to_string(result.iterations) + " " +
+           (result.converged ? "1" : "0");
+}
+
+string integrate(const Request& r) {
+    r.expect(3, "integrate <expr> <a> <b> [tol=...]");
+    QuadratureOptions options;
+    options.tolerance = toNumber(r.setting("tol", "1e-8"));
+    QuadratureResult result = integrateDoubleExponential(*compileExpression(r.args[0]), toNumber(r.args[1]),
+                                                         toNumber(r.args[2]), options);
+    return "ok " + number(result.value) + " " + number(result.errorEstimate) + " " + to_string(result.evaluations);
+}
+
+string ode(const Request& r) {
+    r.expect(5, "ode <f(x,y)> <x0> <y0> <h> <steps> [method=euler|modified]");
+    string method = r.setting("method", "euler");
+    BasicEuler basic;
+    ModifiedEuler modified;
+    const EulerMethod* solver = nullptr;
+    if (method == "euler") solver = &basic;
+    else if (method == "modified") solver = &modified;
+    else throw invalid_argument("Unknown ODE method: " + method);
+    double steps = toNumber(r.args[4]);
+    if (steps < 0 || steps != double(int(steps))) throw invalid_argument("Steps must be a whole number");
+    return "ok " + number(solver->integrate(r.args[0], toNumber(r.args[1]), toNumber(r.args[2]),
+                                            toNumber(r.args[3]), int(steps)));
+}
+
+string fit(const Request& r) {
+    r.expect(3, "fit <degree> <x1,x2,...> <y1,y2,...>");
+    PolynomialFitter fitter(toList(r.args[1]), toList(r.args[2]), int(toNumber(r.args[0])));
+    fitter.fit();
+    string reply = "ok";
+    for (double c : fitter.coefficients()) reply += " " + number(c);
+    return reply;
+}
+
+string interpolate(const Request& r) {
+    r.expect(3, "interpolate <x1,...> <y1,...> <at> [method=lagrange|newton]");
+    vector<double> x = toList(r.args[0]), y = toList(r.args[1]);
+    double at = toNumber(r.args[2]);
+    string method = r.setting("method", "lagrange");
+    if (method == "lagrange") {
+        if (x.size() != y.size()) throw invalid_argument("x and y must have the same number of points");
+        return "ok " + number(LagrangeInterpolator(x, y).interpolateY(at));
+    }
+    if (method == "newton") return "ok " + number(divide(x, y).evaluate(at));
+    throw invalid_argument("Unknown interpolation method: " + method);
+}
+
+// Replies are one line each, so no message may contain a newline
+string oneLine(string text) {
+    for (char& c : text)
+        if (c == '\n' || c == '\r') c = ' ';
+    return text;
+}
+
+}
+
+SolverServer::SolverServer() : requestCount(0), errorCount(0), stopping(false), listener(-1), wakeup(-1) {}
+
+string SolverServer::handle(const string& request) {
+    NUMERICAL_TIMED("server.request");
+    ++requestCount;
+    try {
+        return dispatch(request);
+    } catch (const exception& e) {
+        ++errorCount;
+        return "err " + oneLine(e.what());
+    }
+}
+
+string SolverServer::dispatch(const string& line) {
+    vector<Field> fields = splitFields(line);
+    if (fields.empty()) throw invalid_argument("Empty request");
+    Request request(fields);
+    const string& command = fields[0].text;
+
+    if (command == "root") return solveRoot(request);
+    if (command == "integrate") return integrate(request);
+    if (command == "ode") return ode(request);
+    if (command == "fit") return fit(request);
+    if (command == "interpolate") return interpolate(request);
+    if (command == "ping") return "ok pong";
+    if (command == "stats") {
+        ExpressionCacheStats cache = ExpressionCache::global().stats();
+        string reply = "ok requests=" + to_string(requestCount) + " errors=" + to_string(errorCount) +
+                       " cache_hits=" + to_string(cache.hits) + " cache_misses=" + to_string(cache.misses) +
+                       " cache_size=" + to_string(cache.size);
+        if (shared_ptr<ResultCache> results = ResultCache::global()) {
+            ResultCacheStats memo = results->stats();
+            reply += " result_hits=" + to_string(memo.hits) + " result_misses=" + to_string(memo.misses) +
+                     " result_entries=" + to_string(memo.entries);
+        }
+        return reply;
+    }
+    throw invalid_argument("Unknown request: " + command);
+}
+
+void SolverServer::serveStream(istream& in, ostream& out) {
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        out << handle(line) << '\n';
+        if (in.rdbuf()->in_avail() <= 0) out.flush();
+    }
+    out.flush();
+}
+
+#ifdef _WIN32
+
+void SolverServer::serveUnixSocket(const string&, int) {
+    throw runtime_error("Unix domain sockets are not supported on this platform; use the stdin/stdout mode");
+}
+
+void SolverServer::stop() { stopping = true; }
+
+#else
+
+namespace {
+
+// Longest request line: a client that sends more without a newline gets an
+// error reply and is disconnected, instead of growing its buffer for ever
+const size_t kMaxRequestLine = size_t(1) << 20;
+
+// A client socket as the polling thread sees it
+struct Connection {
+    string input;        // bytes after the last complete line
+    bool busy = false;   // a job is out for it, so it is not polled
+};
+
+// Complete lines from one connection, answered by one worker in order
+struct Job {
+    int client = -1;
+    vector<string> lines;
+    bool overflow = false;   // then reply with an error and disconnect
+};
+
+// One byte down the wake-up pipe; a full pipe already wakes the poll
+void wake(int fd) {
+    char byte = 0;
+    if (write(fd, &byte, 1) < 0) {}
+}
+
+bool writeAll(int fd, const string& data) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;   // a client that went away must not kill the server
+#else
+    const int flags = 0;
+#endif
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, flags);
+        if (n <= 0) return false;
+        sent += size_t(n);
+    }
+    return true;
+}
+
+}
+
+void SolverServer::serveUnixSocket(const string& path, int threads) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof address.sun_path) throw invalid_argument("Socket path too long: " + path);
+    path.copy(address.sun_path, path.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw runtime_error("Cannot create a socket");
+    unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        throw runtime_error("Cannot listen on " + path);
+    }
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        close(fd);
+        throw runtime_error("Cannot create a pipe");
+    }
+    for (int end : pipeFds) fcntl(end, F_SETFL, fcntl(end, F_GETFL) | O_NONBLOCK);
+
+    listener = fd;
+    wakeup = pipeFds[1];
+    mutex queueLock;
+    condition_variable ready;
+    queue<Job> jobs;
+    vector<pair<int, bool>> finished;   // connections handed back, and whether they are still usable
+    bool closed = false;
+
+    // a worker answers the lines of one job and hands the connection back;
+    // a connection has at most one job at a time, so its replies stay in order
+    auto worker = [&]() {
+        string output;
+        while (true) {
+            Job job;
+            {
+                unique_lock<mutex> guard(queueLock);
+                ready.wait(guard, [&] { return closed || !jobs.empty(); });
+                if (closed) return;
+                job = move(jobs.front());
+                jobs.pop();
+            }
+
+            output.clear();
+            for (const string& line : job.lines) {
+                output += handle(line);
+                output += '\n';
+            }
+            if (job.overflow) {
+                ++requestCount;
+                ++errorCount;
+                output += "err Request longer than " + to_string(kMaxRequestLine) + " bytes\n";
+            }
+            // one write per job: pipelined requests get their replies in one go
+            bool usable = writeAll(job.client, output) && !job.overflow;
+            {
+                lock_guard<mutex> guard(queueLock);
+                finished.emplace_back(job.client, usable);
+            }
+            wake(pipeFds[1]);
+        }
+    };
+
+    if (threads <= 0) threads = max(1, int(thread::hardware_concurrency()));
+    vector<thread> pool;
+    for (int t = 0; t < threads; ++t) pool.emplace_back(worker);
+
+    // this thread polls the listener and every connection without a job, and
+    // turns what arrives into jobs of complete lines
+    map<int, Connection> clients;
+    vector<pollfd> polled;
+    vector<char> buffer(1 << 16);
+    auto drop = [&](int client) {
+        lock_guard<mutex> guard(connectionLock);
+        connections.erase(client);
+        close(client);
+        clients.erase(client);
+    };
+
+    while (!stopping) {
+        polled.clear();
+        polled.push_back({fd, POLLIN, 0});
+        polled.push_back({pipeFds[0], POLLIN, 0});
+        for (const auto& c : clients)
+            if (!c.second.busy) polled.push_back({c.first, POLLIN, 0});
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (stopping) break;
+
+        if (polled[1].revents) {
+            while (read(pipeFds[0], buffer.data(), buffer.size()) > 0) {}
+            vector<pair<int, bool>> done;
+            {
+                lock_guard<mutex> guard(queueLock);
+                done.swap(finished);
+            }
+            for (const auto& d : done) {
+                if (d.second) clients[d.first].busy = false;
+                else drop(d.first);
+            }
+        }
+
+        if (polled[0].revents) {
+            int client = accept(fd, nullptr, nullptr);
+            if (client >= 0) {
+                lock_guard<mutex> guard(connectionLock);
+                connections.insert(client);
+                clients[client];
+            }
+        }
+
+        for (size_t i = 2; i < polled.size(); ++i) {
+            if (!polled[i].revents) continue;
+            int client = polled[i].fd;
+            ssize_t n = read(client, buffer.data(), buffer.size());
+            if (n <= 0) {
+                drop(client);
+                continue;
+            }
+            Connection& connection = clients[client];
+            string& input = connection.input;
+            input.append(buffer.data(), size_t(n));
+
+            Job job;
+            job.client = client;
+            size_t start = 0, end;
+            while ((end = input.find('\n', start)) != string::npos) {
+                size_t length = end - start;
+                if (length > 0 && input[end - 1] == '\r') --length;
+                job.lines.push_back(input.substr(start, length));
+                start = end + 1;
+            }
+            input.erase(0, start);
+            // no newline in sight: answer what came before, then give up on the connection
+            job.overflow = input.size() > kMaxRequestLine;
+            if (job.overflow) input.clear();
+            if (job.lines.empty() && !job.overflow) continue;
+
+            connection.busy = true;
+            lock_guard<mutex> guard(queueLock);
+            jobs.push(move(job));
+            ready.notify_one();
+        }
+    }
+
+    // wake workers blocked writing to a client, then drop every connection
+    {
+        lock_guard<mutex> guard(connectionLock);
+        for (int client : connections) shutdown(client, SHUT_RDWR);
+    }
+    {
+        lock_guard<mutex> guard(queueLock);
+        closed = true;
+        ready.notify_all();
+    }
+    for (auto& t : pool) t.join();
+    while (!clients.empty()) drop(clients.begin()->first);
+    wakeup = -1;
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+    listener = -1;
+    close(fd);
+    unlink(path.c_str());
+}
+
+void SolverServer::stop() {
+    stopping = true;
+    int w = wakeup;
+    if (w >= 0) wake(w);   // wakes poll()
+    int fd = listener;
+    if (fd >= 0) shutdown(fd, SHUT_RDWR);
+    lock_guard<mutex> guard(connectionLock);
+    for (int client : connections) shutdown(client, SHUT_RDWR);   // wakes a blocked write
+}
+
+#endif
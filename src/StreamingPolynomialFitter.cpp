@@ -0,0 +1,121 @@
+#include "StreamingPolynomialFitter.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// Rows of the Vandermonde matrix handed to the QR solver at a time
+const int kBlockRows = 256;
+}
+
+StreamingPolynomialFitter::StreamingPolynomialFitter(int degree)
+ : n(degree), center(0.0), halfWidth(1.0),
+   qr(degree >= 0 ? degree + 1 : 1)
+{
+    if (degree < 0)
+        throw std::invalid_argument("Degree must be non-negative");
+}
+
+StreamingPolynomialFitter::StreamingPolynomialFitter(int degree, double xMin, double xMax)
+ : StreamingPolynomialFitter(degree)
+{
+    if (!(xMax >= xMin))
+        throw std::invalid_argument("Invalid x domain");
+    center = 0.5 * (xMin + xMax);
+    halfWidth = (xMax > xMin) ? 0.5 * (xMax - xMin) : 1.0;
+}
+
+void StreamingPolynomialFitter::add(const double* x, const double* y,
+                                    std::size_t count, std::size_t stride) {
+    int m = n + 1;
+
+    // transposed Vandermonde block: row k holds t^k for every sample, and the
+    // powers are built incrementally from the previous row
+    DenseMatrix Vt(m, kBlockRows);
+    std::vector<double> rhs(kBlockRows);
+    for (std::size_t start = 0; start < count; start += kBlockRows) {
+        int rows = int(std::min<std::size_t>(kBlockRows, count - start));
+        const double* xs = x + start * stride;
+        const double* ys = y + start * stride;
+
+        double* ones = Vt.row(0);
+        for (int i = 0; i < rows; ++i) {
+            ones[i] = 1.0;
+            rhs[i] = ys[i * stride];
+        }
+        if (n > 0) {
+            double* t = Vt.row(1);
+            for (int i = 0; i < rows; ++i)
+                t[i] = (xs[i * stride] - center) / halfWidth;
+            for (int k = 2; k < m; ++k) {
+                const double* prev = Vt.row(k - 1);
+                double* powers = Vt.row(k);
+                for (int i = 0; i < rows; ++i)
+                    powers[i] = prev[i] * t[i];
+            }
+        }
+        qr.addRows(Vt, rhs.data(), rows);
+    }
+}
+
+void StreamingPolynomialFitter::addParallel(const double* x, const double* y, std::size_t count,
+                                            std::size_t stride, int threads) {
+    if (threads <= 1 || count < std::size_t(threads) * kBlockRows) {
+        add(x, y, count, stride);
+        return;
+    }
+
+    std::vector<StreamingPolynomialFitter> parts(threads, StreamingPolynomialFitter(n));
+    std::vector<std::thread> workers;
+    std::size_t chunk = (count + threads - 1) / threads;
+
+    for (int w = 0; w < threads; ++w) {
+        std::size_t begin = std::min(count, w * chunk);
+        std::size_t end = std::min(count, begin + chunk);
+        parts[w].center = center;
+        parts[w].halfWidth = halfWidth;
+        workers.emplace_back([&, w, begin, end] {
+            parts[w].add(x + begin * stride, y + begin * stride, end - begin, stride);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    for (const auto& part : parts) merge(part);
+}
+
+void StreamingPolynomialFitter::addFile(const std::string& path, int threads) {
+    MappedFile file(path);
+    if (file.size() % (2 * sizeof(double)) != 0)
+        throw std::runtime_error("File size is not a whole number of (x, y) float64 pairs: " + path);
+
+    const double* data = static_cast<const double*>(file.data());
+    addParallel(data, data + 1, file.size() / (2 * sizeof(double)), 2, threads);
+}
+
+void StreamingPolynomialFitter::merge(const StreamingPolynomialFitter& other) {
+    if (other.n != n || other.center != center || other.halfWidth != halfWidth)
+        throw std::invalid_argument("Cannot merge fitters with different degree or domain");
+    qr.merge(other.qr);
+}
+
+std::vector<double> StreamingPolynomialFitter::scaledCoefficients() const {
+    if (qr.rows() <= n)
+        throw std::invalid_argument("Need more points than degree");
+    return qr.solve();
+}
+
+std::vector<double> StreamingPolynomialFitter::coefficients() const {
+    return toMonomial(scaledCoefficients(), center, halfWidth);
+}
+
+double StreamingPolynomialFitter::residualNorm() const {
+    return qr.residualNorm();
+}
+
+double StreamingPolynomialFitter::conditionEstimate() const {
+    return qr.conditionEstimate();
+}
+
+long long StreamingPolynomialFitter::count() const {
+    return qr.rows();
+}
@@ -0,0 +1,133 @@
+#include "SurfaceFitter.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+// center and half-width that map the data range onto [-1, 1]
+void scaling(const std::vector<double>& v, double& center, double& halfWidth) {
+    auto range = std::minmax_element(v.begin(), v.end());
+    center = 0.5 * (*range.first + *range.second);
+    halfWidth = 0.5 * (*range.second - *range.first);
+    if (halfWidth == 0) halfWidth = 1.0;
+}
+
+// coefficients of ((v - center) / halfWidth)^power in powers of v
+std::vector<double> shiftedPower(int power, double center, double halfWidth) {
+    std::vector<double> p(1, 1.0);
+    for (int k = 0; k < power; ++k) {
+        std::vector<double> next(p.size() + 1, 0.0);
+        for (size_t j = 0; j < p.size(); ++j) {
+            next[j + 1] += p[j] / halfWidth;
+            next[j] -= p[j] * center / halfWidth;
+        }
+        p.swap(next);
+    }
+    return p;
+}
+}
+
+SurfaceFitter::SurfaceFitter(const std::vector<double>& xv,
+                             const std::vector<double>& yv,
+                             const std::vector<double>& zv,
+                             int degree)
+ : N(int(xv.size())), n(degree), x(xv), y(yv), z(zv),
+   residual(0.0), condition(0.0)
+{
+    if (yv.size() != xv.size() || zv.size() != xv.size())
+        throw std::invalid_argument("x, y and z must have the same number of points");
+    if (degree < 0)
+        throw std::invalid_argument("Degree must be non-negative");
+
+    for (int t = 0; t <= n; ++t)
+        for (int j = 0; j <= t; ++j)
+            exponents.push_back({t - j, j});
+
+    if (N <= int(exponents.size()))
+        throw std::invalid_argument("Need more points than surface terms");
+
+    scaling(x, cx, sx);
+    scaling(y, cy, sy);
+}
+
+// row k of the result holds term k at every point; powers of tx and ty are
+// tabulated once and multiplied, no pow calls
+DenseMatrix SurfaceFitter::designMatrix() const {
+    DenseMatrix px(n + 1, N), py(n + 1, N);
+    for (int i = 0; i < N; ++i) {
+        px(0, i) = py(0, i) = 1.0;
+        if (n > 0) {
+            px(1, i) = (x[i] - cx) / sx;
+            py(1, i) = (y[i] - cy) / sy;
+        }
+    }
+    for (int k = 2; k <= n; ++k)
+        for (int i = 0; i < N; ++i) {
+            px(k, i) = px(k - 1, i) * px(1, i);
+            py(k, i) = py(k - 1, i) * py(1, i);
+        }
+
+    DenseMatrix Vt(int(exponents.size()), N);
+    for (size_t k = 0; k < exponents.size(); ++k) {
+        const double* a = px.row(exponents[k].first);
+        const double* b = py.row(exponents[k].second);
+        double* dst = Vt.row(int(k));
+        for (int i = 0; i < N; ++i) dst[i] = a[i] * b[i];
+    }
+    return Vt;
+}
+
+void SurfaceFitter::fit() {
+    WeightedLeastSquares solver(designMatrix(), z);
+    store(solver, w.empty() ? solver.solve() : solver.solve(w));
+}
+
+void SurfaceFitter::setWeights(const std::vector<double>& weights) {
+    if (int(weights.size()) != N)
+        throw std::invalid_argument("Need one weight per point");
+    w = weights;
+}
+
+void SurfaceFitter::fitRobust(RobustLoss loss, double tuning, int maxIterations) {
+    WeightedLeastSquares solver(designMatrix(), z);
+    store(solver, solver.solveRobust(loss, tuning, w, maxIterations));
+}
+
+void SurfaceFitter::store(const WeightedLeastSquares& solver, const std::vector<double>& coeffs) {
+    c = coeffs;
+    residual = solver.residualNorm();
+    condition = solver.conditionEstimate();
+    finalW = solver.weights();
+}
+
+double SurfaceFitter::evaluate(double xValue, double yValue) const {
+    if (c.empty()) throw std::logic_error("fit() has not been called");
+    double tx = (xValue - cx) / sx, ty = (yValue - cy) / sy;
+    std::vector<double> px(n + 1, 1.0), py(n + 1, 1.0);
+    for (int k = 1; k <= n; ++k) {
+        px[k] = px[k - 1] * tx;
+        py[k] = py[k - 1] * ty;
+    }
+    double sum = 0;
+    for (size_t k = 0; k < exponents.size(); ++k)
+        sum += c[k] * px[exponents[k].first] * py[exponents[k].second];
+    return sum;
+}
+
+std::vector<double> SurfaceFitter::coefficients() const {
+    if (c.empty()) throw std::logic_error("fit() has not been called");
+    // index of term x^i y^j in term order
+    auto index = [](int i, int j) {
+        int t = i + j;
+        return t * (t + 1) / 2 + j;
+    };
+
+    std::vector<double> result(exponents.size(), 0.0);
+    for (size_t k = 0; k < exponents.size(); ++k) {
+        std::vector<double> ex = shiftedPower(exponents[k].first, cx, sx);
+        std::vector<double> ey = shiftedPower(exponents[k].second, cy, sy);
+        for (size_t p = 0; p < ex.size(); ++p)
+            for (size_t q = 0; q < ey.size(); ++q)
+                result[index(int(p), int(q))] += c[k] * ex[p] * ey[q];
+    }
+    return result;
+}
@@ -0,0 +1,105 @@
+#include "WeightedLeastSquares.h"
+#include "LeastSquares.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+WeightedLeastSquares::WeightedLeastSquares(DenseMatrix basisT, std::vector<double> yv)
+ : basis(std::move(basisT)), work(basis.rows(), basis.cols()),
+   y(std::move(yv)), rhs(y.size()),
+   residual(0.0), condition(0.0), iterationCount(0)
+{
+    if (basis.cols() != int(y.size()))
+        throw std::invalid_argument("Design matrix and data have different numbers of points");
+    if (basis.cols() <= basis.rows())
+        throw std::invalid_argument("Need more points than unknowns");
+}
+
+std::vector<double> WeightedLeastSquares::solve() {
+    return solve(std::vector<double>(y.size(), 1.0));
+}
+
+std::vector<double> WeightedLeastSquares::solve(const std::vector<double>& weights) {
+    int m = basis.rows(), N = basis.cols();
+    if (int(weights.size()) != N)
+        throw std::invalid_argument("Need one weight per point");
+
+    // scale every row of X and y by sqrt(w)
+    std::vector<double> root(N);
+    for (int i = 0; i < N; ++i) {
+        if (!(weights[i] >= 0))
+            throw std::invalid_argument("Weights must be non-negative");
+        root[i] = std::sqrt(weights[i]);
+        rhs[i] = y[i] * root[i];
+    }
+    for (int k = 0; k < m; ++k) {
+        const double* src = basis.row(k);
+        double* dst = work.row(k);
+        for (int i = 0; i < N; ++i) dst[i] = src[i] * root[i];
+    }
+
+    QRLeastSquares qr(m);
+    qr.addRows(work, rhs.data(), N);
+
+    lastWeights = weights;
+    residual = qr.residualNorm();
+    condition = qr.conditionEstimate();
+    iterationCount = 1;
+    return qr.solve();
+}
+
+std::vector<double> WeightedLeastSquares::residuals(const std::vector<double>& c) const {
+    std::vector<double> r(y);
+    for (int k = 0; k < basis.rows(); ++k) {
+        const double* bk = basis.row(k);
+        double ck = c[k];
+        for (int i = 0; i < basis.cols(); ++i) r[i] -= ck * bk[i];
+    }
+    return r;
+}
+
+std::vector<double> WeightedLeastSquares::solveRobust(RobustLoss loss, double tuning,
+                                                      const std::vector<double>& priorWeights,
+                                                      int maxIterations, double tolerance) {
+    int N = basis.cols();
+    std::vector<double> prior = priorWeights.empty() ? std::vector<double>(N, 1.0) : priorWeights;
+    if (tuning <= 0) tuning = (loss == RobustLoss::Huber) ? 1.345 : 4.685;
+
+    std::vector<double> c = solve(prior);
+    std::vector<double> w(N), spread(N);
+    int iter = 1;
+
+    for (; iter < maxIterations; ++iter) {
+        std::vector<double> r = residuals(c);
+
+        // robust scale: median absolute residual / 0.6745
+        for (int i = 0; i < N; ++i) spread[i] = std::fabs(r[i]);
+        std::nth_element(spread.begin(), spread.begin() + N / 2, spread.end());
+        double scale = spread[N / 2] / 0.6745;
+        if (scale == 0) break;   // (at least) half the points are fitted exactly
+
+        for (int i = 0; i < N; ++i) {
+            double u = std::fabs(r[i]) / (tuning * scale);
+            double robust;
+            if (loss == RobustLoss::Huber) robust = (u <= 1) ? 1.0 : 1.0 / u;
+            else robust = (u < 1) ? (1 - u * u) * (1 - u * u) : 0.0;
+            w[i] = prior[i] * robust;
+        }
+
+        std::vector<double> next = solve(w);
+
+        double change = 0, size = 0;
+        for (size_t k = 0; k < c.size(); ++k) {
+            change = std::max(change, std::fabs(next[k] - c[k]));
+            size = std::max(size, std::fabs(next[k]));
+        }
+        c.swap(next);
+        if (change <= tolerance * (1 + size)) {
+            ++iter;
+            break;
+        }
+    }
+
+    iterationCount = iter;
+    return c;
+}
@@ -1,8 +1,11 @@
 #include "bisection.h"
-#include "parser.h"
+#include "ExpressionCache.h"
+#include "IntervalRootIsolator.h"
+#include "Instrumentation.h"
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 
 using namespace std;
 
@@ -13,6 +16,9 @@ bisection::bisection()
 
 }
 
+bisection::bisection(const string& expression, double lower, double upper, double tolerance, int iterations)
+    : expr(expression), a(lower), b(upper), tol(tolerance), maxIter(iterations) {}
+
 void bisection::get_input()
 {
     cout << "Enter function f(x): ";
@@ -31,23 +37,36 @@ void bisection::get_input()
     cin >> maxIter;
 }
 
-void bisection::bisection_solve()
+double bisection::bisection_solve(bool verbose)
 {
+    NUMERICAL_SOLVER(telemetry, "solver.bisection");
 
-    EquationParser Parser;
-
-    Parser.parseEquation(expr);
-    double fa = Parser.evaluate(a);
+    auto Parser = compileExpression(expr);
 
-    Parser.parseEquation(expr);
-    double fb = Parser.evaluate(b);
+    double fa = Parser->evaluate(a);
+    double fb = Parser->evaluate(b);
 
     if (fa * fb >= 0) {
+        if (!verbose) return NAN;
         cout << "No sign change: f(a) and f(b) must have opposite signs.\n";
-        return;
+        if (a == b) return NAN;
+
+        // even-multiplicity roots and pairs of roots keep the signs equal;
+        // interval arithmetic still finds them, or proves there are none
+        IsolationResult isolation = isolateRoots(*Parser, min(a, b), max(a, b));
+        if (isolation.complete)
+            cout << "Interval analysis: exactly " << isolation.certifiedRoots << " root(s) in the interval\n";
+        else
+            cout << "Interval analysis: " << isolation.certifiedRoots << " certified root(s), "
+                 << isolation.enclosures.size() - isolation.certifiedRoots << " region(s) that may hold roots\n";
+        for (const auto& e : isolation.enclosures)
+            cout << "  [" << setprecision(15) << e.lo << ", " << e.hi << "] "
+                 << (e.unique ? "one root" : "possible root") << "\n";
+        return NAN;
     }
 
-    cout << left << setw(8) << "Iter" 
+    if (verbose)
+        cout << left << setw(8) << "Iter" 
          << setw(15) << "a" 
          << setw(15) << "b" 
          << setw(15) << "c" 
@@ -55,18 +74,19 @@ void bisection::bisection_solve()
 
     for (int i = 1; i <= maxIter; ++i) {
         double c = (a + b) / 2;
-        Parser.parseEquation(expr);
-        double fc = Parser.evaluate(c);
+        double fc = Parser->evaluate(c);
+        NUMERICAL_CONVERGENCE(telemetry, i, c, fabs(fc), fabs(b - a));
 
-        cout << left << setw(8) << i
-             << setw(15) << a
-             << setw(15) << b
-             << setw(15) << c
-             << setw(15) << fc << endl;
+        if (verbose)
+            cout << left << setw(8) << i
+                 << setw(15) << a
+                 << setw(15) << b
+                 << setw(15) << c
+                 << setw(15) << fc << endl;
 
         if (fabs(fc) < tol) {
-            cout << "\nRoot found: " << c << "\n";
-            return;
+            if (verbose) cout << "\nRoot found: " << c << "\n";
+            return c;
         }
 
         if (fa * fc < 0) {
@@ -78,5 +98,7 @@ void bisection::bisection_solve()
         }
     }
 
-    cout << "\nApproximate root after max iterations: " << (a + b) / 2 << "\n";
+    double c = (a + b) / 2;
+    if (verbose) cout << "\nApproximate root after max iterations: " << c << "\n";
+    return c;
 }
@@ -1,24 +1,60 @@
 #include "integration.h"
+#include "ExtendedPrecision.h"
+#include "DoubleExponential.h"
+#include "ResultCache.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
 
 using namespace std;
 
-double NumericalIntegrator::getBoundInput(const string& prompt) {
+namespace {
+
+// compute(), or its `count` values from the result cache when one is
+// enabled; a record of another length is treated as a miss
+vector<double> memoized(const char* method, const string& equation, double a, double b, int n, size_t count,
+                        const function<vector<double>()>& compute) {
+    shared_ptr<ResultCache> cache = ResultCache::globalForExpressions();
+    if (!cache) return compute();
+    ResultKey key(method);
+    key.addExpression(equation).add(a).add(b).add(double(n));
+    vector<double> values;
+    if (cache->lookup(key, values) && values.size() == count) return values;
+    values = compute();
+    cache->store(key, values);
+    return values;
+}
+
+}
+
+double NumericalIntegrator::getBoundInput(const string& prompt, double excluded) {
     string input;
     while (true) {
         cout << prompt;
-        getline(cin, input);
+        if (!getline(cin, input)) throw runtime_error("No more input");
         
+        double value;
         try {
-            size_t pos;
-            double value = stod(input, &pos);
-            if (pos == input.length()) return value;
-            
-            EquationParser bound_parser;
-            bound_parser.parseEquation(input);
-            return bound_parser.evaluate(0);
+            // inf, -inf and infinity (any case) give infinite bounds
+            string word = input;
+            transform(word.begin(), word.end(), word.begin(), [](unsigned char c) { return char(tolower(c)); });
+            if (word == "inf" || word == "+inf" || word == "infinity" || word == "+infinity") value = HUGE_VAL;
+            else if (word == "-inf" || word == "-infinity") value = -HUGE_VAL;
+            else {
+                size_t pos;
+                value = stod(input, &pos);
+                if (pos != input.length()) value = compileExpression(input)->evaluate(0);
+            }
         } catch (const exception& e) {
             cout << "Invalid input (" << e.what() << "). Please try again.\n";
+            continue;
         }
+
+        // no finite bound lies past +inf from a lower bound (or -inf from an upper one)
+        if (isnan(value)) cout << "Invalid input (not a number). Please try again.\n";
+        else if (value == excluded) cout << "Invalid input (" << input << " cannot bound this end). Please try again.\n";
+        else return value;
     }
 }
 
@@ -26,6 +62,7 @@ void NumericalIntegrator::getValidInput(const string& prompt, int& value, int mi
     while (true) {
         cout << prompt;
         cin >> value;
+        if (cin.eof()) throw runtime_error("No more input");
         if (cin.fail() || value < min_val) {
             cin.clear();
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
@@ -45,7 +82,7 @@ void NumericalIntegrator::generatePoints() {
     for (int i = 0; i < n; i++) {
         x[i] = a + i * h;
         try {
-            fx[i] = parser.evaluate(x[i]);
+            fx[i] = parser->evaluate(x[i]);
         } catch (const exception& e) {
             cout << "Error evaluating at x = " << x[i] << ": " << e.what() << endl;
             throw;
@@ -70,26 +107,52 @@ void NumericalIntegrator::displayTable() {
     }
 }
 
+void NumericalIntegrator::ensurePoints() {
+    if (fx.empty()) generatePoints();
+}
+
 double NumericalIntegrator::trapezoidalRule() {
-    double sum = fx[0] + fx[n-1];
-    for (int i = 1; i < n-1; i++) sum += 2 * fx[i];
-    return (h / 2.0) * sum;
+    return memoized("integrate.trapezoidal", equation, a, b, n, 1, [&] {
+        ensurePoints();
+        return vector<double>{compositeIntegral(fx, h, IntegrationRule::Trapezoidal)};
+    })[0];
 }
 
 double NumericalIntegrator::simpsons13Rule() {
-    if ((n - 1) % 2 != 0) throw runtime_error("Simpson's 1/3 needs even intervals");
-    
-    double sum = fx[0] + fx[n-1];
-    for (int i = 1; i < n-1; i++) sum += (i % 2 == 0) ? 2 * fx[i] : 4 * fx[i];
-    return (h / 3.0) * sum;
+    return memoized("integrate.simpson13", equation, a, b, n, 1, [&] {
+        ensurePoints();
+        return vector<double>{compositeIntegral(fx, h, IntegrationRule::Simpson13)};
+    })[0];
 }
 
 double NumericalIntegrator::simpsons38Rule() {
-    if ((n - 1) % 3 != 0) throw runtime_error("Simpson's 3/8 needs intervals divisible by 3");
-    
-    double sum = fx[0] + fx[n-1];
-    for (int i = 1; i < n-1; i++) sum += (i % 3 == 0) ? 2 * fx[i] : 3 * fx[i];
-    return (3.0 * h / 8.0) * sum;
+    return memoized("integrate.simpson38", equation, a, b, n, 1, [&] {
+        ensurePoints();
+        return vector<double>{compositeIntegral(fx, h, IntegrationRule::Simpson38)};
+    })[0];
+}
+
+double NumericalIntegrator::doubleExponential() {
+    vector<double> result = memoized("integrate.double_exponential", equation, a, b, 0, 3, [&] {
+        QuadratureResult r = integrateDoubleExponential(*parser, a, b);
+        return vector<double>{r.value, r.errorEstimate, r.converged ? 1.0 : 0.0};
+    });
+    if (result[2] == 0)
+        cout << "(not converged; error estimate " << scientific << result[1] << fixed << ")\n";
+    return result[0];
+}
+
+NumericalIntegrator::NumericalIntegrator(const string& expression, double lower, double upper, int points)
+    : parser(compileExpression(expression)), equation(expression), a(lower), b(upper), n(points) {
+    if (!(b > a)) throw invalid_argument("Upper bound must be greater than lower bound");
+    if (n < 2) throw invalid_argument("Need at least two points");
+    if (!ResultCache::globalForExpressions()) {
+        generatePoints();
+    } else {
+        // the rules sample on a miss only; an undefined end point still fails here
+        parser->evaluate(a);
+        parser->evaluate(b);
+    }
 }
 
  NumericalIntegrator::NumericalIntegrator() {
@@ -99,9 +162,8 @@ double NumericalIntegrator::simpsons38Rule() {
     while (true) {
         try {
             cout << "\nEnter equation (e.g., exp((-x)^2)): ";
-            string equation;
             getline(cin, equation);
-            parser.parseEquation(equation);
+            parser = compileExpression(equation);
             break;
         } catch (const exception& e) {
             cout << "Error: " << e.what() << "\nPlease try again.\n";
@@ -109,25 +171,27 @@ double NumericalIntegrator::simpsons38Rule() {
     }
     
     // Get bounds
-    a = getBoundInput("Enter lower bound (a): ");
-    b = getBoundInput("Enter upper bound (b): ");
+    a = getBoundInput("Enter lower bound (a, or -inf): ", HUGE_VAL);
+    b = getBoundInput("Enter upper bound (b, or inf): ", -HUGE_VAL);
     while (b <= a) {
         cout << "Upper bound must be greater than lower bound.\n";
-        b = getBoundInput("Enter upper bound (b): ");
+        b = getBoundInput("Enter upper bound (b, or inf): ", -HUGE_VAL);
     }
     
-    // Get number of points
-    getValidInput("Enter number of points (>=2): ", n, 2);
-    
-    // Generate points
-    try {
-        generatePoints();
-    } catch (...) {
-        return;
+    // The equally spaced rules need f at both end points of a finite range
+    bool sampled = isfinite(a) && isfinite(b);
+    n = 0;
+    if (sampled) {
+        getValidInput("Enter number of points (>=2): ", n, 2);
+        try {
+            generatePoints();
+            displayTable();
+        } catch (...) {
+            sampled = false;
+        }
     }
-    
-    // Display table
-    displayTable();
+    if (!sampled)
+        cout << "Only double-exponential quadrature applies to this integral.\n";
     
     // Integration method selection
     int choice;
@@ -138,14 +202,23 @@ double NumericalIntegrator::simpsons38Rule() {
         cout << "3. Simpson's 3/8 Rule\n";
         cout << "4. All Methods\n";
         cout << "5. Exit\n";
+        cout << "6. Double-Exponential (tanh-sinh)\n";   // after Exit, so scripted choices keep their meaning
         cout << "Enter choice: ";
         
-        while (!(cin >> choice) || choice < 1 || choice > 5) {
+        while (!(cin >> choice) || choice < 1 || choice > 6) {
+            if (cin.eof()) {   // end of input exits
+                choice = 5;
+                break;
+            }
             cin.clear();
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Invalid choice. Please enter 1-5: ";
+            cout << "Invalid choice. Please enter 1-6: ";
         }
         cin.ignore();
+        if (!sampled && (choice == 1 || choice == 2 || choice == 3)) {
+            cout << "This rule needs equally spaced samples on a finite range; choose 6.\n";
+            continue;
+        }
         
         try {
             switch (choice) {
@@ -158,11 +231,19 @@ double NumericalIntegrator::simpsons38Rule() {
                 case 3:
                     cout << "\nSimpson's 3/8 Rule Result: " << simpsons38Rule() << endl;
                     break;
+                case 6:
+                    cout << "\nDouble-Exponential Result: " << setprecision(15) << doubleExponential()
+                         << setprecision(6) << endl;
+                    break;
                 case 4:
                     cout << "\nAll Integration Methods:\n";
-                    cout << "Trapezoidal Rule: " << trapezoidalRule() << endl;
-                    cout << "Simpson's 1/3 Rule: " << simpsons13Rule() << endl;
-                    cout << "Simpson's 3/8 Rule: " << simpsons38Rule() << endl;
+                    if (sampled) {
+                        cout << "Trapezoidal Rule: " << trapezoidalRule() << endl;
+                        cout << "Simpson's 1/3 Rule: " << simpsons13Rule() << endl;
+                        cout << "Simpson's 3/8 Rule: " << simpsons38Rule() << endl;
+                    }
+                    cout << "Double-Exponential: " << setprecision(15) << doubleExponential()
+                         << setprecision(6) << endl;
                     break;
             }
         } catch (const exception& e) {
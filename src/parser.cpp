@@ -1,296 +1,1153 @@
 #include "parser.h"
+#include "Precision.h"
+#include "Interval.h"
+#include "Instrumentation.h"
+#include <charconv>
 #include <cmath>
-#include <stack>
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <type_traits>
+#include <mutex>
 
 using namespace std;
 
+namespace {
+// Value part of a plain or dual number, for the domain checks
+template <typename T> inline T real(T v) { return v; }
+inline double real(const Dual<double>& v) { return v.v; }
+inline double real(const Interval& v) { return v.mid(); }
+inline double real(const Dual<Interval>& v) { return v.v.mid(); }
+
+// Whether a domain error met on the way is reported (see evaluate). An
+// interval result already says what happened: undefined points are left out
+// and poles give infinite bounds.
+template <typename V> bool reportsError(const V& result) { return !isFiniteValue(real(result)); }
+inline bool reportsError(const Interval&) { return false; }
+inline bool reportsError(const Dual<Interval>&) { return false; }
+
+// Literals kept in T by compile(), if any
+template <typename T> const T* storedLiterals(const vector<long double>&) { return nullptr; }
+template <> const long double* storedLiterals<long double>(const vector<long double>& wide) { return wide.data(); }
+
+// Named constants, with enough digits for every supported precision
+struct ConstantInfo {
+    const char* name;
+    const char* digits;
+};
+
+const ConstantInfo kConstants[] = {
+    {"pi", "3.14159265358979323846264338327950288419716939937510"},
+    {"e",  "2.71828182845904523536028747135266249775724709369995"}
+};
+
+// Points evaluated together by the batch interpreter
+const size_t kBatchBlock = 256;
+
+// One row per parameter, repeating its default value for every point
+vector<const double*> broadcast(const vector<double>& values, size_t count,
+                                vector<vector<double>>& storage) {
+    storage.assign(values.size(), vector<double>());
+    vector<const double*> rows;
+    for (size_t k = 0; k < values.size(); ++k) {
+        storage[k].assign(count, values[k]);
+        rows.push_back(storage[k].data());
+    }
+    return rows;
+}
+
+// Built-in functions: name, opcode and number of arguments
+// (0 for min/max, which take two or more and compile to a chain)
+struct FunctionInfo {
+    const char* name;
+    EquationParser::OpCode op;
+    int arity;
+};
+
+const FunctionInfo kFunctions[] = {
+    {"sin", EquationParser::OpCode::Sin, 1},   {"cos", EquationParser::OpCode::Cos, 1},
+    {"tan", EquationParser::OpCode::Tan, 1},   {"asin", EquationParser::OpCode::Asin, 1},
+    {"acos", EquationParser::OpCode::Acos, 1}, {"atan", EquationParser::OpCode::Atan, 1},
+    {"sinh", EquationParser::OpCode::Sinh, 1}, {"cosh", EquationParser::OpCode::Cosh, 1},
+    {"tanh", EquationParser::OpCode::Tanh, 1}, {"sqrt", EquationParser::OpCode::Sqrt, 1},
+    {"exp", EquationParser::OpCode::Exp, 1},   {"ln", EquationParser::OpCode::Ln, 1},
+    {"log", EquationParser::OpCode::Log, 1},   {"abs", EquationParser::OpCode::Abs, 1},
+    {"floor", EquationParser::OpCode::Floor, 1}, {"ceil", EquationParser::OpCode::Ceil, 1},
+    {"min", EquationParser::OpCode::Min, 0},   {"max", EquationParser::OpCode::Max, 0}
+};
+
+// Every reserved word, found with a perfect hash: the hash below puts each
+// in its own slot of a 64-entry table (checked at compile time), so a lookup
+// is one hash, one table read and one comparison
+enum class KeywordKind { Function, Constant, X, Y };
+
+struct KeywordInfo {
+    const char* name;
+    KeywordKind kind;
+    int index;   // into kFunctions or kConstants
+};
+
+constexpr KeywordInfo kKeywords[] = {
+    {"sin", KeywordKind::Function, 0},   {"cos", KeywordKind::Function, 1},
+    {"tan", KeywordKind::Function, 2},   {"asin", KeywordKind::Function, 3},
+    {"acos", KeywordKind::Function, 4},  {"atan", KeywordKind::Function, 5},
+    {"sinh", KeywordKind::Function, 6},  {"cosh", KeywordKind::Function, 7},
+    {"tanh", KeywordKind::Function, 8},  {"sqrt", KeywordKind::Function, 9},
+    {"exp", KeywordKind::Function, 10},  {"ln", KeywordKind::Function, 11},
+    {"log", KeywordKind::Function, 12},  {"abs", KeywordKind::Function, 13},
+    {"floor", KeywordKind::Function, 14}, {"ceil", KeywordKind::Function, 15},
+    {"min", KeywordKind::Function, 16},  {"max", KeywordKind::Function, 17},
+    {"pi", KeywordKind::Constant, 0},    {"e", KeywordKind::Constant, 1},
+    {"x", KeywordKind::X, 0}, {"X", KeywordKind::X, 0}, {"y", KeywordKind::Y, 0}, {"Y", KeywordKind::Y, 0}
+};
+const int kKeywordCount = int(sizeof kKeywords / sizeof kKeywords[0]);
+const size_t kKeywordSlots = 64;
+
+constexpr size_t keywordHash(const char* s, size_t n) {
+    return (n + 2 * size_t((unsigned char)s[0]) + 3 * size_t((unsigned char)s[n - 1]) +
+            (n > 1 ? size_t((unsigned char)s[1]) : 0)) & (kKeywordSlots - 1);
+}
+
+constexpr size_t length(const char* s) {
+    size_t n = 0;
+    while (s[n]) ++n;
+    return n;
+}
+
+struct KeywordTable {
+    signed char slot[kKeywordSlots];
+    bool perfect;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table = {{}, true};
+    for (size_t i = 0; i < kKeywordSlots; ++i) table.slot[i] = -1;
+    for (int k = 0; k < kKeywordCount; ++k) {
+        size_t h = keywordHash(kKeywords[k].name, length(kKeywords[k].name));
+        if (table.slot[h] >= 0) table.perfect = false;
+        table.slot[h] = (signed char)k;
+    }
+    return table;
+}
+
+constexpr KeywordTable kKeywordTable = buildKeywordTable();
+static_assert(kKeywordTable.perfect, "keyword hash has a collision: change keywordHash");
+
+const KeywordInfo* findKeyword(string_view name) {
+    if (name.empty()) return nullptr;
+    int k = kKeywordTable.slot[keywordHash(name.data(), name.size())];
+    return (k >= 0 && name == kKeywords[k].name) ? &kKeywords[k] : nullptr;
+}
+
+const FunctionInfo* findFunction(string_view name) {
+    const KeywordInfo* k = findKeyword(name);
+    return (k && k->kind == KeywordKind::Function) ? &kFunctions[k->index] : nullptr;
+}
+
+const ConstantInfo* findConstant(string_view name) {
+    const KeywordInfo* k = findKeyword(name);
+    return (k && k->kind == KeywordKind::Constant) ? &kConstants[k->index] : nullptr;
+}
+
+// User-defined functions, stored compiled: the body's program reads its
+// arguments as parameters 0, 1, ... and its literals from its own table
+struct UserFunction {
+    size_t arguments;
+    vector<EquationParser::Instruction> program;
+    vector<string> literals;
+    vector<long double> wideLiterals;
+};
+
+struct FunctionRegistry {
+    mutex lock;
+    map<string, shared_ptr<const UserFunction>, less<>> functions;
+    unsigned long generation = 0;
+};
+
+FunctionRegistry& registry() {
+    static FunctionRegistry instance;
+    return instance;
+}
+
+shared_ptr<const UserFunction> findUserFunction(string_view name) {
+    FunctionRegistry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    auto it = r.functions.find(name);
+    return it == r.functions.end() ? nullptr : it->second;
+}
+
+// A literal in long double, as strtold reads it. Up to 19 significant
+// digits and a power of ten up to 27 are both exact in a 64-bit significand,
+// so their product or quotient is one correctly rounded operation; other
+// literals go to strtold.
+long double wideLiteral(const string& text) {
+    if (numeric_limits<long double>::digits >= 64) {
+        static const vector<long double> powers = [] {
+            vector<long double> p(28, 1.0L);
+            for (size_t k = 1; k < p.size(); ++k) p[k] = p[k - 1] * 10;
+            return p;
+        }();
+        uint64_t mantissa = 0;
+        int digits = 0, scale = 0;
+        size_t i = 0;
+        bool fraction = false;
+        for (; i < text.size() && (isdigit((unsigned char)text[i]) || text[i] == '.'); ++i) {
+            if (text[i] == '.') {
+                fraction = true;
+                continue;
+            }
+            if (mantissa == 0 && text[i] == '0') {
+                if (fraction) --scale;
+                continue;
+            }
+            if (++digits > 19) return ScalarTraits<long double>::parse(text);
+            mantissa = mantissa * 10 + uint64_t(text[i] - '0');
+            if (fraction) --scale;
+        }
+        if (i < text.size()) {   // exponent
+            int exponent = 0, sign = 1;
+            if (++i < text.size() && (text[i] == '+' || text[i] == '-')) sign = text[i++] == '-' ? -1 : 1;
+            for (; i < text.size() && exponent < 10000; ++i) exponent = exponent * 10 + (text[i] - '0');
+            scale += sign * exponent;
+        }
+        if (mantissa == 0) return 0.0L;
+        if (scale >= 0 && scale < int(powers.size())) return (long double)mantissa * powers[size_t(scale)];
+        if (scale < 0 && -scale < int(powers.size())) return (long double)mantissa / powers[size_t(-scale)];
+    }
+    return ScalarTraits<long double>::parse(text);
+}
+
+// Functions of one argument, which leave the stack depth unchanged
+bool isUnary(EquationParser::OpCode op) {
+    return op >= EquationParser::OpCode::Sin && op <= EquationParser::OpCode::Ceil;
+}
+
+// Binding powers of the infix operators. The operand of unary minus takes
+// at least * and /, so -2*x is -(2*x) and -x^2 is -(x^2), and no more than
+// the operator before it allows, so x^-1*2 is (x^-1)*2
+const int kConditional = 1;
+const int kUnaryMinus = 5;
+
+// Nested parentheses, calls and unary minus allowed in one expression
+const int kMaxNesting = 1000;
+
+// 1 or 0 as a value of type V
+template <typename V> V truth(bool b) { return V(b ? 1.0 : 0.0); }
+
+// Comparisons, min/max and the conditional on one value. Intervals overload
+// them with their three-valued versions (Interval.h).
+using Op = EquationParser::OpCode;
+
+template <typename V> V comparison(Op op, const V& a, const V& b) {
+    switch (op) {
+    case Op::Less: return truth<V>(real(a) < real(b));
+    case Op::LessEqual: return truth<V>(real(a) <= real(b));
+    case Op::Greater: return truth<V>(real(a) > real(b));
+    case Op::GreaterEqual: return truth<V>(real(a) >= real(b));
+    case Op::Equal: return truth<V>(real(a) == real(b));
+    default: return truth<V>(real(a) != real(b));
+    }
+}
+template <typename V> V choose(const V& c, const V& a, const V& b) { return real(c) != 0 ? a : b; }
+template <typename V> V smaller(const V& a, const V& b) { return real(b) < real(a) ? b : a; }
+template <typename V> V larger(const V& a, const V& b) { return real(b) > real(a) ? b : a; }
+
+Interval comparison(Op op, const Interval& a, const Interval& b) {
+    switch (op) {
+    case Op::Less: return compareLess(a, b);
+    case Op::LessEqual: return compareLessEqual(a, b);
+    case Op::Greater: return compareLess(b, a);
+    case Op::GreaterEqual: return compareLessEqual(b, a);
+    case Op::Equal: return compareEqual(a, b);
+    default: {
+        Interval equal = compareEqual(a, b);
+        return Interval(1 - equal.hi, 1 - equal.lo);
+    }
+    }
+}
+Interval choose(const Interval& c, const Interval& a, const Interval& b) { return select(c, a, b); }
+Interval smaller(const Interval& a, const Interval& b) { return minimum(a, b); }
+Interval larger(const Interval& a, const Interval& b) { return maximum(a, b); }
+
+// Piecewise operations on Dual<Interval>: when the piece is not certain the
+// value and derivative enclosures cover both
+Dual<Interval> comparison(Op op, const Dual<Interval>& a, const Dual<Interval>& b) {
+    return Dual<Interval>(comparison(op, a.v, b.v));
+}
+Dual<Interval> choose(const Dual<Interval>& c, const Dual<Interval>& a, const Dual<Interval>& b) {
+    if (c.v.isEmpty()) return Dual<Interval>(c.v, c.v);
+    if (!c.v.contains(0.0)) return a;
+    if (c.v == Interval(0)) return b;
+    return Dual<Interval>(hull(a.v, b.v), hull(a.d, b.d));
+}
+Dual<Interval> smaller(const Dual<Interval>& a, const Dual<Interval>& b) {
+    if (a.v.hi <= b.v.lo) return a;
+    if (b.v.hi <= a.v.lo) return b;
+    return Dual<Interval>(minimum(a.v, b.v), hull(a.d, b.d));
+}
+Dual<Interval> larger(const Dual<Interval>& a, const Dual<Interval>& b) {
+    if (a.v.lo >= b.v.hi) return a;
+    if (b.v.lo >= a.v.hi) return b;
+    return Dual<Interval>(maximum(a.v, b.v), hull(a.d, b.d));
+}
+}
+
 // Constructor
-EquationParser::EquationParser() : allow_xy(false) {}
+EquationParser::EquationParser() : max_depth(0), uses_x(false), uses_y(false), allow_xy(false) {}
 
 // Set the flag to allow or disallow both x and y in the same expression
 void EquationParser::setAllowXY(bool allow) {
     allow_xy = allow;
 }
 
-// Check if the character is a valid operator
-bool EquationParser::isOperator(char c) {
-    return c == '+' || c == '-' || c == '*' || c == '/' || c == '^';
+ParseError::ParseError(const string& message, size_t position)
+    : runtime_error(message + " at position " + to_string(position)), offset(position) {}
+
+// Check if the string is a built-in function
+bool EquationParser::isFunction(const string& token) {
+    return findFunction(token) != nullptr;
 }
 
-// Get the precedence of operators
-int EquationParser::precedence(char op) {
-    if (op == '+' || op == '-') return 1;
-    if (op == '*' || op == '/') return 2;
-    if (op == '^') return 3;
-    return 0;
+void EquationParser::defineFunction(const string& name, const vector<string>& arguments,
+                                    const string& body) {
+    EquationParser probe;
+    if (name.empty() || !isalpha(name[0]))
+        throw runtime_error("Invalid function name: '" + name + "'");
+    for (char c : name) {
+        if (!isalnum(c) && c != '_') throw runtime_error("Invalid function name: '" + name + "'");
+    }
+    if (findKeyword(name))
+        throw runtime_error("Function name '" + name + "' is reserved");
+
+    // the compiled body is what calls inline, with the arguments as parameters
+    probe.setAllowXY(true);
+    probe.setParameters(arguments);
+    probe.parseEquation(body);
+    auto f = make_shared<UserFunction>();
+    f->arguments = arguments.size();
+    f->program = probe.program;
+    f->literals = probe.literal_text;
+    f->wideLiterals = probe.wide_literals;
+
+    FunctionRegistry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    r.functions[name] = f;
+    ++r.generation;
 }
 
-// Check if the string is a valid mathematical function
-bool EquationParser::isFunction(const string& token) {
-    for (const auto& func : math_functions) {
-        if (token == func) return true;
+bool EquationParser::isUserFunction(const string& name) {
+    return findUserFunction(name) != nullptr;
+}
+
+unsigned long EquationParser::functionGeneration() {
+    FunctionRegistry& r = registry();
+    lock_guard<mutex> guard(r.lock);
+    return r.generation;
+}
+
+// Check if the string is a declared parameter
+bool EquationParser::isParameter(const string& token) const {
+    return findParameter(token) >= 0;
+}
+
+int EquationParser::parameterIndex(const string& name) const {
+    return findParameter(name);
+}
+
+int EquationParser::findParameter(string_view name) const {
+    for (size_t k = 0; k < parameter_names.size(); ++k) {
+        if (parameter_names[k] == name) return int(k);
+    }
+    return -1;
+}
+
+void EquationParser::setParameters(const vector<string>& names) {
+    for (const auto& name : names) {
+        if (name.empty() || !isalpha(name[0]))
+            throw runtime_error("Invalid parameter name: '" + name + "'");
+        for (char c : name) {
+            if (!isalnum(c) && c != '_') throw runtime_error("Invalid parameter name: '" + name + "'");
+        }
+        if (findKeyword(name))
+            throw runtime_error("Parameter name '" + name + "' is reserved");
     }
-    return false;
+    parameter_names = names;
+    parameter_values.assign(names.size(), 0.0);
+    postfix.clear();
+    program.clear();
+}
+
+void EquationParser::setParameterValue(const string& name, double value) {
+    int k = parameterIndex(name);
+    if (k < 0) throw runtime_error("Unknown parameter: " + name);
+    parameter_values[k] = value;
 }
 
 // Check if the string is a constant (like pi or e)
 bool EquationParser::isConstant(const string& token) {
-    return constants.find(token) != constants.end();
+    return findConstant(token) != nullptr;
 }
 
-// Validate the tokens to ensure the equation is valid
-void EquationParser::validateTokens() {
-    int paren_count = 0;
-    bool has_x = false, has_y = false;
+// ---- lexer: one token of lookahead, every token a view into the text ----
+
+struct EquationParser::Lexer {
+    enum Kind { End, Number, Name, Operator, LeftParen, RightParen, Comma, Question, Colon };
+
+    struct Token {
+        Kind kind;
+        string_view text;
+        size_t position;
+        OpCode op;        // for Operator
+        int precedence;   // for Operator
+    };
 
-    for (size_t i = 0; i < tokens.size(); i++) {
-        const string& token = tokens[i];
+    string_view source;
+    size_t next;
+    int nesting;
+    Token token;
 
-        if (token == "(") paren_count++;
-        else if (token == ")") paren_count--;
+    explicit Lexer(string_view text) : source(text), next(0), nesting(0) { advance(); }
 
-        if (i > 0 && isOperator(token[0]) && isOperator(tokens[i - 1][0])) {
-            throw runtime_error("Consecutive operators at position " + to_string(i));
+    void advance() {
+        while (next < source.size() && isspace((unsigned char)source[next])) ++next;
+        size_t start = next;
+        if (next == source.size()) {
+            token = {End, string_view(), start, OpCode::Add, 0};
+            return;
         }
 
-        if (isFunction(token)) {
-            if (i == tokens.size() - 1 || tokens[i + 1] != "(") {
-                throw runtime_error("Function '" + token + "' not followed by parentheses");
+        char c = source[next];
+        if (isdigit((unsigned char)c) || c == '.') {
+            bool decimal = false, exponent = false;
+            while (next < source.size()) {
+                char d = source[next];
+                if (d == '.') {
+                    if (decimal || exponent) throw ParseError("Invalid number format", next);
+                    decimal = true;
+                } else if (d == 'e' || d == 'E') {
+                    if (exponent) throw ParseError("Invalid number format", next);
+                    exponent = true;
+                    if (next + 1 < source.size() && (source[next + 1] == '+' || source[next + 1] == '-')) ++next;
+                } else if (!isdigit((unsigned char)d)) {
+                    break;
+                }
+                ++next;
             }
+            token = {Number, source.substr(start, next - start), start, OpCode::PushConst, 0};
+            return;
+        }
+
+        if (isalpha((unsigned char)c)) {
+            while (next < source.size() && (isalnum((unsigned char)source[next]) || source[next] == '_')) ++next;
+            token = {Name, source.substr(start, next - start), start, OpCode::PushConst, 0};
+            return;
         }
 
-        if (token == "x") has_x = true;
-        if (token == "y") has_y = true;
+        ++next;
+        bool or_equal = next < source.size() && source[next] == '=';
+        switch (c) {
+        case '+': return setOperator(start, OpCode::Add, 4);
+        case '-': return setOperator(start, OpCode::Sub, 4);
+        case '*': return setOperator(start, OpCode::Mul, 5);
+        case '/': return setOperator(start, OpCode::Div, 5);
+        case '^': return setOperator(start, OpCode::Pow, 7);
+        case '<': return setOperator(start, or_equal ? OpCode::LessEqual : OpCode::Less, 3);
+        case '>': return setOperator(start, or_equal ? OpCode::GreaterEqual : OpCode::Greater, 3);
+        case '=':
+            if (!or_equal) throw ParseError("Invalid character: '=' (use == to compare)", start);
+            return setOperator(start, OpCode::Equal, 2);
+        case '!':
+            if (!or_equal) throw ParseError("Invalid character: '!'", start);
+            return setOperator(start, OpCode::NotEqual, 2);
+        case '(': token = {LeftParen, source.substr(start, 1), start, OpCode::Add, 0}; return;
+        case ')': token = {RightParen, source.substr(start, 1), start, OpCode::Add, 0}; return;
+        case ',': token = {Comma, source.substr(start, 1), start, OpCode::Add, 0}; return;
+        case '?': token = {Question, source.substr(start, 1), start, OpCode::Add, 0}; return;
+        case ':': token = {Colon, source.substr(start, 1), start, OpCode::Add, 0}; return;
+        }
+        throw ParseError(string("Invalid character: '") + c + "'", start);
     }
 
-    if (paren_count != 0) {
-        throw runtime_error("Mismatched parentheses in equation");
+    void setOperator(size_t start, OpCode op, int precedence) {
+        bool two = op == OpCode::LessEqual || op == OpCode::GreaterEqual || op == OpCode::Equal || op == OpCode::NotEqual;
+        if (two) ++next;
+        token = {Operator, source.substr(start, next - start), start, op, precedence};
     }
 
-    if (!allow_xy && has_x && has_y) {
-        throw runtime_error("Equation cannot contain both x and y at the same time.");
+    void enter() {
+        if (++nesting > kMaxNesting) throw ParseError("Expression nested too deeply", token.position);
     }
-}
 
-// Parse the equation into tokens
+    // The current token cannot continue the expression
+    [[noreturn]] void unexpected() const {
+        switch (token.kind) {
+        case End: throw ParseError("Unexpected end of expression", token.position);
+        case RightParen: throw ParseError("Mismatched parentheses", token.position);
+        case Comma: throw ParseError("',' outside a function call", token.position);
+        case Colon: throw ParseError("':' without a matching '?'", token.position);
+        default: throw ParseError("Expected an operator before '" + string(token.text) + "'", token.position);
+        }
+    }
+};
+
+// Compile the equation
 void EquationParser::parseEquation(const string& equation) {
-    tokens.clear();
+    NUMERICAL_TIMED("parser.parse");
     postfix.clear();
+    program.clear();
+    literal_text.clear();
+    wide_literals.clear();
+    try {
+        Lexer in(equation);
+        parseExpression(in, kConditional);
+        if (in.token.kind != Lexer::End) in.unexpected();
+        finish();
+    } catch (...) {
+        program.clear();
+        throw;
+    }
+}
 
-    for (size_t i = 0; i < equation.size(); ) {
-        char c = equation[i];
+// Operands, then every following operator that binds at least as tightly as
+// min_precedence; the program comes out in postfix order as it is read
+void EquationParser::parseExpression(Lexer& in, int min_precedence) {
+    parseOperand(in, min_precedence);
+    while (true) {
+        const Lexer::Token& t = in.token;
+        if (t.kind == Lexer::Operator && t.precedence >= min_precedence) {
+            OpCode op = t.op;
+            int precedence = t.precedence;
+            in.advance();
+            parseExpression(in, precedence + 1);   // binary operators associate to the left
+            program.push_back({op, 0.0, 0});
+        }
+        else if (t.kind == Lexer::Question && kConditional >= min_precedence) {
+            size_t position = t.position;
+            in.enter();
+            in.advance();
+            parseExpression(in, kConditional);
+            if (in.token.kind != Lexer::Colon) throw ParseError("Conditional '?' without ':'", position);
+            in.advance();
+            parseExpression(in, kConditional);   // the conditional associates to the right
+            program.push_back({OpCode::Select, 0.0, 0});
+            --in.nesting;
+        }
+        else {
+            return;
+        }
+    }
+}
 
-        if (isspace(c)) {
-            i++;
-            continue;
+void EquationParser::parseOperand(Lexer& in, int min_precedence) {
+    const Lexer::Token t = in.token;
+    switch (t.kind) {
+    case Lexer::Number: {
+        double value = 0;
+        auto result = from_chars(t.text.data(), t.text.data() + t.text.size(), value);
+        if (result.ec != errc() || result.ptr != t.text.data() + t.text.size())
+            throw ParseError("Invalid number format", t.position);
+        pushLiteral(t.text, value);
+        in.advance();
+        return;
+    }
+    case Lexer::LeftParen:
+        in.enter();
+        in.advance();
+        parseExpression(in, kConditional);
+        if (in.token.kind != Lexer::RightParen) {
+            if (in.token.kind == Lexer::End) throw ParseError("Mismatched parentheses", t.position);
+            in.unexpected();
         }
+        in.advance();
+        --in.nesting;
+        return;
+    case Lexer::Operator:
+        if (t.op != OpCode::Sub) break;
+        // -a is compiled as 0 - a
+        in.enter();
+        in.advance();
+        pushLiteral("0", 0.0);
+        parseExpression(in, max(min_precedence, kUnaryMinus));
+        program.push_back({OpCode::Sub, 0.0, 0});
+        --in.nesting;
+        return;
+    case Lexer::End:
+        throw ParseError("Unexpected end of expression", t.position);
+    default:
+        break;
+    }
+    if (t.kind != Lexer::Name)
+        throw ParseError("Expected a number, variable or '(' before '" + string(t.text) + "'", t.position);
 
-        if (isdigit(c) || c == '.') {
-            string num;
-            bool has_decimal = false, has_exponent = false;
-            while (i < equation.size() && (isdigit(equation[i]) ||
-                equation[i] == '.' || equation[i] == 'e' || equation[i] == 'E' ||
-                ((equation[i] == '+' || equation[i] == '-') &&
-                    (i > 0 && (equation[i - 1] == 'e' || equation[i - 1] == 'E'))))) {
-
-                if (equation[i] == '.') {
-                    if (has_decimal || has_exponent) throw runtime_error("Invalid number format");
-                    has_decimal = true;
-                }
-                else if (equation[i] == 'e' || equation[i] == 'E') {
-                    if (has_exponent) throw runtime_error("Invalid number format");
-                    has_exponent = true;
-                }
-                num += equation[i++];
-            }
-            tokens.push_back(num);
-            continue;
+    in.advance();
+    if (const KeywordInfo* k = findKeyword(t.text)) {
+        switch (k->kind) {
+        case KeywordKind::X: program.push_back({OpCode::PushX, 0.0, 0}); return;
+        case KeywordKind::Y: program.push_back({OpCode::PushY, 0.0, 0}); return;
+        case KeywordKind::Constant: {
+            // read the long digit strings once
+            static const double values[] = {stod(kConstants[0].digits), stod(kConstants[1].digits)};
+            static const long double wide[] = {wideLiteral(kConstants[0].digits), wideLiteral(kConstants[1].digits)};
+            program.push_back({OpCode::PushConst, values[k->index], int(literal_text.size())});
+            literal_text.emplace_back(kConstants[k->index].digits);
+            wide_literals.push_back(wide[k->index]);
+            return;
+        }
+        case KeywordKind::Function: {
+            const FunctionInfo& f = kFunctions[k->index];
+            int args = parseArguments(in, t.text, t.position, nullptr);
+            if (f.arity == 0 && args < 2)
+                throw ParseError("Function '" + string(t.text) + "' takes at least 2 arguments", t.position);
+            if (f.arity > 0 && args != f.arity)
+                throw ParseError("Function '" + string(t.text) + "' takes " + to_string(f.arity) + " argument(s)",
+                                 t.position);
+            // min/max of k arguments is k-1 binary steps
+            for (int i = 0; i < max(1, args - 1); ++i) program.push_back({f.op, 0.0, 0});
+            return;
+        }
         }
+    }
 
-        if (isalpha(c)) {
-            string word;
-            while (i < equation.size() && isalpha(equation[i])) {
-                word += equation[i++];
-            }
+    int parameter = findParameter(t.text);
+    if (parameter >= 0) {
+        program.push_back({OpCode::PushParam, 0.0, parameter});
+        return;
+    }
 
-            if (isFunction(word)) {
-                tokens.push_back(word);
-            }
-            else if (isConstant(word)) {
-                tokens.push_back(word);
-            }
-            else if (word == "x" || word == "X") {
-                tokens.push_back("x");
-            }
-            else if (word == "y" || word == "Y") {
-                tokens.push_back("y");
-            }
-            else {
-                throw runtime_error("Unknown identifier: " + word);
-            }
+    shared_ptr<const UserFunction> f = findUserFunction(t.text);
+    if (!f) throw ParseError("Unknown identifier: " + string(t.text), t.position);
+
+    // inline the body, with every use of an argument replaced by its program
+    size_t start = program.size();
+    vector<size_t> bounds;
+    int args = parseArguments(in, t.text, t.position, &bounds);
+    if (size_t(args) != f->arguments)
+        throw ParseError("Function '" + string(t.text) + "' takes " + to_string(f->arguments) + " argument(s)",
+                         t.position);
+    vector<Instruction> argument_code(program.begin() + start, program.end());
+    program.resize(start);
+
+    int literal_base = int(literal_text.size());
+    literal_text.insert(literal_text.end(), f->literals.begin(), f->literals.end());
+    wide_literals.insert(wide_literals.end(), f->wideLiterals.begin(), f->wideLiterals.end());
+    for (Instruction ins : f->program) {
+        if (ins.op == OpCode::PushParam) {
+            size_t k = size_t(ins.index);
+            size_t from = (k == 0 ? start : bounds[k - 1]) - start, to = bounds[k] - start;
+            program.insert(program.end(), argument_code.begin() + from, argument_code.begin() + to);
             continue;
         }
+        if (ins.op == OpCode::PushConst) ins.index += literal_base;
+        program.push_back(ins);
+    }
+}
 
-        if (isOperator(c) || c == '(' || c == ')') {
-            if (c == '-' && (tokens.empty() || tokens.back() == "(" || isOperator(tokens.back()[0]))) {
-                tokens.push_back("0");
-                tokens.push_back("-");
-                i++;
-                continue;
-            }
-            else {
-                tokens.push_back(string(1, c));
-                i++;
-            }
+// "(a, b, ...)" after a function name; bounds receives where each
+// argument's code ends. Returns the number of arguments.
+int EquationParser::parseArguments(Lexer& in, string_view name, size_t position, vector<size_t>* bounds) {
+    if (in.token.kind != Lexer::LeftParen)
+        throw ParseError("Function '" + string(name) + "' not followed by parentheses", position);
+    in.enter();
+    in.advance();
+    int count = 0;
+    if (in.token.kind == Lexer::RightParen) {
+        in.advance();
+        --in.nesting;
+        return 0;
+    }
+    while (true) {
+        parseExpression(in, kConditional);
+        ++count;
+        if (bounds) bounds->push_back(program.size());
+        if (in.token.kind == Lexer::Comma) {
+            in.advance();
             continue;
         }
+        if (in.token.kind == Lexer::RightParen) break;
+        if (in.token.kind == Lexer::End) throw ParseError("Mismatched parentheses", position);
+        in.unexpected();
+    }
+    in.advance();
+    --in.nesting;
+    return count;
+}
 
-        throw runtime_error(string("Invalid character: '") + c + "'");
+void EquationParser::pushLiteral(string_view digits, double value) {
+    program.push_back({OpCode::PushConst, value, int(literal_text.size())});
+    literal_text.emplace_back(digits);
+    wide_literals.push_back(wideLiteral(literal_text.back()));
+}
+
+// Stack depth the program needs, and which variables it reads
+void EquationParser::finish() {
+    uses_x = uses_y = false;
+    max_depth = 0;
+    int depth = 0;
+    for (const Instruction& ins : program) {
+        switch (ins.op) {
+        case OpCode::PushX: uses_x = true; ++depth; break;
+        case OpCode::PushY: uses_y = true; ++depth; break;
+        case OpCode::PushConst: case OpCode::PushParam: ++depth; break;
+        case OpCode::Select: depth -= 2; break;
+        default:
+            if (!isUnary(ins.op)) --depth;   // binary operators and min / max
+            break;
+        }
+        max_depth = max(max_depth, depth);
     }
 
-    validateTokens();
-    convertToPostfix();
+    if (!allow_xy && uses_x && uses_y) {
+        program.clear();
+        throw runtime_error("Equation cannot contain both x and y at the same time.");
+    }
 }
 
-// Convert the equation to postfix notation
+// The postfix text of the program (literals as written, pi and e by name)
 void EquationParser::convertToPostfix() {
-    stack<string> op_stack;
-
-    for (const auto& token : tokens) {
-        if (token == "x" || token == "y" || isdigit(token[0]) ||
-            (token[0] == '-' && token.size() > 1 && isdigit(token[1])) ||
-            isConstant(token)) {
-            postfix.push_back(token);
-        }
-        else if (isFunction(token)) {
-            op_stack.push(token);
+    postfix.clear();
+    for (const Instruction& ins : program) {
+        switch (ins.op) {
+        case OpCode::PushX: postfix.push_back("x"); break;
+        case OpCode::PushY: postfix.push_back("y"); break;
+        case OpCode::PushParam: postfix.push_back(parameter_names[ins.index]); break;
+        case OpCode::PushConst: {
+            const string& text = literal_text[ins.index];
+            string name = text;
+            for (const auto& c : kConstants)
+                if (text == c.digits) name = c.name;
+            postfix.push_back(name);
+            break;
         }
-        else if (token == "(") {
-            op_stack.push(token);
+        case OpCode::Select: postfix.push_back("?:"); break;
+        case OpCode::Add: postfix.push_back("+"); break;
+        case OpCode::Sub: postfix.push_back("-"); break;
+        case OpCode::Mul: postfix.push_back("*"); break;
+        case OpCode::Div: postfix.push_back("/"); break;
+        case OpCode::Pow: postfix.push_back("^"); break;
+        case OpCode::Less: postfix.push_back("<"); break;
+        case OpCode::LessEqual: postfix.push_back("<="); break;
+        case OpCode::Greater: postfix.push_back(">"); break;
+        case OpCode::GreaterEqual: postfix.push_back(">="); break;
+        case OpCode::Equal: postfix.push_back("=="); break;
+        case OpCode::NotEqual: postfix.push_back("!="); break;
+        default:
+            for (const auto& f : kFunctions)
+                if (f.op == ins.op) postfix.push_back(f.name);
+            break;
         }
-        else if (token == ")") {
-            while (!op_stack.empty() && op_stack.top() != "(") {
-                postfix.push_back(op_stack.top());
-                op_stack.pop();
-            }
-            if (op_stack.empty()) throw runtime_error("Mismatched parentheses");
-            op_stack.pop();
+    }
+}
 
-            if (!op_stack.empty() && isFunction(op_stack.top())) {
-                postfix.push_back(op_stack.top());
-                op_stack.pop();
-            }
+// Run the compiled program on one point (double or Dual<double>), or on a
+// whole interval (Interval, Dual<Interval>).
+// Literals come from ins.value for double and Dual<double>, and from
+// literal_values (the same literals in V) for the other types.
+template <typename V>
+V EquationParser::run(const V& x_value, const V& y_value, const V* param_values,
+                      const V* literal_values) const {
+    using std::sin; using std::cos; using std::tan; using std::asin; using std::acos; using std::atan;
+    using std::sinh; using std::cosh; using std::tanh; using std::sqrt; using std::exp; using std::log;
+    using std::log10; using std::pow; using std::fabs; using std::floor; using std::ceil;
+    using ::sin; using ::cos; using ::tan; using ::asin; using ::acos; using ::atan;
+    using ::sinh; using ::cosh; using ::tanh; using ::sqrt; using ::exp; using ::log;
+    using ::log10; using ::pow; using ::fabs; using ::floor; using ::ceil;
+    const bool double_literals = is_same<V, double>::value || is_same<V, Dual<double>>::value;
+
+    V local[32] = {};
+    vector<V> heap;
+    V* stack = local;
+    if (max_depth > 32) {
+        heap.resize(max_depth);
+        stack = heap.data();
+    }
+
+    // domain errors are only reported if they reach the result (see evaluate)
+    const char* error = nullptr;
+    auto fail = [&](const char* message) { if (!error) error = message; };
+
+    int top = -1;
+    for (const Instruction& ins : program) {
+        switch (ins.op) {
+        case OpCode::PushX: stack[++top] = x_value; break;
+        case OpCode::PushY: stack[++top] = y_value; break;
+        case OpCode::PushConst:
+            stack[++top] = double_literals ? V(ins.value) : literal_values[ins.index];
+            break;
+        case OpCode::PushParam: stack[++top] = param_values[ins.index]; break;
+
+        case OpCode::Add: stack[top - 1] = stack[top - 1] + stack[top]; --top; break;
+        case OpCode::Sub: stack[top - 1] = stack[top - 1] - stack[top]; --top; break;
+        case OpCode::Mul: stack[top - 1] = stack[top - 1] * stack[top]; --top; break;
+        case OpCode::Div:
+            if (real(stack[top]) == 0) fail("Division by zero");
+            stack[top - 1] = stack[top - 1] / stack[top]; --top;
+            break;
+        case OpCode::Pow: stack[top - 1] = pow(stack[top - 1], stack[top]); --top; break;
+
+        case OpCode::Sin: stack[top] = sin(stack[top]); break;
+        case OpCode::Cos: stack[top] = cos(stack[top]); break;
+        case OpCode::Tan: stack[top] = tan(stack[top]); break;
+        case OpCode::Asin: stack[top] = asin(stack[top]); break;
+        case OpCode::Acos: stack[top] = acos(stack[top]); break;
+        case OpCode::Atan: stack[top] = atan(stack[top]); break;
+        case OpCode::Sinh: stack[top] = sinh(stack[top]); break;
+        case OpCode::Cosh: stack[top] = cosh(stack[top]); break;
+        case OpCode::Tanh: stack[top] = tanh(stack[top]); break;
+        case OpCode::Sqrt:
+            if (real(stack[top]) < 0) fail("Square root of negative number");
+            stack[top] = sqrt(stack[top]);
+            break;
+        case OpCode::Exp: stack[top] = exp(stack[top]); break;
+        case OpCode::Ln:
+            if (real(stack[top]) <= 0) fail("Logarithm of non-positive number");
+            stack[top] = log(stack[top]);
+            break;
+        case OpCode::Log:
+            if (real(stack[top]) <= 0) fail("Logarithm of non-positive number");
+            stack[top] = log10(stack[top]);
+            break;
+
+        case OpCode::Abs: stack[top] = fabs(stack[top]); break;
+        case OpCode::Floor: stack[top] = floor(stack[top]); break;
+        case OpCode::Ceil: stack[top] = ceil(stack[top]); break;
+        case OpCode::Min: stack[top - 1] = smaller(stack[top - 1], stack[top]); --top; break;
+        case OpCode::Max: stack[top - 1] = larger(stack[top - 1], stack[top]); --top; break;
+
+        case OpCode::Less: case OpCode::LessEqual: case OpCode::Greater:
+        case OpCode::GreaterEqual: case OpCode::Equal: case OpCode::NotEqual:
+            stack[top - 1] = comparison(ins.op, stack[top - 1], stack[top]);
+            --top;
+            break;
+        case OpCode::Select:
+            stack[top - 2] = choose(stack[top - 2], stack[top - 1], stack[top]);
+            top -= 2;
+            break;
         }
-        else if (isOperator(token[0])) {
-            while (!op_stack.empty() && op_stack.top() != "(" &&
-                ((isOperator(op_stack.top()[0]) && precedence(op_stack.top()[0]) >= precedence(token[0])) ||
-                    isFunction(op_stack.top()))) {
-                postfix.push_back(op_stack.top());
-                op_stack.pop();
+    }
+
+    if (error && reportsError(stack[0])) throw runtime_error(error);
+    return stack[0];
+}
+
+// Run the program over blocks of points: every instruction is applied to a
+// whole block before the next one, so the inner loops are plain array loops.
+// A null x_values / y_values array stands for zeros; param_values[k] holds
+// parameter k for every point.
+template <typename V>
+void EquationParser::runBatch(const V* x_values, const V* y_values, const V* const* param_values,
+                              V* out, size_t count) const {
+    using std::sin; using std::cos; using std::tan; using std::asin; using std::acos; using std::atan;
+    using std::sinh; using std::cosh; using std::tanh; using std::sqrt; using std::exp; using std::log;
+    using std::log10; using std::pow; using std::fabs; using std::floor; using std::ceil;
+
+    vector<V> stack(size_t(max_depth) * kBatchBlock);
+
+    for (size_t start = 0; start < count; start += kBatchBlock) {
+        size_t n = min(kBatchBlock, count - start);
+        V* top = stack.data() - kBatchBlock;   // current top row of the stack
+
+        auto push = [&](const V* source, V value) {
+            top += kBatchBlock;
+            if (source) copy(source + start, source + start + n, top);
+            else fill(top, top + n, value);
+        };
+        auto binary = [&](auto op) {
+            V* a = top - kBatchBlock;
+            for (size_t i = 0; i < n; ++i) a[i] = op(a[i], top[i]);
+            top = a;
+        };
+        auto unary = [&](auto fn) {
+            for (size_t i = 0; i < n; ++i) top[i] = fn(top[i]);
+        };
+        auto select = [&]() {
+            V* c = top - 2 * kBatchBlock;
+            const V* a = top - kBatchBlock;
+            for (size_t i = 0; i < n; ++i) c[i] = real(c[i]) != 0 ? a[i] : top[i];
+            top = c;
+        };
+
+        for (const Instruction& ins : program) {
+            switch (ins.op) {
+            case OpCode::PushX: push(x_values, V(0)); break;
+            case OpCode::PushY: push(y_values, V(0)); break;
+            case OpCode::PushConst: push(nullptr, V(ins.value)); break;
+            case OpCode::PushParam: push(param_values[ins.index], V(0)); break;
+
+            case OpCode::Add: binary([](const V& a, const V& b) { return a + b; }); break;
+            case OpCode::Sub: binary([](const V& a, const V& b) { return a - b; }); break;
+            case OpCode::Mul: binary([](const V& a, const V& b) { return a * b; }); break;
+            case OpCode::Div: binary([](const V& a, const V& b) { return a / b; }); break;
+            case OpCode::Pow: binary([](const V& a, const V& b) { return pow(a, b); }); break;
+
+            case OpCode::Sin: unary([](const V& a) { return sin(a); }); break;
+            case OpCode::Cos: unary([](const V& a) { return cos(a); }); break;
+            case OpCode::Tan: unary([](const V& a) { return tan(a); }); break;
+            case OpCode::Asin: unary([](const V& a) { return asin(a); }); break;
+            case OpCode::Acos: unary([](const V& a) { return acos(a); }); break;
+            case OpCode::Atan: unary([](const V& a) { return atan(a); }); break;
+            case OpCode::Sinh: unary([](const V& a) { return sinh(a); }); break;
+            case OpCode::Cosh: unary([](const V& a) { return cosh(a); }); break;
+            case OpCode::Tanh: unary([](const V& a) { return tanh(a); }); break;
+            case OpCode::Sqrt: unary([](const V& a) { return sqrt(a); }); break;
+            case OpCode::Exp: unary([](const V& a) { return exp(a); }); break;
+            case OpCode::Ln: unary([](const V& a) { return log(a); }); break;
+            case OpCode::Log: unary([](const V& a) { return log10(a); }); break;
+
+            case OpCode::Abs: unary([](const V& a) { return fabs(a); }); break;
+            case OpCode::Floor: unary([](const V& a) { return floor(a); }); break;
+            case OpCode::Ceil: unary([](const V& a) { return ceil(a); }); break;
+            case OpCode::Min: binary([](const V& a, const V& b) { return real(b) < real(a) ? b : a; }); break;
+            case OpCode::Max: binary([](const V& a, const V& b) { return real(b) > real(a) ? b : a; }); break;
+
+            case OpCode::Less: binary([](const V& a, const V& b) { return truth<V>(real(a) < real(b)); }); break;
+            case OpCode::LessEqual: binary([](const V& a, const V& b) { return truth<V>(real(a) <= real(b)); }); break;
+            case OpCode::Greater: binary([](const V& a, const V& b) { return truth<V>(real(a) > real(b)); }); break;
+            case OpCode::GreaterEqual: binary([](const V& a, const V& b) { return truth<V>(real(a) >= real(b)); }); break;
+            case OpCode::Equal: binary([](const V& a, const V& b) { return truth<V>(real(a) == real(b)); }); break;
+            case OpCode::NotEqual: binary([](const V& a, const V& b) { return truth<V>(real(a) != real(b)); }); break;
+            case OpCode::Select: select(); break;
             }
-            op_stack.push(token);
         }
-    }
 
-    while (!op_stack.empty()) {
-        if (op_stack.top() == "(") throw runtime_error("Mismatched parentheses");
-        postfix.push_back(op_stack.top());
-        op_stack.pop();
+        copy(top, top + n, out + start);
     }
 }
 
-// Evaluate the postfix expression
-double EquationParser::evaluate(double x_value) {
-    bool has_x = false, has_y = false;
-    for (const auto& token : postfix) {
-        if (token == "x") has_x = true;
-        if (token == "y") has_y = true;
-    }
+// Evaluate the equation for a single variable (x, or y if only y is used)
+double EquationParser::evaluate(double x_value) const {
+    return evaluate(x_value, parameter_values.data());
+}
 
-    if (!allow_xy && has_x && has_y) {
+// Evaluate the equation with both x and y values
+double EquationParser::evaluate(double x_value, double y_value) const {
+    return evaluate(x_value, y_value, parameter_values.data());
+}
+
+double EquationParser::evaluate(double x_value, const double* param_values) const {
+    if (!allow_xy && uses_x && uses_y) {
         throw runtime_error("This equation requires either x or y, not both.");
-    } else if (has_x) {
-        return evaluate(x_value, 0);
-    } else if (has_y) {
-        return evaluate(0, x_value);
+    } else if (uses_y && !uses_x) {
+        return evaluate(0, x_value, param_values);
     } else {
-        return evaluate(0, 0);
+        return evaluate(x_value, 0, param_values);
     }
 }
 
-// Evaluate the equation with both x and y values
-double EquationParser::evaluate(double x_value, double y_value) {
-    stack<double> val_stack;
+double EquationParser::evaluate(double x_value, double y_value, const double* param_values) const {
+    NUMERICAL_TIMED("parser.evaluate");
+    if (program.empty()) throw runtime_error("Invalid expression");
+    return run<double>(x_value, y_value, param_values);
+}
 
-    for (const auto& token : postfix) {
-        if (token == "x") {
-            val_stack.push(x_value);
-        }
-        else if (token == "y") {
-            val_stack.push(y_value);
-        }
-        else if (isdigit(token[0]) || (token[0] == '-' && token.size() > 1 && isdigit(token[1]))) {
-            val_stack.push(stod(token));
-        }
-        else if (isConstant(token)) {
-            val_stack.push(constants.at(token));
-        }
-        else if (isOperator(token[0])) {
-            if (val_stack.size() < 2) throw runtime_error("Not enough operands");
-
-            double b = val_stack.top(); val_stack.pop();
-            double a = val_stack.top(); val_stack.pop();
-
-            switch (token[0]) {
-            case '+': val_stack.push(a + b); break;
-            case '-': val_stack.push(a - b); break;
-            case '*': val_stack.push(a * b); break;
-            case '/':
-                if (b == 0) throw runtime_error("Division by zero");
-                val_stack.push(a / b);
-                break;
-            case '^': val_stack.push(pow(a, b)); break;
-            }
-        }
-        else if (isFunction(token)) {
-            if (val_stack.empty()) throw runtime_error("Not enough operands");
-
-            double a = val_stack.top(); val_stack.pop();
-
-            if (token == "sin") val_stack.push(sin(a));
-            else if (token == "cos") val_stack.push(cos(a));
-            else if (token == "tan") val_stack.push(tan(a));
-            else if (token == "asin") val_stack.push(asin(a));
-            else if (token == "acos") val_stack.push(acos(a));
-            else if (token == "atan") val_stack.push(atan(a));
-            else if (token == "sinh") val_stack.push(sinh(a));
-            else if (token == "cosh") val_stack.push(cosh(a));
-            else if (token == "tanh") val_stack.push(tanh(a));
-            else if (token == "sqrt") {
-                if (a < 0) throw runtime_error("Square root of negative number");
-                val_stack.push(sqrt(a));
-            }
-            else if (token == "exp") val_stack.push(exp(a));
-            else if (token == "ln") {
-                if (a <= 0) throw runtime_error("Logarithm of non-positive number");
-                val_stack.push(log(a));
-            }
-            else if (token == "log") {
-                if (a <= 0) throw runtime_error("Logarithm of non-positive number");
-                val_stack.push(log10(a));
-            }
-        }
+template <typename T>
+T EquationParser::evaluateAs(const T& x_value) const {
+    if (!allow_xy && uses_x && uses_y)
+        throw runtime_error("This equation requires either x or y, not both.");
+    if (uses_y && !uses_x) return evaluateAs<T>(T(0), x_value);
+    return evaluateAs<T>(x_value, T(0));
+}
+
+template <typename T>
+T EquationParser::evaluateAs(const T& x_value, const T& y_value, const T* param_values) const {
+    if (program.empty()) throw runtime_error("Invalid expression");
+
+    vector<T> params;
+    if (!param_values) {
+        params.assign(parameter_values.begin(), parameter_values.end());
+        param_values = params.data();
     }
 
-    if (val_stack.size() != 1) throw runtime_error("Invalid expression");
-    return val_stack.top();
+    vector<T> literals = literalsAs<T>();
+    return run<T>(x_value, y_value, param_values, literals.data());
+}
+
+template <typename T>
+void EquationParser::evaluateBatchAs(const T* x_values, T* out, size_t count) const {
+    if (program.empty()) throw runtime_error("Invalid expression");
+    if (!allow_xy && uses_x && uses_y)
+        throw runtime_error("This equation requires either x or y, not both.");
+
+    vector<T> params(parameter_values.begin(), parameter_values.end());
+    vector<T> literals = literalsAs<T>();
+    bool only_y = uses_y && !uses_x;
+    for (size_t i = 0; i < count; ++i)
+        out[i] = only_y ? run<T>(T(0), x_values[i], params.data(), literals.data())
+                        : run<T>(x_values[i], T(0), params.data(), literals.data());
+}
+
+// The program's literals in T: long double ones are read once in compile(),
+// other types read the text here
+template <typename T>
+vector<T> EquationParser::literalsAs() const {
+    const T* stored = storedLiterals<T>(wide_literals);
+    if (stored) return vector<T>(stored, stored + wide_literals.size());
+    vector<T> literals;
+    for (const auto& text : literal_text) literals.push_back(ScalarTraits<T>::parse(text));
+    return literals;
+}
+
+template long double EquationParser::evaluateAs<long double>(const long double&) const;
+template long double EquationParser::evaluateAs<long double>(const long double&, const long double&,
+                                                             const long double*) const;
+template void EquationParser::evaluateBatchAs<long double>(const long double*, long double*, size_t) const;
+#ifdef NUMERICAL_FLOAT128
+template __float128 EquationParser::evaluateAs<__float128>(const __float128&) const;
+template __float128 EquationParser::evaluateAs<__float128>(const __float128&, const __float128&,
+                                                           const __float128*) const;
+template void EquationParser::evaluateBatchAs<__float128>(const __float128*, __float128*, size_t) const;
+#endif
+
+template Interval EquationParser::evaluateAs<Interval>(const Interval&) const;
+template Interval EquationParser::evaluateAs<Interval>(const Interval&, const Interval&, const Interval*) const;
+
+Interval EquationParser::evaluateInterval(const Interval& x_value) const {
+    NUMERICAL_TIMED("parser.evaluate_interval");
+    return evaluateAs<Interval>(x_value);
+}
+
+Interval EquationParser::evaluateIntervalDerivative(const Interval& x_value, Interval& derivative) const {
+    NUMERICAL_TIMED("parser.evaluate_interval_derivative");
+    if (program.empty()) throw runtime_error("Invalid expression");
+    if (!allow_xy && uses_x && uses_y)
+        throw runtime_error("This equation requires either x or y, not both.");
+
+    vector<Dual<Interval>> params;
+    for (double p : parameter_values) params.push_back(Dual<Interval>(Interval(p)));
+    vector<Dual<Interval>> literals = literalsAs<Dual<Interval>>();
+    Dual<Interval> seed(x_value, Interval(1)), zero;
+    Dual<Interval> result = (uses_y && !uses_x) ? run(zero, seed, params.data(), literals.data())
+                                                : run(seed, zero, params.data(), literals.data());
+    derivative = result.d;
+    return result.v;
+}
+
+bool EquationParser::isSmooth() const {
+    // Abs .. Select are the last opcodes
+    for (const auto& ins : program)
+        if (ins.op >= OpCode::Abs) return false;
+    return true;
+}
+
+double EquationParser::evaluateDerivative(double x_value, double& derivative) const {
+    return evaluateDerivative(x_value, parameter_values.data(), derivative);
+}
+
+double EquationParser::evaluateDerivative(double x_value, const double* param_values, double& derivative) const {
+    NUMERICAL_TIMED("parser.evaluate_derivative");
+    if (program.empty()) throw runtime_error("Invalid expression");
+    if (!allow_xy && uses_x && uses_y)
+        throw runtime_error("This equation requires either x or y, not both.");
+
+    vector<Dual<double>> params(param_values, param_values + parameter_names.size());
+    Dual<double> seed(x_value, 1.0), zero;
+    Dual<double> result = (uses_y && !uses_x) ? run(zero, seed, params.data()) : run(seed, zero, params.data());
+    derivative = result.d;
+    return result.v;
+}
+
+void EquationParser::evaluateBatch(const double* x_values, double* out, size_t count) const {
+    vector<vector<double>> defaults;
+    vector<const double*> params = broadcast(parameter_values, count, defaults);
+    evaluateBatch(x_values, params.data(), out, count);
+}
+
+void EquationParser::evaluateBatch(const double* x_values, const double* const* param_values,
+                                   double* out, size_t count) const {
+    NUMERICAL_TIMED("parser.evaluate_batch");
+    NUMERICAL_COUNT("parser.batch_points", count);
+    if (program.empty()) throw runtime_error("Invalid expression");
+    if (!allow_xy && uses_x && uses_y)
+        throw runtime_error("This equation requires either x or y, not both.");
+
+    if (uses_y && !uses_x) runBatch<double>(nullptr, x_values, param_values, out, count);
+    else runBatch<double>(x_values, nullptr, param_values, out, count);
+}
+
+void EquationParser::evaluateBatch(const double* x_values, const double* y_values,
+                                   double* out, size_t count) const {
+    NUMERICAL_TIMED("parser.evaluate_batch");
+    NUMERICAL_COUNT("parser.batch_points", count);
+    if (program.empty()) throw runtime_error("Invalid expression");
+
+    vector<vector<double>> defaults;
+    vector<const double*> params = broadcast(parameter_values, count, defaults);
+    runBatch<double>(x_values, y_values, params.data(), out, count);
+}
+
+void EquationParser::evaluateBatch(const double* x_values, const double* y_values,
+                                   const double* const* param_values, double* out, size_t count) const {
+    NUMERICAL_TIMED("parser.evaluate_batch");
+    NUMERICAL_COUNT("parser.batch_points", count);
+    if (program.empty()) throw runtime_error("Invalid expression");
+    runBatch<double>(x_values, y_values, param_values, out, count);
+}
+
+void EquationParser::evaluateDerivativeBatch(const double* x_values, double* out,
+                                             double* derivatives, size_t count) const {
+    vector<vector<double>> defaults;
+    vector<const double*> params = broadcast(parameter_values, count, defaults);
+    evaluateDerivativeBatch(x_values, params.data(), out, derivatives, count);
+}
+
+void EquationParser::evaluateDerivativeBatch(const double* x_values, const double* const* param_values,
+                                             double* out, double* derivatives, size_t count) const {
+    NUMERICAL_TIMED("parser.evaluate_derivative_batch");
+    NUMERICAL_COUNT("parser.batch_points", count);
+    if (program.empty()) throw runtime_error("Invalid expression");
+    if (!allow_xy && uses_x && uses_y)
+        throw runtime_error("This equation requires either x or y, not both.");
+
+    size_t np = parameter_names.size();
+    vector<Dual<double>> seeds(count), results(count);
+    vector<vector<Dual<double>>> params(np, vector<Dual<double>>(count));
+    vector<const Dual<double>*> param_rows(np);
+    for (size_t i = 0; i < count; ++i) seeds[i] = Dual<double>(x_values[i], 1.0);
+    for (size_t k = 0; k < np; ++k) {
+        for (size_t i = 0; i < count; ++i) params[k][i] = Dual<double>(param_values[k][i]);
+        param_rows[k] = params[k].data();
+    }
+
+    if (uses_y && !uses_x) runBatch<Dual<double>>(nullptr, seeds.data(), param_rows.data(), results.data(), count);
+    else runBatch<Dual<double>>(seeds.data(), nullptr, param_rows.data(), results.data(), count);
+
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = results[i].v;
+        derivatives[i] = results[i].d;
+    }
+}
+
+// One forward-mode pass per variable the program actually reads
+double EquationParser::evaluateGradient(double x_value, double y_value, const double* param_values,
+                                        double* gradient) const {
+    if (program.empty()) throw runtime_error("Invalid expression");
+
+    size_t np = parameter_names.size();
+    vector<char> used(np, 0);
+    for (const auto& ins : program)
+        if (ins.op == OpCode::PushParam) used[ins.index] = 1;
+
+    vector<Dual<double>> params(param_values, param_values + np);
+    Dual<double> x(x_value), y(y_value);
+    for (size_t k = 0; k < np + 2; ++k) gradient[k] = 0;
+
+    double value = run<double>(x_value, y_value, param_values);
+    if (uses_x) gradient[0] = run(Dual<double>(x_value, 1.0), y, params.data()).d;
+    if (uses_y) gradient[1] = run(x, Dual<double>(y_value, 1.0), params.data()).d;
+    for (size_t k = 0; k < np; ++k) {
+        if (!used[k]) continue;
+        params[k].d = 1.0;
+        gradient[2 + k] = run(x, y, params.data()).d;
+        params[k].d = 0.0;
+    }
+    return value;
 }
 
 // Print the postfix expression for debugging
 void EquationParser::printPostfix() {
+    convertToPostfix();
     cout << "Postfix notation: ";
     for (const auto& token : postfix) {
         cout << token << " ";
@@ -1,5 +1,6 @@
 #include "secant.h"
-#include "parser.h"
+#include "ExpressionCache.h"
+#include "Instrumentation.h"
 #include <iostream>
 #include <cmath>
 
@@ -12,6 +13,9 @@ SecantSolver::SecantSolver()   {
 
 }
 
+SecantSolver::SecantSolver(const string& expression, double first, double second, double tolerance, int iterations)
+    : expr(expression), x0(first), x1(second), tol(tolerance), maxIter(iterations) {}
+
 void SecantSolver::get_input()
 {
     cout << "Enter function f(x): ";
@@ -30,33 +34,31 @@ void SecantSolver::get_input()
     cin >> maxIter;
 }
 
-double SecantSolver::solve() {
-
-    EquationParser Parser;  
+double SecantSolver::solve(bool verbose) {
+    NUMERICAL_SOLVER(telemetry, "solver.secant");
 
-    Parser.parseEquation(expr);
-    double f0 = Parser.evaluate(x0);
+    auto Parser = compileExpression(expr);
 
-    Parser.parseEquation(expr);
-    double f1 = Parser.evaluate(x1);
+    double f0 = Parser->evaluate(x0);
+    double f1 = Parser->evaluate(x1);
 
-    double x2;
+    double x2 = x1;
 
     for (int i = 0; i < maxIter; ++i) {
         if (fabs(f1 - f0) < 1e-12) {
-            cout << "Division by zero error in secant method." << endl;
+            if (verbose) cout << "Division by zero error in secant method." << endl;
             return x1;
         }
 
         x2 = x1 - f1 * (x1 - x0) / (f1 - f0);
         
-        Parser.parseEquation(expr);
-        double f2 = Parser.evaluate(x2);
+        double f2 = Parser->evaluate(x2);
+        NUMERICAL_CONVERGENCE(telemetry, i + 1, x2, fabs(f2), fabs(x2 - x1));
 
-        cout << "Iteration " << i + 1 << ": x = " << x2 << ", f(x) = " << f2 << endl;
+        if (verbose) cout << "Iteration " << i + 1 << ": x = " << x2 << ", f(x) = " << f2 << endl;
 
         if (fabs(x2 - x1) < tol) {
-            cout << "Converged to root: " << x2 << endl;
+            if (verbose) cout << "Converged to root: " << x2 << endl;
             return x2;
         }
 
@@ -66,6 +68,6 @@ double SecantSolver::solve() {
         f1 = f2;
     }
 
-    cout << "Did not converge within the maximum number of iterations. Last approximation: " << x2 << endl;
+    if (verbose) cout << "Did not converge within the maximum number of iterations. Last approximation: " << x2 << endl;
     return x2;
 }
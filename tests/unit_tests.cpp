@@ -0,0 +1,647 @@
+// Known-value checks for every kernel: each test computes something with a
+// closed-form or exactly reproducible answer and compares. Run by ctest, or
+// directly: unit_tests [name-substring]
+//
+// Build: cmake -S . -B build && cmake --build build --target unit_tests
+#include "BatchRootSolver.h"
+#include "BracketedSolvers.h"
+#include "DataSource.h"
+#include "DoubleExponential.h"
+#include "EulerMethods.h"
+#include "ExpressionCache.h"
+#include "ExtendedPrecision.h"
+#include "Interval.h"
+#include "IntervalRootIsolator.h"
+#include "LagrangeInterpolator.h"
+#include "NonlinearSystem.h"
+#include "PolynomialFitter.h"
+#include "PolynomialRoots.h"
+#include "ResultCache.h"
+#include "RootScanner.h"
+#include "SavitzkyGolay.h"
+#include "SolverServer.h"
+#include "StreamingPolynomialFitter.h"
+#include "SurfaceFitter.h"
+#include "integration.h"
+#include "parser.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+using namespace std;
+
+namespace {
+
+int failures = 0;
+
+void fail(const char* file, int line, const string& what) {
+    printf("  FAILED %s:%d: %s\n", file, line, what.c_str());
+    ++failures;
+}
+
+#define CHECK(cond) \
+    do { if (!(cond)) fail(__FILE__, __LINE__, #cond); } while (0)
+
+#define CHECK_NEAR(actual, expected, tol) \
+    do { \
+        double a_ = (actual), e_ = (expected); \
+        if (!(fabs(a_ - e_) <= (tol))) \
+            fail(__FILE__, __LINE__, string(#actual) + " = " + to_string(a_) + ", expected " + to_string(e_)); \
+    } while (0)
+
+#define CHECK_THROWS(expr) \
+    do { \
+        bool thrown_ = false; \
+        try { expr; } catch (const exception&) { thrown_ = true; } \
+        if (!thrown_) fail(__FILE__, __LINE__, string(#expr) + " did not throw"); \
+    } while (0)
+
+const double kPi = 3.14159265358979323846;
+const double kSqrt2 = 1.41421356237309504880;
+
+string temporaryPath(const string& name) {
+    return (filesystem::temp_directory_path() / ("numerical_unit_" + name)).string();
+}
+
+// ---- interpolation ----
+
+void inverseInterpolation() {
+    LagrangeInterpolator squares({0, 1, 2, 3, 4}, {0, 1, 4, 9, 16});
+    CHECK_NEAR(squares.interpolateX(4), 2, 1e-12);
+    CHECK_NEAR(squares.interpolateY(2.5), 6.25, 1e-12);
+    CHECK_THROWS(squares.interpolateX(20));
+
+    // y turns at x = 1: every level below the peak has one preimage on each side
+    LagrangeInterpolator hill({0, 1, 2, 3, 4}, {0, 1, 0, -1, 0});
+    vector<double> both = hill.interpolateXAll(0.5);
+    CHECK(both.size() == 2);
+    if (both.size() == 2) CHECK(both[0] < 1 && both[1] > 1);
+
+    // forward interpolation needs no invertible data
+    LagrangeInterpolator single({1.0}, {2.0});
+    CHECK_NEAR(single.interpolateY(5), 2, 0);
+    CHECK_THROWS(single.interpolateX(2));
+}
+
+// ---- fitting ----
+
+vector<double> cubic(const vector<double>& x) {
+    vector<double> y;
+    for (double v : x) y.push_back(1 - 2 * v + 0.5 * v * v + 3 * v * v * v);
+    return y;
+}
+
+vector<double> linspace(double a, double b, int n) {
+    vector<double> x(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) x[size_t(i)] = a + (b - a) * i / (n - 1);
+    return x;
+}
+
+void polynomialFit() {
+    vector<double> x = linspace(-2, 3, 50), y = cubic(x);
+    PolynomialFitter fitter(x, y, 3);
+    fitter.fit();
+    const vector<double>& a = fitter.coefficients();
+    CHECK_NEAR(a[0], 1, 1e-9);
+    CHECK_NEAR(a[1], -2, 1e-9);
+    CHECK_NEAR(a[2], 0.5, 1e-9);
+    CHECK_NEAR(a[3], 3, 1e-9);
+    CHECK_NEAR(fitter.residualNorm(), 0, 1e-9);
+    CHECK_NEAR(fitter.evaluate(1.5), 1 - 3 + 1.125 + 10.125, 1e-9);
+    CHECK_THROWS(PolynomialFitter({1, 2}, {1, 2}, 2));
+}
+
+void streamingFit() {
+    vector<double> x = linspace(0, 10, 1000), y = cubic(x);
+    StreamingPolynomialFitter whole(3, 0, 10), first(3, 0, 10), second(3, 0, 10);
+    whole.add(x.data(), y.data(), x.size());
+    first.add(x.data(), y.data(), 400);
+    second.add(x.data() + 400, y.data() + 400, 600);
+    first.merge(second);
+    CHECK(first.count() == 1000);
+    vector<double> a = whole.coefficients(), b = first.coefficients();
+    for (size_t k = 0; k < a.size(); ++k) CHECK_NEAR(b[k], a[k], 1e-8);
+    CHECK_NEAR(a[3], 3, 1e-8);
+}
+
+void robustAndSurfaceFit() {
+    // y = 2x + 1 with one wild point: the robust fit ignores it
+    vector<double> x = linspace(0, 9, 10), y;
+    for (double v : x) y.push_back(2 * v + 1);
+    y[5] = 100;
+    PolynomialFitter fitter(x, y, 1);
+    fitter.fitRobust(RobustLoss::Tukey);
+    CHECK_NEAR(fitter.coefficients()[1], 2, 1e-6);
+    CHECK_NEAR(fitter.coefficients()[0], 1, 1e-6);
+    CHECK(fitter.robustWeights()[5] < 1e-3);
+
+    // z = 1 + 2x + 3y exactly
+    vector<double> sx, sy, sz;
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 5; ++j) {
+            sx.push_back(i);
+            sy.push_back(j);
+            sz.push_back(1 + 2 * i + 3 * j);
+        }
+    SurfaceFitter surface(sx, sy, sz, 1);
+    CHECK_THROWS(surface.evaluate(0.5, 0.5));
+    CHECK_THROWS(surface.coefficients());
+    surface.fit();
+    CHECK_NEAR(surface.evaluate(0.5, 0.5), 3.5, 1e-9);
+}
+
+// ---- roots ----
+
+const double kCubicRoot = 2.0945514815423265;   // x^3 - 2x - 5
+
+void bracketedRoots() {
+    CHECK_NEAR(brentRoot("x^3 - 2*x - 5", 2, 3).root, kCubicRoot, 1e-12);
+    CHECK_NEAR(itpRoot("x^3 - 2*x - 5", 2, 3).root, kCubicRoot, 1e-12);
+    CHECK_NEAR(bisectionRoot("x^3 - 2*x - 5", 2, 3).root, kCubicRoot, 1e-12);
+    RootResult r = brentRoot("cos(x) - x", 0, 1);
+    CHECK(r.converged);
+    CHECK_NEAR(r.root, 0.7390851332151607, 1e-12);
+    CHECK_THROWS(brentRoot("x^2 + 1", -1, 1));
+}
+
+void rootScan() {
+    vector<double> roots = findAllRoots("sin(x)", -10, 10);
+    CHECK(roots.size() == 7);
+    for (size_t i = 0; i < roots.size(); ++i) CHECK_NEAR(roots[i], (double(i) - 3) * kPi, 1e-10);
+
+    // a touching root, and a pole that changes sign but is no root
+    vector<double> touching = findAllRoots("(x - 1)^2 * (x + 2)", -3, 3);
+    CHECK(touching.size() == 2);
+    if (touching.size() == 2) CHECK_NEAR(touching[1], 1, 1e-6);
+    vector<double> tangent = findAllRoots("tan(x)", 0.1, 4);
+    CHECK(tangent.size() == 1);
+    if (tangent.size() == 1) CHECK_NEAR(tangent[0], kPi, 1e-10);
+
+    // undefined stretches inside a bracket drop it instead of aborting
+    RootScanOptions threaded;
+    threaded.threads = 4;
+    CHECK(findAllRoots("sin(10*x)*sqrt(sin(10*x)^2-0.00000001)", -1.00037, 1.0003, threaded).empty());
+}
+
+void batchRoots() {
+    EquationParser parser;
+    parser.setParameters({"k"});
+    parser.parseEquation("x^2 - k");
+    vector<double> k = {2, 3, 4, 9};
+    BatchRootOptions options;
+    options.method = BatchMethod::Newton;
+    BatchRootResult result = solveBatch(parser, vector<double>(k.size(), 1.0), vector<double>(k.size(), 5.0), {k},
+                                        options);
+    for (size_t i = 0; i < k.size(); ++i) {
+        CHECK(result.converged[i]);
+        CHECK_NEAR(result.roots[i], sqrt(k[i]), 1e-10);
+    }
+}
+
+void polynomialRootFinding() {
+    vector<double> roots = realPolynomialRoots({2, -3, 1});   // (x - 1)(x - 2)
+    CHECK(roots.size() == 2);
+    if (roots.size() == 2) {
+        CHECK_NEAR(roots[0], 1, 1e-12);
+        CHECK_NEAR(roots[1], 2, 1e-12);
+    }
+    CHECK(realPolynomialRoots({1, 0, 1}).empty());   // x^2 + 1
+    vector<double> extrema = polynomialExtrema({0, -3, 0, 1});   // x^3 - 3x
+    CHECK(extrema.size() == 2);
+    if (extrema.size() == 2) CHECK_NEAR(extrema[1], 1, 1e-12);
+}
+
+void nonlinearSystem() {
+    NonlinearSystem circle({"x^2 + y^2 - 4", "x - y"}, {"x", "y"});
+    for (SystemMethod method : {SystemMethod::Newton, SystemMethod::Broyden}) {
+        SystemOptions options;
+        options.method = method;
+        SystemResult result = circle.solve({1, 0.5}, options);
+        CHECK(result.converged);
+        CHECK_NEAR(result.solution[0], kSqrt2, 1e-10);
+        CHECK_NEAR(result.solution[1], kSqrt2, 1e-10);
+    }
+}
+
+// ---- expressions ----
+
+void parserPrecedence() {
+    auto value = [](const string& expr, double x = 0) {
+        EquationParser parser;
+        parser.parseEquation(expr);
+        return parser.evaluate(x);
+    };
+    CHECK_NEAR(value("2 + 3 * 4 ^ 2"), 50, 0);
+    CHECK_NEAR(value("2 ^ 3 ^ 2"), 64, 0);        // left associative
+    CHECK_NEAR(value("-2 ^ 2"), -4, 0);
+    CHECK_NEAR(value("2 * -3"), -6, 0);
+    CHECK_NEAR(value("x^-1", 4), 0.25, 0);
+    CHECK_NEAR(value("1 < 2 ? 3 : 4"), 3, 0);
+    CHECK_NEAR(value("x == 1 ? 10 : x <= 0 ? 20 : 30", 2), 30, 0);
+    CHECK_NEAR(value("max(x, 2) + min(x, 2) + abs(-3)", 1), 6, 0);
+    CHECK_NEAR(value("log(100) + ln(e)"), 3, 1e-15);
+    CHECK_NEAR(value(".5 + 1e-1"), 0.6, 1e-15);
+
+    try {
+        value("x +  * 2");
+        fail(__FILE__, __LINE__, "\"x +  * 2\" parsed");
+    } catch (const ParseError& e) {
+        CHECK(e.position() == 5);
+    }
+    CHECK_THROWS(value("x < = 1"));
+    CHECK_THROWS(value("(x + 1"));
+}
+
+void expressionCache() {
+    ExpressionCache cache(4);
+    auto first = cache.get("x * x + 1");
+    auto second = cache.get("x*x+1");
+    CHECK(first == second);
+    CHECK(cache.stats().hits == 1);
+    CHECK_NEAR(first->evaluate(3), 10, 0);
+    // the caller's text is parsed, so blanks that change the tokens still fail
+    CHECK_THROWS(cache.get("x < = 1"));
+    CHECK_THROWS(cache.get("1e -5"));
+    CHECK(ExpressionCache::normalize("x < = 1") != ExpressionCache::normalize("x <= 1"));
+    for (int i = 0; i < 6; ++i) cache.get("x + " + to_string(i));
+    CHECK(cache.stats().size == 4);
+    CHECK(cache.stats().evictions > 0);
+}
+
+void extendedPrecision() {
+    EquationParser parser;
+    parser.parseEquation("x^2");
+    long double third = integrateExpression<long double>(parser, 0.0L, 1.0L, 101, IntegrationRule::Simpson13);
+    CHECK_NEAR(double(fabsl(third - 1.0L / 3)), 0, 1e-17);
+    CHECK(parser.evaluateAs<long double>(0.1L) == 0.1L * 0.1L);
+    CHECK_NEAR(double(lagrangeValue<long double>({0, 1, 2}, {0, 1, 4}, 1.5L)), 2.25, 1e-18);
+
+    // 1 - 2x + 0.5x^2 + 3x^3 back from its Newton form and from a fit
+    vector<long double> x = {-2, -1, 0, 1, 2, 3}, y;
+    for (long double v : x) y.push_back(1 - 2 * v + 0.5L * v * v + 3 * v * v * v);
+    long double expected[] = {1, -2, 0.5L, 3};
+    vector<long double> newton = NewtonInterpolant<long double>(x, y).coefficients();
+    PrecisePolynomialFitter<long double> fitter(x, y, 3);
+    fitter.fit();
+    for (int k = 0; k < 4; ++k) {
+        CHECK_NEAR(double(newton[size_t(k)] - expected[k]), 0, 1e-15);
+        CHECK_NEAR(double(fitter.coefficients()[size_t(k)] - expected[k]), 0, 1e-15);
+    }
+    CHECK_THROWS(NewtonInterpolant<long double>({1, 1}, {0, 1}));
+}
+
+void intervals() {
+    Interval product = Interval(1, 2) * Interval(-1, 3);
+    CHECK(product.lo == -2 && product.hi == 6);
+    CHECK(sqrt(Interval(4, 9)).contains(Interval(2, 3)));
+
+    IsolationResult isolated = isolateRoots("x^2 - 2", -2, 2);
+    CHECK(isolated.complete);
+    CHECK(isolated.certifiedRoots == 2);
+    if (isolated.enclosures.size() == 2) {
+        CHECK(isolated.enclosures[0].lo <= -kSqrt2 && -kSqrt2 <= isolated.enclosures[0].hi);
+        CHECK(isolated.enclosures[1].lo <= kSqrt2 && kSqrt2 <= isolated.enclosures[1].hi);
+    }
+    CHECK(isolateRoots("x^2 + 1", -5, 5).enclosures.empty());
+
+    EquationParser parser;
+    parser.parseEquation("x^2");
+    CHECK(integralEnclosure(parser, 0, 1).contains(1.0 / 3));
+    CHECK(rangeEnclosure(parser, -1, 2).contains(Interval(0, 4)));
+}
+
+// ---- integration ----
+
+void integrationRules() {
+    NumericalIntegrator three("x^2", 0, 1, 3);
+    CHECK_NEAR(three.trapezoidalRule(), 0.375, 1e-15);
+    CHECK_NEAR(three.simpsons13Rule(), 1.0 / 3, 1e-15);
+    NumericalIntegrator four("x^3", 0, 3, 4);
+    CHECK_NEAR(four.simpsons38Rule(), 81.0 / 4, 1e-12);
+    CHECK_THROWS(NumericalIntegrator("x", 1, 0, 3));
+}
+
+void doubleExponential() {
+    CHECK_NEAR(integrateDoubleExponential("exp(-x^2)", -HUGE_VAL, HUGE_VAL).value, sqrt(kPi), 1e-10);
+    CHECK_NEAR(integrateDoubleExponential("1/sqrt(x)", 0, 1).value, 2, 1e-8);
+    CHECK_NEAR(integrateDoubleExponential("exp(-x)", 0, HUGE_VAL).value, 1, 1e-10);
+    CHECK_NEAR(integrateDoubleExponential("sin(x)", 0, kPi).value, 2, 1e-12);
+    // 0/0 next to 0 and inf/inf far out, both in decayed tails
+    CHECK_NEAR(integrateDoubleExponential("x^3/(exp(x)-1)", 0, HUGE_VAL).value, pow(kPi, 4) / 15, 1e-12);
+    try {
+        integrateDoubleExponential("1/x", -1, 1);
+        fail(__FILE__, __LINE__, "1/x over [-1, 1] integrated");
+    } catch (const domain_error& e) {
+        CHECK(string(e.what()) == "Integrand is not finite at x = 0");
+    }
+}
+
+// ---- ODEs ----
+
+void eulerEnsemble() {
+    BasicEuler basic;
+    ModifiedEuler modified;
+    // y' = y from y(0) = 1 with 100 steps of 0.01: (1 + h)^100 exactly
+    CHECK_NEAR(basic.integrate("y", 0, 1, 0.01, 100), pow(1.01, 100), 1e-12);
+    CHECK_NEAR(modified.integrate("y", 0, 1, 0.01, 100), exp(1.0), 1e-4);
+
+    vector<double> y0 = {1, 2, -0.5};
+    EnsembleResult ensemble = modified.integrateEnsemble("x + y", 0, y0, 0.01, 50);
+    for (size_t i = 0; i < y0.size(); ++i)
+        CHECK(ensemble.finalY[i] == modified.integrate("x + y", 0, y0[i], 0.01, 50));
+    // where integrate() throws for a domain error, so does the ensemble
+    CHECK_THROWS(basic.integrate("sqrt(y)", 0, -1, 0.1, 3));
+    try {
+        basic.integrateEnsemble("sqrt(y)", 0, {1, -1, 4, -2}, 0.1, 3);
+        fail(__FILE__, __LINE__, "the ensemble ignored a domain error");
+    } catch (const runtime_error& e) {
+        CHECK(string(e.what()).find("Trajectory 1 ") == 0);
+    }
+}
+
+// ---- data and smoothing ----
+
+void dataSources() {
+    string binary = temporaryPath("columns.bin");
+    {
+        double rows[] = {1, 10, 2, 20, 3, 30};
+        ofstream out(binary, ios::binary);
+        out.write(reinterpret_cast<const char*>(rows), sizeof rows);
+    }
+    {
+        ColumnFile file(binary, 2);
+        CHECK(file.rows() == 3);
+        ColumnView second = file.column(1);
+        CHECK(second.size() == 3 && second[2] == 30);
+    }
+    filesystem::remove(binary);
+
+    string csv = temporaryPath("table.csv");
+    {
+        ofstream out(csv);
+        out << "x,y\n0,1\n1,3\n2,5\n";
+    }
+    {
+        CsvTable table(csv);
+        CHECK(table.rows() == 3);
+        CHECK(table.column("y")[2] == 5);
+        PolynomialFitter line(table.column("x"), table.column("y"), 1);
+        line.fit();
+        CHECK_NEAR(line.coefficients()[1], 2, 1e-12);
+    }
+    filesystem::remove(csv);
+}
+
+void savitzkyGolay() {
+    // a quadratic filter reproduces a quadratic, edges included
+    vector<double> x = linspace(0, 9.9, 100), y;
+    for (double v : x) y.push_back(3 - v + 0.25 * v * v);
+    vector<double> smoothed = SavitzkyGolayFilter(5, 2).apply(y);
+    for (size_t i = 0; i < y.size(); ++i) CHECK_NEAR(smoothed[i], y[i], 1e-9);
+
+    vector<double> slope = SavitzkyGolayFilter(5, 2, 1, 0.1).apply(y);
+    for (size_t i = 0; i < y.size(); ++i) CHECK_NEAR(slope[i], -1 + 0.5 * x[i], 1e-9);
+
+    // the centre weights of the classic 5-point quadratic smoother
+    SavitzkyGolayFilter classicFilter(2, 2);
+    const vector<double>& w = classicFilter.weights(2);
+    double classic[] = {-3, 12, 17, 12, -3};
+    for (int j = 0; j < 5; ++j) CHECK_NEAR(w[size_t(j)] * 35, classic[j], 1e-12);
+}
+
+// ---- server and result cache ----
+
+// the numbers of an "ok ..." reply, or nothing for an error
+vector<double> replyValues(const string& reply) {
+    vector<double> values;
+    if (reply.compare(0, 3, "ok ") != 0) return values;
+    const char* p = reply.c_str() + 3;
+    char* end;
+    for (double v = strtod(p, &end); end != p; v = strtod(p, &end)) {
+        values.push_back(v);
+        p = end;
+    }
+    return values;
+}
+
+void solverServer() {
+    SolverServer server;
+    CHECK(server.handle("ping") == "ok pong");
+    vector<double> root = replyValues(server.handle("root \"x^2 - 2\" 0 2"));
+    CHECK(!root.empty() && fabs(root[0] - kSqrt2) < 1e-12);
+    // '=' inside an expression does not make it a setting
+    vector<double> equal = replyValues(server.handle("root \"x==1 ? 0 : x - 1\" 0 2"));
+    CHECK(!equal.empty() && fabs(equal[0] - 1) < 1e-12);
+    vector<double> itp = replyValues(server.handle("root x^2-2 0 2 method=itp xtol=1e-14"));
+    CHECK(!itp.empty() && fabs(itp[0] - kSqrt2) < 1e-14);
+    vector<double> line = replyValues(server.handle("fit 1 0,1,2 1,3,5"));
+    CHECK(line.size() == 2 && fabs(line[0] - 1) < 1e-12 && fabs(line[1] - 2) < 1e-12);
+    vector<double> middle = replyValues(server.handle("interpolate 0,1,2 0,1,4 1.5"));
+    CHECK(middle.size() == 1 && fabs(middle[0] - 2.25) < 1e-12);
+    CHECK(server.handle("nonsense").compare(0, 4, "err ") == 0);
+    CHECK(server.handle("root \"x^2 + 1\" 0 2").compare(0, 4, "err ") == 0);
+    CHECK(server.errors() == 2);
+}
+
+#ifndef _WIN32
+
+int connectTo(const string& path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) == 0) return fd;
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+// everything the server sends until it closes the connection
+string readToEnd(int fd) {
+    string text;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof buffer)) > 0) text.append(buffer, size_t(n));
+    return text;
+}
+
+void socketServer() {
+    string path = temporaryPath("server.sock");
+    SolverServer server;
+    thread serving([&] { server.serveUnixSocket(path, 1); });
+    int idle = -1;
+    for (int tries = 0; tries < 500 && idle < 0; ++tries) {
+        idle = connectTo(path);
+        if (idle < 0) this_thread::sleep_for(chrono::milliseconds(2));
+    }
+    CHECK(idle >= 0);
+
+    // one worker and an idle connection: another client is still answered,
+    // and its replies keep their order
+    int client = connectTo(path);
+    string requests = "ping\nroot x-1 0 2\nping\n";
+    CHECK(write(client, requests.data(), requests.size()) == ssize_t(requests.size()));
+    shutdown(client, SHUT_WR);
+    string replies = readToEnd(client);
+    close(client);
+    CHECK(replies.compare(0, 8, "ok pong\n") == 0);
+    CHECK(replies.size() > 16 && replies.compare(replies.size() - 8, 8, "ok pong\n") == 0);
+
+    // a line without end: the requests before it are answered, then an error
+    client = connectTo(path);
+    string flood = "ping\n" + string((size_t(1) << 20) + 1, 'x');
+    size_t sent = 0;
+    while (sent < flood.size()) {
+        ssize_t n = send(client, flood.data() + sent, flood.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += size_t(n);
+    }
+    replies = readToEnd(client);
+    close(client);
+    CHECK(replies.compare(0, 12, "ok pong\nerr ") == 0);
+
+    server.stop();
+    serving.join();
+    close(idle);
+}
+
+#endif
+
+void resultCache() {
+    string path = temporaryPath("results.bin");
+    filesystem::remove(path);
+    {
+        ResultCache cache(path);
+        ResultKey key("unit.test");
+        key.addExpression("x^2 + 1").add(0.5);
+        vector<double> values;
+        CHECK(!cache.lookup(key, values));
+        cache.store(key, {1, 2, 3});
+        CHECK(cache.lookup(key, values) && values == vector<double>({1, 2, 3}));
+
+        // blanks that do not change the tokens give the same key
+        ResultKey spaced("unit.test");
+        spaced.addExpression("x ^ 2 + 1").add(0.5);
+        CHECK(spaced.high() == key.high() && spaced.low() == key.low());
+        ResultKey other("unit.test");
+        other.addExpression("x^2 + 1").add(0.25);
+        CHECK(other.low() != key.low());
+    }
+    {
+        // persisted, and served to the solvers through the global instance
+        auto cache = make_shared<ResultCache>(path);
+        vector<double> values;
+        ResultKey key("unit.test");
+        key.addExpression("x^2+1").add(0.5);
+        CHECK(cache->lookup(key, values) && values.size() == 3);
+
+        ResultCache::setGlobal(cache);
+        RootResult first = brentRoot("x^3 - 2*x - 5", 2, 3);
+        RootResult second = brentRoot("x^3 - 2*x - 5", 2, 3);
+        NumericalIntegrator integrator("x^2", 0, 1, 3);
+        double fresh = integrator.simpsons13Rule(), cached = integrator.simpsons13Rule();
+        // a record of the wrong length under a rule's key is recomputed
+        ResultKey foreign("integrate.simpson13");
+        foreign.addExpression("x^3").add(0.0).add(1.0).add(3.0);
+        cache->store(foreign, {});
+        double quarter = NumericalIntegrator("x^3", 0, 1, 3).simpsons13Rule();
+        bool endPointChecked = false;
+        try {
+            NumericalIntegrator("1/x", 0, 1, 3);
+        } catch (const exception&) {
+            endPointChecked = true;
+        }
+        ResultCache::setGlobal(nullptr);
+        CHECK(first.root == second.root && first.iterations == second.iterations);
+        CHECK_NEAR(second.root, kCubicRoot, 1e-12);
+        CHECK(fresh == cached);
+        CHECK_NEAR(quarter, 0.25, 1e-15);
+        CHECK(endPointChecked);
+        CHECK(cache->stats().hits >= 3);
+        CHECK(cache->stats().hitRate() > 0.5);
+    }
+    filesystem::remove(path);
+}
+
+// Last: defining a user function turns the expression result cache off for
+// the rest of the process
+void userFunctions() {
+    EquationParser::defineFunction("ramp", {"t"}, "t > 0 ? t : 0");
+    CHECK(EquationParser::isUserFunction("ramp"));
+    EquationParser parser;
+    parser.parseEquation("ramp(x - 1) * 2");
+    CHECK_NEAR(parser.evaluate(3), 4, 0);
+    CHECK_NEAR(parser.evaluate(-3), 0, 0);
+    CHECK_NEAR(brentRoot("ramp(x) - 0.5", -1, 2).root, 0.5, 1e-12);
+    CHECK(!ResultCache::globalForExpressions());
+}
+
+struct Test {
+    const char* name;
+    void (*run)();
+};
+
+const Test kTests[] = {
+    {"inverse_interpolation", inverseInterpolation},
+    {"polynomial_fit", polynomialFit},
+    {"streaming_fit", streamingFit},
+    {"robust_and_surface_fit", robustAndSurfaceFit},
+    {"bracketed_roots", bracketedRoots},
+    {"root_scan", rootScan},
+    {"batch_roots", batchRoots},
+    {"polynomial_roots", polynomialRootFinding},
+    {"nonlinear_system", nonlinearSystem},
+    {"parser_precedence", parserPrecedence},
+    {"expression_cache", expressionCache},
+    {"extended_precision", extendedPrecision},
+    {"intervals", intervals},
+    {"integration_rules", integrationRules},
+    {"double_exponential", doubleExponential},
+    {"euler_ensemble", eulerEnsemble},
+    {"data_sources", dataSources},
+    {"savitzky_golay", savitzkyGolay},
+    {"solver_server", solverServer},
+#ifndef _WIN32
+    {"socket_server", socketServer},
+#endif
+    {"result_cache", resultCache},
+    {"user_functions", userFunctions},
+};
+
+}
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : "";
+    int run = 0;
+    for (const Test& test : kTests) {
+        if (!strstr(test.name, filter)) continue;
+        int before = failures;
+        try {
+            test.run();
+        } catch (const exception& e) {
+            fail(__FILE__, __LINE__, string("uncaught exception: ") + e.what());
+        }
+        printf("%-24s %s\n", test.name, failures == before ? "ok" : "FAILED");
+        ++run;
+    }
+    printf("%d tests, %d failed checks\n", run, failures);
+    return failures == 0 ? 0 : 1;
+}